@@ -46,7 +46,7 @@ void CWaveFileHeader::Set( ULONG SamplingRate, USHORT BitsPerSample, USHORT Chan
 {
     // Set Riff-Chunk
     CopyMemory( m_Riff_ID, "RIFF", 4 );
-    m_Riff_Size = DataSize + 44;
+    m_Riff_Size = DataSize + 36;
     CopyMemory( m_Riff_Type, "WAVE", 4 );
 
     // Set Fmt-Chunk
@@ -14,6 +14,31 @@
 #define CD_BLOCKS_PER_SECOND    75
 #define IOCTL_CDROM_RAW_READ    0x2403E
 #define IOCTL_CDROM_READ_TOC    0x24000
+#define IOCTL_CDROM_READ_TOC_EX 0x24054
+#define IOCTL_CDROM_GET_LAST_SESSION 0x24038
+#define CDROM_READ_TOC_EX_FORMAT_CDTEXT 0x05
+#define CDTEXT_MAX_SIZE         (4 + 8 * 256 * 18)
+#define IOCTL_SCSI_PASS_THROUGH_DIRECT 0x4D014
+#define SCSI_IOCTL_DATA_OUT     0
+#define SCSI_IOCTL_DATA_IN      1
+#define SCSI_TIMEOUT            30          // seconds
+#define C2_POINTER_SIZE         294         // one bit per audio byte
+#define C2_SECTOR_SIZE          (RAW_SECTOR_SIZE + C2_POINTER_SIZE)
+#define C2_RETRIES              8           // re-reads of a sector flagged by C2
+#define C2_RETRY_SPEED          706         // kB/s (4x) used for re-reads
+#define CD_SPEED_MAX            0xFFFF      // SET CD SPEED: fastest possible
+#define CD_SPEED_X(x)           ((x) * 1764 / 10)   // kB/s of speed factor x
+#define SPEED_UP_CHUNKS         500         // clean chunks before stepping up again
+#define SECURE_RETRIES          8           // re-reads of a block which failed verification
+#define RECOVER_CHUNK_RETRIES   3           // retries of a failed chunk before going sector wise
+#define RECOVER_SECTOR_RETRIES  4           // retries of a single failed sector
+#define RECOVER_BACKOFF_MS      50          // first retry delay (doubled each retry)
+#define RECOVER_SPEED           706         // kB/s (4x) for sector wise recovery
+#define RECOVER_BUDGET_READS    400         // recovery reads per track
+#define RECOVER_BUDGET_MS       120000      // recovery time per track
+#define AUDIO_PRE_EMPHASIS      0x1         // TOC control: audio with pre-emphasis
+#define AUDIO_DATA_TRACK        0x4         // TOC control: data track
+#define SESSION_GAP_SECTORS     11400       // lead-out, lead-in and pre-gap between sessions
 
 
 // These structures are defined somewhere in the windows-api, but I did
@@ -36,6 +61,49 @@ typedef struct _CDROM_TOC
     TRACK_DATA TrackData[MAXIMUM_NUMBER_TRACKS];
 } CDROM_TOC;
 
+typedef struct _CDROM_TOC_SESSION_DATA
+{
+    UCHAR Length[2];
+    UCHAR FirstCompleteSession;
+    UCHAR LastCompleteSession;
+    TRACK_DATA TrackData[1];    // first track of last session
+} CDROM_TOC_SESSION_DATA;
+
+typedef struct _CDROM_READ_TOC_EX
+{
+    UCHAR Format : 4;
+    UCHAR Reserved1 : 3;
+    UCHAR Msf : 1;
+    UCHAR SessionTrack;
+    UCHAR Reserved2;
+    UCHAR Reserved3;
+} CDROM_READ_TOC_EX;
+
+// SCSI pass through (MMC commands like READ CD / SET CD SPEED)
+typedef struct _SCSI_PASS_THROUGH_DIRECT
+{
+    USHORT Length;
+    UCHAR  ScsiStatus;
+    UCHAR  PathId;
+    UCHAR  TargetId;
+    UCHAR  Lun;
+    UCHAR  CdbLength;
+    UCHAR  SenseInfoLength;
+    UCHAR  DataIn;
+    ULONG  DataTransferLength;
+    ULONG  TimeOutValue;
+    PVOID  DataBuffer;
+    ULONG  SenseInfoOffset;
+    UCHAR  Cdb[16];
+} SCSI_PASS_THROUGH_DIRECT;
+
+typedef struct _SCSI_PASS_THROUGH_DIRECT_SENSE
+{
+    SCSI_PASS_THROUGH_DIRECT Sptd;
+    ULONG Filler;
+    UCHAR Sense[32];
+} SCSI_PASS_THROUGH_DIRECT_SENSE;
+
 typedef enum _TRACK_MODE_TYPE
 {
     YellowMode2,
@@ -0,0 +1,263 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CAccurateRip.h"
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AR_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AR_NEON
+#endif
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    //! @brief      sum up sample * position (position starts at mult);
+    //!             low and high words of the 64 bit products are summed
+    //!             separately (v1 = lo, v2 = lo + hi)
+    //!
+    //! @param[in]     p     samples (little endian, 4 bytes each)
+    //! @param[in]     n     number of samples
+    //! @param[in]     mult  position of first sample (1 based)
+    //! @param[in,out] lo    sum of low words
+    //! @param[in,out] hi    sum of high words
+    //--------------------------------------------------------------------------
+    void arKernel(const uint8_t* p, size_t n, uint32_t mult, uint32_t& lo, uint32_t& hi)
+    {
+        size_t i = 0;
+
+#if defined(AR_SSE2)
+        // lanes 0 / 2 collect low words, lanes 1 / 3 high words
+        __m128i acc  = _mm_setzero_si128();
+        __m128i pos  = _mm_set_epi32(mult + 3, mult + 2, mult + 1, mult);
+        __m128i four = _mm_set1_epi32(4);
+
+        for (; (i + 4) <= n; i += 4)
+        {
+            __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4));
+            __m128i pe = _mm_mul_epu32(v, pos);
+            __m128i po = _mm_mul_epu32(_mm_srli_epi64(v, 32), _mm_srli_epi64(pos, 32));
+            acc = _mm_add_epi32(acc, pe);
+            acc = _mm_add_epi32(acc, po);
+            pos = _mm_add_epi32(pos, four);
+        }
+
+        uint32_t a[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a), acc);
+        lo   += a[0] + a[2];
+        hi   += a[1] + a[3];
+        mult += static_cast<uint32_t>(i);
+#elif defined(AR_NEON)
+        uint32x4_t acc  = vdupq_n_u32(0);
+        uint32_t   init[4] = {mult, mult + 1, mult + 2, mult + 3};
+        uint32x4_t pos  = vld1q_u32(init);
+        uint32x4_t four = vdupq_n_u32(4);
+
+        for (; (i + 4) <= n; i += 4)
+        {
+            uint32x4_t v  = vreinterpretq_u32_u8(vld1q_u8(p + i * 4));
+            uint64x2_t pl = vmull_u32(vget_low_u32(v), vget_low_u32(pos));
+            uint64x2_t ph = vmull_u32(vget_high_u32(v), vget_high_u32(pos));
+            acc = vaddq_u32(acc, vreinterpretq_u32_u64(pl));
+            acc = vaddq_u32(acc, vreinterpretq_u32_u64(ph));
+            pos = vaddq_u32(pos, four);
+        }
+
+        uint32_t a[4];
+        vst1q_u32(a, acc);
+        lo   += a[0] + a[2];
+        hi   += a[1] + a[3];
+        mult += static_cast<uint32_t>(i);
+#endif
+
+        for (; i < n; i++, mult++)
+        {
+            uint32_t s;
+            memcpy(&s, p + i * 4, 4);
+            uint64_t c = static_cast<uint64_t>(s) * mult;
+            lo += static_cast<uint32_t>(c);
+            hi += static_cast<uint32_t>(c >> 32);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      read little endian 32 bit value
+    //--------------------------------------------------------------------------
+    uint32_t le32(const std::string& d, size_t pos)
+    {
+        return  static_cast<uint32_t>(static_cast<uint8_t>(d[pos]))
+             | (static_cast<uint32_t>(static_cast<uint8_t>(d[pos + 1])) << 8)
+             | (static_cast<uint32_t>(static_cast<uint8_t>(d[pos + 2])) << 16)
+             | (static_cast<uint32_t>(static_cast<uint8_t>(d[pos + 3])) << 24);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      start a new track
+//!
+//! @param[in]  sectors  track length in sectors
+//! @param[in]  first    first (audio) track of disc
+//! @param[in]  last     last (audio) track of disc
+//------------------------------------------------------------------------------
+void CAccurateRip::start(uint32_t sectors, bool first, bool last)
+{
+    uint64_t samples = static_cast<uint64_t>(sectors) * SAMPLES_PER_SECTOR;
+    uint64_t skip    = 5 * SAMPLES_PER_SECTOR;
+
+    mPos   = 0;
+    mFrom  = first ? (skip - 1) : 0;
+    mTo    = last  ? ((samples > skip) ? (samples - skip) : 0) : samples;
+    mSumLo = 0;
+    mSumHi = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      add track data (multiple of 4 bytes, in track order)
+//!
+//! @param[in]  data   raw CD audio
+//! @param[in]  bytes  size of data in bytes
+//------------------------------------------------------------------------------
+void CAccurateRip::update(const void* data, size_t bytes)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t n    = bytes / 4;
+    uint64_t from = (mPos > mFrom) ? mPos : mFrom;
+    uint64_t to   = ((mPos + n) < mTo) ? (mPos + n) : mTo;
+
+    if (from < to)
+    {
+        arKernel(p + (from - mPos) * 4, to - from, static_cast<uint32_t>(from + 1), mSumLo, mSumHi);
+    }
+
+    mPos += n;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      name of database file for a disc (a/b/c/dBAR-...bin)
+//!
+//! @param[in]  offsets  LBA of all audio tracks followed by lead-out
+//! @param[in]  cddbId   CDDB disc id
+//!
+//! @return     relative path of database file
+//------------------------------------------------------------------------------
+std::string CAccurateRip::dbFileName(const std::vector<uint32_t>& offsets, uint32_t cddbId)
+{
+    uint32_t id1 = 0, id2 = 0;
+    char     name[64];
+
+    if (offsets.size() < 2)
+    {
+        return "";
+    }
+
+    for (size_t i = 0; i < offsets.size(); i++)
+    {
+        id1 += offsets[i];
+        id2 += ((offsets[i] > 0) ? offsets[i] : 1) * static_cast<uint32_t>(i + 1);
+    }
+
+    snprintf(name, sizeof(name), "%x/%x/%x/dBAR-%03u-%08x-%08x-%08x.bin",
+             id1 & 0xf, (id1 >> 4) & 0xf, (id1 >> 8) & 0xf,
+             static_cast<unsigned>(offsets.size() - 1), id1, id2, cddbId);
+
+    return name;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      parse AccurateRip database file (dBAR format)
+//!
+//! @param[in]  data        file content
+//! @param[in]  trackCount  number of tracks on disc
+//! @param[out] tracks      all entries per track (index 0 is track 1)
+//!
+//! @return     true if at least one response for this disc was found
+//------------------------------------------------------------------------------
+bool CAccurateRip::parseDb(const std::string& data, uint32_t trackCount, std::vector<std::vector<SArTrack>>& tracks)
+{
+    // response: count (1), disc id 1 (4), disc id 2 (4), cddb id (4),
+    // followed by count * [confidence (1), crc (4), crc450 (4)]
+    size_t pos   = 0;
+    bool   found = false;
+
+    tracks.assign(trackCount, {});
+
+    while ((pos + 13) <= data.size())
+    {
+        uint32_t count = static_cast<uint8_t>(data[pos]);
+        pos += 13;
+
+        if ((pos + count * 9) > data.size())
+        {
+            break;
+        }
+
+        if (count == trackCount)
+        {
+            for (uint32_t t = 0; t < count; t++, pos += 9)
+            {
+                SArTrack e;
+                e.mConfidence = static_cast<uint8_t>(data[pos]);
+                e.mCrc        = le32(data, pos + 1);
+                e.mCrc450     = le32(data, pos + 5);
+                tracks[t].push_back(e);
+            }
+            found = true;
+        }
+        else
+        {
+            pos += count * 9;
+        }
+    }
+
+    return found;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      match checksums of a track against database entries
+//!
+//! @param[in]  entries  database entries of this track
+//! @param[in]  v1       v1 CRC of ripped track
+//! @param[in]  v2       v2 CRC of ripped track
+//!
+//! @return     match result
+//------------------------------------------------------------------------------
+SArResult CAccurateRip::match(const std::vector<SArTrack>& entries, uint32_t v1, uint32_t v2)
+{
+    SArResult res;
+
+    for (const auto& e : entries)
+    {
+        // empty slots of other pressings have crc 0
+        if (e.mCrc == 0)
+        {
+            continue;
+        }
+
+        res.mFound = true;
+
+        if ((e.mCrc == v2) || (e.mCrc == v1))
+        {
+            res.mV2          = res.mV2 || (e.mCrc == v2);
+            res.mConfidence += e.mConfidence;
+        }
+    }
+
+    return res;
+}
@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// one track entry of an AccurateRip database response
+struct SArTrack
+{
+    uint8_t  mConfidence = 0;  ///< number of submissions
+    uint32_t mCrc        = 0;  ///< track CRC (v1 or v2)
+    uint32_t mCrc450     = 0;  ///< CRC of frame 450 (offset detection)
+};
+
+/// AccurateRip result of one track
+struct SArResult
+{
+    bool     mFound      = false;  ///< track is in database
+    bool     mV2         = false;  ///< v2 CRC matched
+    int      mConfidence = 0;      ///< confidence of match; 0 -> no match
+};
+
+//------------------------------------------------------------------------------
+//! @brief      Streaming AccurateRip v1 / v2 checksum of one track.
+//!
+//! Data is fed sector wise while the track is ripped. The 5 sectors
+//! (minus one sample) at the start of the first track and the 5 sectors at
+//! the end of the last track are excluded as the AccurateRip rules say.
+//! The kernel uses SSE2 or NEON where available.
+//------------------------------------------------------------------------------
+class CAccurateRip
+{
+public:
+    /// samples (stereo, 16 bit) per CD sector
+    static constexpr uint32_t SAMPLES_PER_SECTOR = 588;
+
+    //--------------------------------------------------------------------------
+    //! @brief      start a new track
+    //!
+    //! @param[in]  sectors  track length in sectors
+    //! @param[in]  first    first (audio) track of disc
+    //! @param[in]  last     last (audio) track of disc
+    //--------------------------------------------------------------------------
+    void start(uint32_t sectors, bool first, bool last);
+
+    //--------------------------------------------------------------------------
+    //! @brief      add track data (multiple of 4 bytes, in track order)
+    //!
+    //! @param[in]  data   raw CD audio
+    //! @param[in]  bytes  size of data in bytes
+    //--------------------------------------------------------------------------
+    void update(const void* data, size_t bytes);
+
+    //! AccurateRip v1 CRC
+    uint32_t v1() const { return mSumLo; }
+
+    //! AccurateRip v2 CRC
+    uint32_t v2() const { return mSumLo + mSumHi; }
+
+    //--------------------------------------------------------------------------
+    //! @brief      name of database file for a disc (a/b/c/dBAR-...bin)
+    //!
+    //! @param[in]  offsets  LBA of all audio tracks followed by lead-out
+    //! @param[in]  cddbId   CDDB disc id
+    //!
+    //! @return     relative path of database file
+    //--------------------------------------------------------------------------
+    static std::string dbFileName(const std::vector<uint32_t>& offsets, uint32_t cddbId);
+
+    //--------------------------------------------------------------------------
+    //! @brief      parse AccurateRip database file (dBAR format)
+    //!
+    //! @param[in]  data        file content
+    //! @param[in]  trackCount  number of tracks on disc
+    //! @param[out] tracks      all entries per track (index 0 is track 1)
+    //!
+    //! @return     true if at least one response for this disc was found
+    //--------------------------------------------------------------------------
+    static bool parseDb(const std::string& data, uint32_t trackCount, std::vector<std::vector<SArTrack>>& tracks);
+
+    //--------------------------------------------------------------------------
+    //! @brief      match checksums of a track against database entries
+    //!
+    //! @param[in]  entries  database entries of this track
+    //! @param[in]  v1       v1 CRC of ripped track
+    //! @param[in]  v2       v2 CRC of ripped track
+    //!
+    //! @return     match result
+    //--------------------------------------------------------------------------
+    static SArResult match(const std::vector<SArTrack>& entries, uint32_t v1, uint32_t v2);
+
+private:
+    uint64_t mPos   = 0;  ///< sample index of next data
+    uint64_t mFrom  = 0;  ///< first sample index to check
+    uint64_t mTo    = 0;  ///< first sample index not to check
+    uint32_t mSumLo = 0;  ///< sum of low words of sample * position
+    uint32_t mSumHi = 0;  ///< sum of high words of sample * position
+};
@@ -9,9 +9,30 @@
 
 #include "CAudioCD.h"
 #include "AudioCD_Helpers.h"
+#include "cdtext.h"
+#include "progress.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
+#include <cstddef>
+#include <algorithm>
+
+
+
+// Hash of a block of audio data (FNV-1a on 64 bit words), used to
+//   compare copy and verify pass in secure mode
+static ULONGLONG BlockHash( const char* pData, ULONG Size )
+{
+    ULONGLONG Hash = 14695981039346656037ULL;
+    for ( ULONG i = 0; (i + 8) <= Size; i += 8 )
+    {
+        ULONGLONG Word;
+        CopyMemory( &Word, pData + i, 8 );
+        Hash ^= Word;
+        Hash *= 1099511628211ULL;
+    }
+    return Hash;
+}
 
 
 
@@ -19,6 +40,19 @@
 CAudioCD::CAudioCD( char Drive , std::ostream& os) : mOs(os)
 {
     m_hCD = NULL;
+    m_bC2 = FALSE;
+    m_bSecure = FALSE;
+    m_ReadSpeed = CD_SPEED_MAX;
+    m_SilThreshold = 0;
+    m_SilMinFrames = 44100;
+    m_bTrimSilence = FALSE;
+    m_bLoudness = FALSE;
+    m_bDeEmphasis = TRUE;
+    m_ReadOffset = 0;
+    m_MaxSpeed = 0;
+    m_DriveSpeed = 0;
+    m_SpeedLevel = m_TopLevel = 0;
+    m_CleanChunks = 0;
 
     if ( Drive != '\0' )
         Open( Drive );
@@ -40,7 +74,9 @@ BOOL CAudioCD::Open( char Drive )
 
     // Open drive-handle
     char Fn[] = { '\\', '\\', '.', '\\', Drive, ':', '\0' };
-    if ( INVALID_HANDLE_VALUE == ( m_hCD = CreateFile( Fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL ) ) )
+    // SCSI pass through needs write access, raw reads work without
+    if ( INVALID_HANDLE_VALUE == ( m_hCD = CreateFile( Fn, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL ) )
+      && INVALID_HANDLE_VALUE == ( m_hCD = CreateFile( Fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL ) ) )
     {
         m_hCD = NULL;
         return FALSE;
@@ -65,14 +101,58 @@ BOOL CAudioCD::Open( char Drive )
         m_hCD = NULL;
         return FALSE;
     }
+    // first track of the last session; -1 -> unknown
+    int LastSession = -1;
+    CDROM_TOC_SESSION_DATA Session;
+    if ( DeviceIoControl( m_hCD, IOCTL_CDROM_GET_LAST_SESSION, NULL, 0, &Session, sizeof(Session), &BytesRead, NULL ) )
+        LastSession = ( Session.LastCompleteSession > 1 ) ? Session.TrackData[0].TrackNumber : 0;
+
     for ( ULONG i=m_TOC.FirstTrack-1; i<m_TOC.LastTrack; i++ )
     {
+        // data tracks (CD-Extra, mixed mode) aren't ripped
+        if ( m_TOC.TrackData[i].Control & AUDIO_DATA_TRACK )
+            continue;
+
         CDTRACK NewTrack;
+        NewTrack.TocNumber = m_TOC.TrackData[i].TrackNumber;
         NewTrack.Address = AddressToSectors( m_TOC.TrackData[i].Address );
         NewTrack.Length = AddressToSectors( m_TOC.TrackData[i+1].Address ) - NewTrack.Address;
+
+        // audio track in front of a data session (CD-Extra): the session
+        //   gap isn't part of the track. If the drive doesn't tell the
+        //   sessions, a data track at the end is taken as second session.
+        const TRACK_DATA& Next = m_TOC.TrackData[i+1];
+        BOOL NextSession = ( (i + 1) < m_TOC.LastTrack ) && ( Next.Control & AUDIO_DATA_TRACK )
+                        && ( ( LastSession < 0 ) ? ( (i + 2) == m_TOC.LastTrack ) : ( Next.TrackNumber == LastSession ) );
+
+        if ( NextSession && ( NewTrack.Length > SESSION_GAP_SECTORS ) )
+            NewTrack.Length -= SESSION_GAP_SECTORS;
+
+        NewTrack.ArValid = FALSE;
+        NewTrack.ArV1 = NewTrack.ArV2 = 0;
+        NewTrack.C2Retried = NewTrack.C2Bad = 0;
+        NewTrack.SecRetried = NewTrack.SecBad = 0;
+        NewTrack.RipState = RIP_FAILED;
+        NewTrack.Recovered = NewTrack.Unreadable = 0;
+        NewTrack.BudgetReads = 0;
+        NewTrack.BudgetEnd = 0;
+        NewTrack.SilLead = NewTrack.SilTrail = NewTrack.Trimmed = 0;
+        NewTrack.LeadCut = 0;
+        NewTrack.FileFrames = NewTrack.Length * (RAW_SECTOR_SIZE / 4);
+        NewTrack.LoudValid = FALSE;
+        NewTrack.PreEmphasis = ( m_TOC.TrackData[i].Control & AUDIO_PRE_EMPHASIS ) ? TRUE : FALSE;
+        NewTrack.Loudness = CLoudness::SILENCE_LUFS;
+        NewTrack.TruePeak = CLoudness::SILENCE_LUFS;
         m_aTracks.push_back( NewTrack );
     }
 
+    // CD-Text is optional
+    ReadCdText();
+
+    // model, speed and C2 support; use READ CD with C2 error pointers
+    //   if drive supports it
+    ProbeDrive();
+
     // Return if track-count > 0
     return m_aTracks.size() > 0;
 }
@@ -88,6 +168,16 @@ void CAudioCD::Close()
 {
     UnlockCD();
     m_aTracks.clear();
+    m_CdText.clear();
+    m_bC2 = FALSE;
+    m_DriveSpeed = 0;
+    m_Model.clear();
+
+    // leave the drive at full speed
+    if ( m_hCD != NULL && m_ReadSpeed != CD_SPEED_MAX )
+        SetReadSpeed( CD_SPEED_MAX );
+    m_ReadSpeed = CD_SPEED_MAX;
+
     CloseHandle( m_hCD );
     m_hCD = NULL;
 }
@@ -104,6 +194,23 @@ ULONG CAudioCD::GetTrackCount()
 }
 
 
+ULONG CAudioCD::GetTocTrackCount()
+{
+    if ( m_hCD == NULL )
+        return 0;
+    return m_TOC.LastTrack - m_TOC.FirstTrack + 1;
+}
+
+
+std::vector<UINT> CAudioCD::GetTocNumbers()
+{
+    std::vector<UINT> Numbers;
+    for ( const auto& a : m_aTracks )
+        Numbers.push_back( a.TocNumber );
+    return Numbers;
+}
+
+
 ULONG CAudioCD::GetTrackTime( ULONG Track )
 {
     if ( m_hCD == NULL )
@@ -183,57 +290,161 @@ BOOL CAudioCD::ExtractTrack( ULONG TrackNr, LPCTSTR Path )
 
     // HANDLE hFile = CreateFile( Path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
     
+    Track.RipState = RIP_FAILED;
+    Track.Recovered = 0;
+    Track.Unreadable = 0;
+    StartBudget( Track );
+
     HANDLE hFile = CreateFileA( Path, (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL );
     if ( hFile == INVALID_HANDLE_VALUE )
         return FALSE;
 
     CWaveFileHeader WaveFileHeader( 44100, 16, 2, Track.Length*RAW_SECTOR_SIZE );
-    WriteFile( hFile, &WaveFileHeader, sizeof(WaveFileHeader), &Dummy, NULL );
+    if ( !WriteFile( hFile, &WaveFileHeader, sizeof(WaveFileHeader), &Dummy, NULL ) )
+        ret = FALSE;
 
     CBuf<char> Buf( SECTORS_AT_READ * RAW_SECTOR_SIZE );
 
-    RAW_READ_INFO Info;
-    Info.TrackMode = CDDA;
-    Info.SectorCount = SECTORS_AT_READ;
+    Track.C2Retried = 0;
+    Track.C2Bad = 0;
+    Track.BlockHash.clear();
     
     ULONG i=0;
     int percent = 0, perlast = -1;
+
+    // AccurateRip checksum is calculated on the fly
+    CAccurateRip Ar;
+    Ar.start( Track.Length, TrackNr == 0, TrackNr == (m_aTracks.size() - 1) );
+    Track.ArValid = FALSE;
+
+    // silence at start / end is detected on the fly as well
+    CSilenceScan Sil;
+    Sil.start( m_SilThreshold );
+    Track.SilLead = Track.SilTrail = Track.Trimmed = 0;
+    Track.LeadCut = 0;
+
+    // leading silence is held back until the first loud frame arrives: a
+    //   run shorter than m_SilMinFrames is written then, a longer one is
+    //   dropped. Only its start is kept, in case the whole track is silent.
+    BOOL Leading = m_bTrimSilence;
+    ULONG HeldBytes = 0;
+    ULONG KeepBytes = m_SilMinFrames * 4;
+    std::vector<char> Held;
+    ULONG FileBytes = 0;
+
+    if ( KeepBytes < RAW_SECTOR_SIZE )
+        KeepBytes = RAW_SECTOR_SIZE;
+
+    auto Put = [&]( const char* pData, ULONG Size ) -> BOOL
+    {
+        if ( Leading )
+        {
+            if ( Sil.allSilent() )
+            {
+                ULONG Keep = ( Held.size() < KeepBytes ) ? ( KeepBytes - Held.size() ) : 0;
+                Keep = ( Keep < Size ) ? Keep : Size;
+                Held.insert( Held.end(), pData, pData + Keep );
+                HeldBytes += Size;
+                return TRUE;
+            }
+
+            Leading = FALSE;
+            ULONG Lead = static_cast<ULONG>( Sil.leading() );
+
+            if ( Lead >= m_SilMinFrames )
+            {
+                // skip the silent start of this chunk as well
+                Track.LeadCut = Lead;
+                pData += Lead * 4 - HeldBytes;
+                Size  -= Lead * 4 - HeldBytes;
+            }
+            else if ( !Held.empty() )
+            {
+                if ( !WriteFile( hFile, Held.data(), Held.size(), &Dummy, NULL ) )
+                    return FALSE;
+                FileBytes += Held.size();
+            }
+            Held.clear();
+        }
+
+        FileBytes += Size;
+        return WriteFile( hFile, pData, Size, &Dummy, NULL );
+    };
+
+    // ... and so is loudness (if wanted)
+    CLoudness Loud;
+    Track.LoudValid = FALSE;
+    Track.LoudBlocks.clear();
+
+    // pre-emphasis is removed from the data written (checksums and block
+    //   hashes are taken from the data as read from disc)
+    CDeEmphasis Emph;
+    BOOL DeEmph = m_bDeEmphasis && Track.PreEmphasis;
+
+    SProgress Prog;
+    Prog.mStage = "rip";
+    Prog.mTrack = TrackNr + 1;
+    Prog.mTotal = static_cast<uint64_t>(Track.Length) * RAW_SECTOR_SIZE;
     
-    for ( i=0; i<Track.Length/SECTORS_AT_READ; i++ )
+    for ( i=0; (i<Track.Length/SECTORS_AT_READ) && ret; i++ )
     {
         percent = logRipPercent(Track.Length/SECTORS_AT_READ, i);
         
         if (percent != perlast)
         {
-            perlast = percent;
-            mOs << percent << "% of track #" << TrackNr + 1 << " ripped!\r" << std::flush;
+            perlast    = percent;
+            Prog.mDone = static_cast<uint64_t>(i) * SECTORS_AT_READ * RAW_SECTOR_SIZE;
+            Prog.mTs   = progressTs();
+            mOs << progressRecord(Prog) << std::flush;
         }
         
-        Info.DiskOffset.QuadPart = (Track.Address + i*SECTORS_AT_READ) * CD_SECTOR_SIZE;
-        if ( DeviceIoControl( m_hCD, IOCTL_CDROM_RAW_READ, &Info, sizeof(Info), Buf, SECTORS_AT_READ*RAW_SECTOR_SIZE, &Dummy, NULL ) )
+        ULONG Lba = Track.Address + i*SECTORS_AT_READ;
+        ULONG Trouble = Track.C2Retried + Track.Recovered + Track.Unreadable;
+        BOOL Read = ReadAudio( Lba, SECTORS_AT_READ, Buf, Track );
+
+        // zone wise speed profile
+        UpdateSpeed( Read && (Trouble == Track.C2Retried + Track.Recovered + Track.Unreadable) );
+
+        if ( Read )
         {
-            WriteFile( hFile, Buf, Buf.Size(), &Dummy, NULL );
+            Ar.update( Buf, Buf.Size() );
+            if ( m_bSecure )
+                Track.BlockHash.push_back( BlockHash( Buf, Buf.Size() ) );
+            if ( DeEmph )
+                Emph.process( Buf, Buf.Size() );
+
+            Sil.update( Buf, Buf.Size() );
+            if ( m_bLoudness )
+                Loud.update( Buf, Buf.Size() );
+            ret = Put( Buf, Buf.Size() );
         }
         else
         {
             std::cerr << "Error while reading CD Audio: " << GetLastError() << std::endl;
             ret = FALSE;
-            break;
         }
     }
 
     if (ret)
     {
-        Info.SectorCount = Track.Length % SECTORS_AT_READ;
+        ULONG Rest = Track.Length % SECTORS_AT_READ;
         
         // not yet all read?
-        if (Info.SectorCount)
+        if (Rest)
         {
-            Info.DiskOffset.QuadPart = (Track.Address + i*SECTORS_AT_READ) * CD_SECTOR_SIZE;
-            if (DeviceIoControl( m_hCD, IOCTL_CDROM_RAW_READ, &Info, sizeof(Info), Buf, Info.SectorCount*RAW_SECTOR_SIZE, &Dummy, NULL ) )
+            ULONG Lba = Track.Address + i*SECTORS_AT_READ;
+            if ( ReadAudio( Lba, Rest, Buf, Track ) )
             {
-                mOs << 100 << "% of track #" << TrackNr + 1 << " ripped!" << std::endl;
-                WriteFile( hFile, Buf, Info.SectorCount*RAW_SECTOR_SIZE, &Dummy, NULL );
+                Ar.update( Buf, Rest*RAW_SECTOR_SIZE );
+                if ( m_bSecure )
+                    Track.BlockHash.push_back( BlockHash( Buf, Rest*RAW_SECTOR_SIZE ) );
+                if ( DeEmph )
+                    Emph.process( Buf, Rest*RAW_SECTOR_SIZE );
+
+                Sil.update( Buf, Rest*RAW_SECTOR_SIZE );
+                if ( m_bLoudness )
+                    Loud.update( Buf, Rest*RAW_SECTOR_SIZE );
+                ret = Put( Buf, Rest*RAW_SECTOR_SIZE );
             }
             else
             {
@@ -243,9 +454,794 @@ BOOL CAudioCD::ExtractTrack( ULONG TrackNr, LPCTSTR Path )
         }
     }
 
-    return CloseHandle( hFile );
+    // all silent: what was kept is the track
+    if ( ret && Leading && !Held.empty() )
+    {
+        ret = WriteFile( hFile, Held.data(), Held.size(), &Dummy, NULL );
+        FileBytes += Held.size();
+    }
+
+    // header was written for the whole track
+    if ( ret && ( FileBytes != Track.Length * RAW_SECTOR_SIZE ) )
+    {
+        CWaveFileHeader TrimmedHeader( 44100, 16, 2, FileBytes );
+        SetFilePointer( hFile, 0, NULL, FILE_BEGIN );
+        ret = WriteFile( hFile, &TrimmedHeader, sizeof(TrimmedHeader), &Dummy, NULL );
+    }
+
+    if (ret)
+    {
+        Track.ArValid = TRUE;
+        Track.ArV1    = Ar.v1();
+        Track.ArV2    = Ar.v2();
+        Track.SilLead = static_cast<ULONG>( Sil.leading() );
+        Track.SilTrail= static_cast<ULONG>( Sil.allSilent() ? 0 : Sil.trailing() );
+        Track.FileFrames = FileBytes / 4;
+        Track.Trimmed = Track.Length * (RAW_SECTOR_SIZE / 4) - Track.FileFrames;
+        StoreLoudness( Track, Loud );
+
+        Prog.mDone = Prog.mTotal;
+        Prog.mTs   = progressTs();
+        mOs << progressRecord(Prog) << std::flush;
+    }
+
+    // a truncated file must not look like a good one
+    ret = CloseHandle( hFile ) && ret;
+    Track.RipState = !ret ? RIP_FAILED : ( Track.Unreadable ? RIP_PARTIAL : RIP_OK );
+
+    return ret;
+}
+
+void CAudioCD::SetSecure( BOOL Secure )
+{
+    m_bSecure = Secure;
+}
+
+
+BOOL CAudioCD::VerifyTrack( ULONG TrackNr, LPCTSTR Path )
+{
+    if ( m_hCD == NULL )
+        return FALSE;
+
+    if ( TrackNr >= m_aTracks.size() )
+        return FALSE;
+    CDTRACK& Track = m_aTracks.at(TrackNr);
+
+    ULONG Blocks = ( Track.Length + SECTORS_AT_READ - 1 ) / SECTORS_AT_READ;
+    if ( Track.BlockHash.size() != Blocks )
+        return FALSE;
+
+    HANDLE hFile = CreateFileA( Path, GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_TEMPORARY, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE )
+        return FALSE;
+
+    CBuf<char> Buf( SECTORS_AT_READ * RAW_SECTOR_SIZE );
+    BOOL ret = TRUE;
+    ULONG Dummy;
+
+    Track.SecRetried = 0;
+    Track.SecBad = 0;
+    StartBudget( Track );
+
+    // the verified data is what counts
+    Track.Recovered = 0;
+    Track.Unreadable = 0;
+
+    // checksum and silence over the final data
+    CAccurateRip Ar;
+    Ar.start( Track.Length, TrackNr == 0, TrackNr == (m_aTracks.size() - 1) );
+    CSilenceScan Sil;
+    Sil.start( m_SilThreshold );
+    CLoudness Loud;
+
+    // the filter state runs through patched blocks -> a patched block and
+    //   the one behind it are written again
+    CDeEmphasis Emph;
+    BOOL DeEmph = m_bDeEmphasis && Track.PreEmphasis;
+    BOOL Patched = FALSE;
+
+    // re-reads go here, so a failed read can't spoil the last good data
+    CBuf<char> Retry( SECTORS_AT_READ * RAW_SECTOR_SIZE );
+
+    SProgress Prog;
+    Prog.mStage = "verify";
+    Prog.mTrack = TrackNr + 1;
+    Prog.mTotal = static_cast<uint64_t>(Track.Length) * RAW_SECTOR_SIZE;
+    int percent = 0, perlast = -1;
+
+    // the copy pass is still in the drive cache
+    FlushCache( Track.Address );
+
+    for ( ULONG b = 0; (b < Blocks) && ret; b++ )
+    {
+        ULONG Lba   = Track.Address + b*SECTORS_AT_READ;
+        ULONG Count = ( (b + 1) < Blocks ) ? SECTORS_AT_READ : ( Track.Length - b*SECTORS_AT_READ );
+        ULONG Size  = Count * RAW_SECTOR_SIZE;
+
+        percent = logRipPercent(Blocks, b);
+        if (percent != perlast)
+        {
+            perlast    = percent;
+            Prog.mDone = static_cast<uint64_t>(b) * SECTORS_AT_READ * RAW_SECTOR_SIZE;
+            Prog.mTs   = progressTs();
+            mOs << progressRecord(Prog) << std::flush;
+        }
+
+        if ( !ReadAudio( Lba, Count, Buf, Track ) )
+        {
+            std::cerr << "Error while verifying CD Audio: " << GetLastError() << std::endl;
+            ret = FALSE;
+            break;
+        }
+
+        ULONGLONG Hash = BlockHash( Buf, Size );
+        BOOL Rewrite = DeEmph && Patched;
+        Patched = FALSE;
+
+        if ( Hash != Track.BlockHash[b] )
+        {
+            // re-read until one read matches an earlier one
+            std::vector<ULONGLONG> Seen = { Track.BlockHash[b], Hash };
+            BOOL Match = FALSE;
+            Track.SecRetried++;
+
+            for ( int r = 0; (r < SECURE_RETRIES) && !Match; r++ )
+            {
+                FlushCache( Lba );
+
+                if ( ReadAudio( Lba, Count, Retry, Track, FALSE ) )
+                {
+                    CopyMemory( Buf, Retry, Size );
+                    Hash  = BlockHash( Buf, Size );
+                    Match = std::find( Seen.begin(), Seen.end(), Hash ) != Seen.end();
+                    Seen.push_back( Hash );
+                }
+            }
+
+            // no match: the last complete read is written
+            if ( !Match )
+                Track.SecBad++;
+
+            Patched = Rewrite = TRUE;
+        }
+
+        Ar.update( Buf, Size );
+        if ( DeEmph )
+            Emph.process( Buf, Size );
+
+        if ( Rewrite )
+        {
+            // the file holds track bytes From .. To (silence trimmed while ripping)
+            ULONG Pos  = b*SECTORS_AT_READ*RAW_SECTOR_SIZE;
+            ULONG From = Track.LeadCut * 4;
+            ULONG To   = From + Track.FileFrames * 4;
+            ULONG Beg  = ( Pos > From ) ? Pos : From;
+            ULONG End  = ( (Pos + Size) < To ) ? (Pos + Size) : To;
+
+            if ( Beg < End )
+            {
+                SetFilePointer( hFile, sizeof(CWaveFileHeader) + Beg - From, NULL, FILE_BEGIN );
+                if ( !WriteFile( hFile, Buf + (Beg - Pos), End - Beg, &Dummy, NULL ) )
+                {
+                    ret = FALSE;
+                    break;
+                }
+            }
+        }
+
+        Sil.update( Buf, Size );
+        if ( m_bLoudness )
+            Loud.update( Buf, Size );
+    }
+
+    if (ret)
+    {
+        Track.ArValid = TRUE;
+        Track.ArV1    = Ar.v1();
+        Track.ArV2    = Ar.v2();
+        Track.SilLead = static_cast<ULONG>( Sil.leading() );
+        Track.SilTrail= static_cast<ULONG>( Sil.allSilent() ? 0 : Sil.trailing() );
+        StoreLoudness( Track, Loud );
+
+        Prog.mDone = Prog.mTotal;
+        Prog.mTs   = progressTs();
+        mOs << progressRecord(Prog) << std::flush;
+    }
+
+    ret = CloseHandle( hFile ) && ret;
+    if ( !ret )
+        Track.RipState = RIP_FAILED;
+    else if ( Track.Unreadable || Track.SecBad )
+        Track.RipState = RIP_PARTIAL;
+
+    return ret;
+}
+
+
+void CAudioCD::SetSilence( int Threshold, ULONG MinMs, BOOL Trim )
+{
+    m_SilThreshold = Threshold;
+    m_SilMinFrames = MinMs * 441 / 10;
+    m_bTrimSilence = Trim;
+}
+
+
+void CAudioCD::SetDeEmphasis( BOOL DeEmphasis )
+{
+    m_bDeEmphasis = DeEmphasis;
+}
+
+
+BOOL CAudioCD::HasPreEmphasis( ULONG Track )
+{
+    if ( Track >= m_aTracks.size() )
+        return FALSE;
+
+    return m_aTracks.at(Track).PreEmphasis;
+}
+
+
+void CAudioCD::SetLoudness( BOOL Measure )
+{
+    m_bLoudness = Measure;
+}
+
+
+void CAudioCD::StoreLoudness( CDTRACK& Track, const CLoudness& Loud )
+{
+    if ( !m_bLoudness )
+        return;
+
+    Track.LoudValid  = TRUE;
+    Track.Loudness   = Loud.integrated();
+    Track.TruePeak   = Loud.truePeak();
+    Track.LoudBlocks = Loud.blocks();
+}
+
+
+BOOL CAudioCD::Loudness( ULONG Track, double& Lufs, double& PeakDb )
+{
+    if ( Track >= m_aTracks.size() || !m_aTracks.at(Track).LoudValid )
+        return FALSE;
+
+    Lufs   = m_aTracks.at(Track).Loudness;
+    PeakDb = m_aTracks.at(Track).TruePeak;
+    return TRUE;
+}
+
+
+BOOL CAudioCD::AlbumLoudness( double& Lufs, double& PeakDb )
+{
+    std::vector<double> Blocks;
+    BOOL Valid = FALSE;
+    PeakDb = CLoudness::SILENCE_LUFS;
+
+    // album loudness is gated over the blocks of all tracks
+    for ( const CDTRACK& Track : m_aTracks )
+    {
+        if ( !Track.LoudValid )
+            continue;
+
+        Valid  = TRUE;
+        PeakDb = ( Track.TruePeak > PeakDb ) ? Track.TruePeak : PeakDb;
+        Blocks.insert( Blocks.end(), Track.LoudBlocks.begin(), Track.LoudBlocks.end() );
+    }
+
+    Lufs = CLoudness::integrated( Blocks );
+    return Valid;
+}
+
+
+ULONG CAudioCD::TrimSilence( ULONG TrackNr, LPCTSTR Path )
+{
+    if ( TrackNr >= m_aTracks.size() )
+        return 0;
+    CDTRACK& Track = m_aTracks.at(TrackNr);
+
+    // leading silence was cut while ripping; only the tail is left
+    ULONG Trail = ( Track.SilTrail >= m_SilMinFrames ) ? Track.SilTrail : 0;
+
+    if ( !m_bTrimSilence || Trail == 0 || Trail >= Track.FileFrames || Track.RipState == RIP_FAILED )
+        return Track.Trimmed;
+
+    HANDLE hFile = CreateFileA( Path, GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_TEMPORARY, NULL );
+    if ( hFile == INVALID_HANDLE_VALUE )
+        return Track.Trimmed;
+
+    ULONG NewSize = (Track.FileFrames - Trail) * 4;
+    ULONG Dummy;
+
+    SetFilePointer( hFile, sizeof(CWaveFileHeader) + NewSize, NULL, FILE_BEGIN );
+    BOOL Ok = SetEndOfFile( hFile );
+
+    CWaveFileHeader WaveFileHeader( 44100, 16, 2, NewSize );
+    SetFilePointer( hFile, 0, NULL, FILE_BEGIN );
+    Ok = Ok && WriteFile( hFile, &WaveFileHeader, sizeof(WaveFileHeader), &Dummy, NULL );
+
+    CloseHandle( hFile );
+
+    if ( !Ok )
+    {
+        // header and data size don't match
+        std::cerr << "Error while trimming silence of track " << TrackNr + 1 << std::endl;
+        Track.RipState = RIP_FAILED;
+        return Track.Trimmed;
+    }
+
+    Track.FileFrames -= Trail;
+    Track.Trimmed    += Trail;
+    return Track.Trimmed;
+}
+
+
+BOOL CAudioCD::GetSecureErrors( ULONG Track, ULONG& Retried, ULONG& Bad )
+{
+    if ( Track >= m_aTracks.size() )
+        return FALSE;
+
+    CDTRACK& Tr = m_aTracks.at(Track);
+    Retried = Tr.SecRetried;
+    Bad = Tr.SecBad;
+    return TRUE;
 }
 
+
+BOOL CAudioCD::ReadCdda( ULONG Lba, ULONG Count, char* pBuf )
+{
+    RAW_READ_INFO Info;
+    Info.TrackMode = CDDA;
+    Info.SectorCount = Count;
+    Info.DiskOffset.QuadPart = static_cast<LONGLONG>(Lba) * CD_SECTOR_SIZE;
+
+    ULONG Dummy;
+    return DeviceIoControl( m_hCD, IOCTL_CDROM_RAW_READ, &Info, sizeof(Info), pBuf, Count*RAW_SECTOR_SIZE, &Dummy, NULL );
+}
+
+
+BOOL CAudioCD::ReadAudio( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track, BOOL Recover )
+{
+    if ( m_ReadOffset == 0 )
+        return ReadSectors( Lba, Count, pBuf, Track ) || ( Recover && RecoverSectors( Lba, Count, pBuf, Track ) );
+
+    // offset in samples -> first sector to read and byte shift in it
+    LONG  Sectors = ( m_ReadOffset >= 0 ) ? ( m_ReadOffset / 588 ) : -( ( -m_ReadOffset + 587 ) / 588 );
+    LONG  First   = static_cast<LONG>( Lba ) + Sectors;
+    ULONG Shift   = static_cast<ULONG>( m_ReadOffset - Sectors * 588 ) * 4;
+    LONG  Need    = static_cast<LONG>( Count ) + ( Shift ? 1 : 0 );
+    LONG  End     = static_cast<LONG>( m_aTracks.back().Address + m_aTracks.back().Length );
+
+    // samples before the first / behind the last audio sector are silence
+    m_OffsetBuf.assign( Need * RAW_SECTOR_SIZE, 0 );
+    LONG From = ( First > 0 ) ? First : 0;
+    LONG To   = ( (First + Need) < End ) ? ( First + Need ) : End;
+
+    if ( To > From )
+    {
+        char* p = &m_OffsetBuf[ (From - First) * RAW_SECTOR_SIZE ];
+        if ( !ReadSectors( From, To - From, p, Track ) && !( Recover && RecoverSectors( From, To - From, p, Track ) ) )
+            return FALSE;
+    }
+
+    CopyMemory( pBuf, &m_OffsetBuf[Shift], Count * RAW_SECTOR_SIZE );
+    return TRUE;
+}
+
+
+void CAudioCD::SetReadOffset( LONG Samples )
+{
+    m_ReadOffset = Samples;
+}
+
+
+BOOL CAudioCD::ReadSectors( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track )
+{
+    if ( !m_bC2 )
+        return ReadCdda( Lba, Count, pBuf );
+
+    std::vector<ULONG> Bad;
+    if ( !ReadC2( Lba, Count, pBuf, Bad ) )
+        return FALSE;
+
+    if ( Bad.empty() )
+        return TRUE;
+
+    // re-read only the flagged sectors - slowly
+    SetReadSpeed( C2_RETRY_SPEED );
+
+    CBuf<char> Sector( RAW_SECTOR_SIZE );
+    for ( ULONG BadLba : Bad )
+    {
+        BOOL Clean = FALSE;
+        Track.C2Retried++;
+
+        for ( int r = 0; (r < C2_RETRIES) && !Clean; r++ )
+        {
+            std::vector<ULONG> Still;
+
+            // make sure the drive doesn't answer from its cache
+            FlushCache( BadLba );
+
+            if ( ReadC2( BadLba, 1, Sector, Still ) )
+            {
+                CopyMemory( pBuf + (BadLba - Lba)*RAW_SECTOR_SIZE, Sector.Ptr(), RAW_SECTOR_SIZE );
+                Clean = Still.empty();
+            }
+        }
+
+        if ( !Clean )
+            Track.C2Bad++;
+    }
+
+    SetReadSpeed( m_ReadSpeed );
+    return TRUE;
+}
+
+
+void CAudioCD::StartBudget( CDTRACK& Track )
+{
+    Track.BudgetReads = RECOVER_BUDGET_READS;
+    Track.BudgetEnd   = progressTs() + RECOVER_BUDGET_MS;
+}
+
+
+BOOL CAudioCD::RecoverSectors( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track )
+{
+    auto Budget = [&Track]()
+    {
+        if ( (Track.BudgetReads == 0) || (progressTs() >= Track.BudgetEnd) )
+            return FALSE;
+        Track.BudgetReads--;
+        return TRUE;
+    };
+
+    // 1. the whole chunk again, with growing pause
+    for ( int r = 0; (r < RECOVER_CHUNK_RETRIES) && Budget(); r++ )
+    {
+        Sleep( RECOVER_BACKOFF_MS << r );
+        if ( ReadSectors( Lba, Count, pBuf, Track ) )
+        {
+            Track.Recovered += Count;
+            return TRUE;
+        }
+    }
+
+    // disc removed / drive gone -> nothing to recover
+    if ( !IsCDReady() )
+        return FALSE;
+
+    // 2. sector by sector at low speed; what can't be read becomes silence
+    USHORT OldSpeed = m_ReadSpeed;
+    m_ReadSpeed = RECOVER_SPEED;
+    SetReadSpeed( m_ReadSpeed );
+
+    for ( ULONG s = 0; s < Count; s++ )
+    {
+        char* pSector = pBuf + s*RAW_SECTOR_SIZE;
+        BOOL Ok = FALSE;
+
+        for ( int r = 0; (r < RECOVER_SECTOR_RETRIES) && !Ok && Budget(); r++ )
+        {
+            if ( r > 0 )
+                Sleep( RECOVER_BACKOFF_MS << (r - 1) );
+
+            Ok = ReadSectors( Lba + s, 1, pSector, Track );
+        }
+
+        if ( Ok )
+        {
+            Track.Recovered++;
+        }
+        else
+        {
+            ZeroMemory( pSector, RAW_SECTOR_SIZE );
+            Track.Unreadable++;
+        }
+    }
+
+    m_ReadSpeed = OldSpeed;
+    SetReadSpeed( m_ReadSpeed );
+    return TRUE;
+}
+
+
+RIPSTATE CAudioCD::GetRipState( ULONG Track, ULONG* pRecovered, ULONG* pUnreadable )
+{
+    if ( Track >= m_aTracks.size() )
+        return RIP_FAILED;
+
+    CDTRACK& Tr = m_aTracks.at(Track);
+    if ( pRecovered )
+        *pRecovered = Tr.Recovered;
+    if ( pUnreadable )
+        *pUnreadable = Tr.Unreadable;
+    return Tr.RipState;
+}
+
+
+BOOL CAudioCD::ReadC2( ULONG Lba, ULONG Count, char* pAudio, std::vector<ULONG>& Bad )
+{
+    CBuf<UCHAR> Raw( Count * C2_SECTOR_SIZE );
+
+    // READ CD: CD-DA sectors, user data + C2 error pointers
+    UCHAR Cdb[12] = { 0xBE, 0x04,
+                      (UCHAR)(Lba >> 24), (UCHAR)(Lba >> 16), (UCHAR)(Lba >> 8), (UCHAR)Lba,
+                      (UCHAR)(Count >> 16), (UCHAR)(Count >> 8), (UCHAR)Count,
+                      0x12, 0x00, 0x00 };
+
+    if ( !ScsiCmd( Cdb, sizeof(Cdb), Raw, Raw.Size() ) )
+        return FALSE;
+
+    for ( ULONG i = 0; i < Count; i++ )
+    {
+        const UCHAR* pSector = Raw.Ptr() + i*C2_SECTOR_SIZE;
+        CopyMemory( pAudio + i*RAW_SECTOR_SIZE, pSector, RAW_SECTOR_SIZE );
+
+        for ( ULONG b = RAW_SECTOR_SIZE; b < C2_SECTOR_SIZE; b++ )
+        {
+            if ( pSector[b] )
+            {
+                Bad.push_back( Lba + i );
+                break;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+
+void CAudioCD::FlushCache( ULONG Lba )
+{
+    if ( m_aTracks.empty() )
+        return;
+
+    // read some sectors far away from the one we want
+    ULONG End  = m_aTracks.back().Address + m_aTracks.back().Length;
+    ULONG Away = ( Lba > 10000 ) ? ( Lba - 10000 ) : ( ( Lba + 10000 + SECTORS_AT_READ < End ) ? ( Lba + 10000 ) : 0 );
+
+    // same command as the reads to come - drives without C2 support
+    //   would reject READ CD with C2 pointers
+    CBuf<char> Buf( SECTORS_AT_READ * RAW_SECTOR_SIZE );
+    if ( m_bC2 )
+    {
+        std::vector<ULONG> Dummy;
+        ReadC2( Away, SECTORS_AT_READ, Buf, Dummy );
+    }
+    else
+        ReadCdda( Away, SECTORS_AT_READ, Buf );
+}
+
+
+BOOL CAudioCD::SetReadSpeed( USHORT KBs )
+{
+    // SET CD SPEED (write speed: don't care)
+    UCHAR Cdb[12] = { 0xBB, 0x00, (UCHAR)(KBs >> 8), (UCHAR)KBs, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0 };
+    BOOL Ok = ScsiCmd( Cdb, sizeof(Cdb), NULL, 0, FALSE );
+
+    // newer drives ignore SET CD SPEED and want SET STREAMING:
+    //   performance descriptor for the whole disc, read size per 1000 ms
+    ULONG End = m_aTracks.empty() ? 0 : ( m_aTracks.back().Address + m_aTracks.back().Length - 1 );
+    ULONG Kb  = ( KBs == CD_SPEED_MAX ) ? 0xFFFFFFFF : KBs;
+    UCHAR Perf[28] = { 0x00, 0, 0, 0,
+                       0, 0, 0, 0,
+                       (UCHAR)(End >> 24), (UCHAR)(End >> 16), (UCHAR)(End >> 8), (UCHAR)End,
+                       (UCHAR)(Kb >> 24), (UCHAR)(Kb >> 16), (UCHAR)(Kb >> 8), (UCHAR)Kb,
+                       0, 0, 0x03, 0xE8,
+                       (UCHAR)(Kb >> 24), (UCHAR)(Kb >> 16), (UCHAR)(Kb >> 8), (UCHAR)Kb,
+                       0, 0, 0x03, 0xE8 };
+
+    // restore defaults (RDD) if no limit is wanted
+    if ( KBs == CD_SPEED_MAX )
+        Perf[0] = 0x04;
+
+    UCHAR StrCdb[12] = { 0xB6, 0, 0, 0, 0, 0, 0, 0, 0, 0, sizeof(Perf), 0 };
+    Ok = ScsiCmd( StrCdb, sizeof(StrCdb), Perf, sizeof(Perf), FALSE ) || Ok;
+
+    return Ok;
+}
+
+
+// speed profile steps (x)
+static const UINT SpeedSteps[] = { 52, 48, 40, 32, 24, 16, 12, 8, 4 };
+static const ULONG SpeedStepCount = sizeof(SpeedSteps) / sizeof(SpeedSteps[0]);
+
+
+void CAudioCD::ProbeDrive()
+{
+    m_bC2 = FALSE;
+    m_DriveSpeed = 0;
+    m_Model.clear();
+
+    // INQUIRY: vendor (8..15) and product (16..31)
+    UCHAR Inq[36];
+    ZeroMemory( Inq, sizeof(Inq) );
+    UCHAR InqCdb[6] = { 0x12, 0, 0, 0, sizeof(Inq), 0 };
+
+    if ( ScsiCmd( InqCdb, sizeof(InqCdb), Inq, sizeof(Inq) ) )
+    {
+        m_Model.assign( reinterpret_cast<char*>(Inq + 8), 24 );
+        m_Model.erase( m_Model.find_last_not_of( " \t" ) + 1 );
+    }
+
+    // MODE SENSE (10): CD capabilities page
+    UCHAR Page[8 + 32];
+    ZeroMemory( Page, sizeof(Page) );
+    UCHAR Cdb[10] = { 0x5A, 0x08, 0x2A, 0, 0, 0, 0, 0, sizeof(Page), 0 };
+
+    if ( ScsiCmd( Cdb, sizeof(Cdb), Page, sizeof(Page) ) )
+    {
+        // page follows header (8 bytes) and block descriptors (if any)
+        ULONG Pg = 8 + ((Page[6] << 8) | Page[7]);
+        if ( ((Pg + 9) < sizeof(Page)) && ((Page[Pg] & 0x3F) == 0x2A) )
+        {
+            // max. read speed in kB/s (obsolete since MMC-3, still filled by most drives)
+            m_DriveSpeed = ( (Page[Pg + 8] << 8) | Page[Pg + 9] ) * 10 / 1764;
+            ProbeC2( Page + Pg );
+        }
+    }
+
+    // top of speed profile: user limit, drive max or table max
+    UINT Cap = m_MaxSpeed ? m_MaxSpeed : m_DriveSpeed;
+    m_TopLevel = 0;
+    while ( Cap && (m_TopLevel + 1 < SpeedStepCount) && (SpeedSteps[m_TopLevel] > Cap) )
+        m_TopLevel++;
+
+    m_SpeedLevel  = m_TopLevel;
+    m_CleanChunks = 0;
+    ApplySpeed();
+}
+
+
+BOOL CAudioCD::ProbeC2( const UCHAR* pCaps )
+{
+    m_bC2 = FALSE;
+
+    // C2 pointers supported bit
+    if ( m_aTracks.empty() || !(pCaps[5] & 0x10) )
+        return FALSE;
+
+    // some drives claim support but refuse the command
+    CBuf<char> Buf( RAW_SECTOR_SIZE );
+    std::vector<ULONG> Dummy;
+    m_bC2 = ReadC2( m_aTracks.front().Address, 1, Buf, Dummy );
+
+    return m_bC2;
+}
+
+
+void CAudioCD::ApplySpeed()
+{
+    // w/o user limit the fastest step means "whatever the drive can do"
+    if ( (m_SpeedLevel == m_TopLevel) && (m_MaxSpeed == 0) )
+        m_ReadSpeed = CD_SPEED_MAX;
+    else
+        m_ReadSpeed = CD_SPEED_X( SpeedSteps[m_SpeedLevel] );
+
+    SetReadSpeed( m_ReadSpeed );
+}
+
+
+void CAudioCD::UpdateSpeed( BOOL Clean )
+{
+    if ( !Clean )
+    {
+        m_CleanChunks = 0;
+        if ( (m_SpeedLevel + 1) < SpeedStepCount )
+        {
+            m_SpeedLevel++;
+            ApplySpeed();
+        }
+    }
+    else if ( (++m_CleanChunks >= SPEED_UP_CHUNKS) && (m_SpeedLevel > m_TopLevel) )
+    {
+        // left the bad zone -> try faster again
+        m_CleanChunks = 0;
+        m_SpeedLevel--;
+        ApplySpeed();
+    }
+}
+
+
+void CAudioCD::SetMaxSpeed( UINT Speed )
+{
+    m_MaxSpeed = Speed;
+}
+
+
+BOOL CAudioCD::GetTrackExtent( ULONG Track, ULONG& Address, ULONG& Length )
+{
+    if ( Track >= m_aTracks.size() )
+        return FALSE;
+
+    Address = m_aTracks.at(Track).Address;
+    Length = m_aTracks.at(Track).Length;
+    return TRUE;
+}
+
+
+BOOL CAudioCD::ReadRaw( ULONG Lba, ULONG Count, char* pBuf )
+{
+    if ( m_hCD == NULL )
+        return FALSE;
+
+    CDTRACK Scratch;
+    Scratch.C2Retried = Scratch.C2Bad = 0;
+    return ReadSectors( Lba, Count, pBuf, Scratch );
+}
+
+
+BOOL CAudioCD::SpinDown()
+{
+    // START STOP UNIT: Start = 0, LoEj = 0
+    UCHAR Cdb[6] = { 0x1B, 0, 0, 0, 0x00, 0 };
+    return ScsiCmd( Cdb, sizeof(Cdb), NULL, 0, FALSE );
+}
+
+
+std::string CAudioCD::DriveModel()
+{
+    return m_Model;
+}
+
+
+UINT CAudioCD::DriveMaxSpeed()
+{
+    return m_DriveSpeed;
+}
+
+
+UINT CAudioCD::CurrentSpeed()
+{
+    return ( m_ReadSpeed == CD_SPEED_MAX ) ? 0 : ( m_ReadSpeed * 10 / 1764 );
+}
+
+
+BOOL CAudioCD::ScsiCmd( const UCHAR* Cdb, UCHAR CdbLen, void* pData, ULONG DataLen, BOOL DataIn )
+{
+    if ( m_hCD == NULL )
+        return FALSE;
+
+    SCSI_PASS_THROUGH_DIRECT_SENSE Req;
+    ZeroMemory( &Req, sizeof(Req) );
+    Req.Sptd.Length = sizeof(SCSI_PASS_THROUGH_DIRECT);
+    Req.Sptd.CdbLength = CdbLen;
+    Req.Sptd.SenseInfoLength = sizeof(Req.Sense);
+    Req.Sptd.SenseInfoOffset = offsetof(SCSI_PASS_THROUGH_DIRECT_SENSE, Sense);
+    Req.Sptd.DataIn = DataIn ? SCSI_IOCTL_DATA_IN : SCSI_IOCTL_DATA_OUT;
+    Req.Sptd.DataTransferLength = DataLen;
+    Req.Sptd.DataBuffer = pData;
+    Req.Sptd.TimeOutValue = SCSI_TIMEOUT;
+    CopyMemory( Req.Sptd.Cdb, Cdb, CdbLen );
+
+    ULONG Dummy;
+    if ( !DeviceIoControl( m_hCD, IOCTL_SCSI_PASS_THROUGH_DIRECT, &Req, sizeof(Req), &Req, sizeof(Req), &Dummy, NULL ) )
+        return FALSE;
+
+    // SCSI status GOOD
+    return Req.Sptd.ScsiStatus == 0;
+}
+
+
+BOOL CAudioCD::HasC2()
+{
+    return m_bC2;
+}
+
+
+BOOL CAudioCD::GetC2Errors( ULONG Track, ULONG& Retried, ULONG& Bad )
+{
+    if ( Track >= m_aTracks.size() )
+        return FALSE;
+
+    CDTRACK& Tr = m_aTracks.at(Track);
+    Retried = Tr.C2Retried;
+    Bad = Tr.C2Bad;
+    return TRUE;
+}
+
+
+
+
 // Lock / Unlock CD-Rom Drive
 BOOL CAudioCD::LockCD()
 {
@@ -329,19 +1325,59 @@ UINT CAudioCD::cddbId()
     ULONG checksum = 0;
     UINT  ttime    = 0;
     
-    std::size_t count = m_aTracks.size();
+    // CDDB counts all tracks of the TOC (data tracks as well)
+    std::size_t count = GetTocTrackCount();
     
-    for (const auto& a : m_aTracks)
+    for (ULONG i = m_TOC.FirstTrack - 1; i < m_TOC.LastTrack; i++)
     {
-        checksum += cddb_sum((a.Address + 150) / CD_BLOCKS_PER_SECOND);
+        checksum += cddb_sum((AddressToSectors(m_TOC.TrackData[i].Address) + 150) / CD_BLOCKS_PER_SECOND);
     }
     
-    ttime = ((m_aTracks.at(count - 1).Address + m_aTracks.at(count - 1).Length + 150) / CD_BLOCKS_PER_SECOND)
-        - ((m_aTracks.at(0).Address + 150) / CD_BLOCKS_PER_SECOND);
+    ttime = ((AddressToSectors(m_TOC.TrackData[m_TOC.LastTrack].Address) + 150) / CD_BLOCKS_PER_SECOND)
+        - ((AddressToSectors(m_TOC.TrackData[m_TOC.FirstTrack - 1].Address) + 150) / CD_BLOCKS_PER_SECOND);
     
     return (checksum & 0xff) << 24 | ttime << 8 | count;
 }
 
+BOOL CAudioCD::ReadCdText()
+{
+    m_CdText.clear();
+    if ( m_hCD == NULL )
+        return FALSE;
+
+    CDROM_READ_TOC_EX Req;
+    ZeroMemory( &Req, sizeof(Req) );
+    Req.Format = CDROM_READ_TOC_EX_FORMAT_CDTEXT;
+
+    // 4 bytes header followed by the 18 byte packs
+    std::vector<UCHAR> Buf( CDTEXT_MAX_SIZE );
+    ULONG BytesRead = 0;
+    if ( 0 == DeviceIoControl( m_hCD, IOCTL_CDROM_READ_TOC_EX, &Req, sizeof(Req), Buf.data(), Buf.size(), &BytesRead, NULL ) )
+        return FALSE;
+
+    ULONG Len = ( ( Buf[0] << 8 ) | Buf[1] ) + 2;
+    if ( Len > BytesRead )
+        Len = BytesRead;
+    if ( Len <= 4 )
+        return FALSE;
+
+    // CD-Text is indexed by TOC track number
+    std::vector<std::string> TocTitles;
+    if ( 0 != parseCdText( &Buf[4], Len - 4, GetTocTrackCount(), TocTitles ) )
+        return FALSE;
+
+    m_CdText.push_back( TocTitles.at(0) );
+    for ( const auto& a : m_aTracks )
+        m_CdText.push_back( ( a.TocNumber < TocTitles.size() ) ? TocTitles.at(a.TocNumber) : std::string() );
+
+    return TRUE;
+}
+
+const std::vector<std::string>& CAudioCD::cdTextTitles()
+{
+    return m_CdText;
+}
+
 /**
     create request to be used to obtain disc information
 */
@@ -351,12 +1387,40 @@ std::string CAudioCD::cddbQueryPart()
     std::ostringstream oss;
     oss << std::hex << cddbid << std::dec << "+" << (cddbid & 0xff);
     
-    for (const auto& a : m_aTracks)
+    for (ULONG i = m_TOC.FirstTrack - 1; i < m_TOC.LastTrack; i++)
     {
-        oss << "+" << (a.Address + 150);
+        oss << "+" << (AddressToSectors(m_TOC.TrackData[i].Address) + 150);
     }
     
     oss << "+" << ((cddbid >> 8) & 0xFFFF);
     
     return oss.str();
 }
+
+BOOL CAudioCD::accurateRipCrc( ULONG Track, UINT& V1, UINT& V2 )
+{
+    if ( Track >= m_aTracks.size() )
+        return FALSE;
+
+    CDTRACK& Tr = m_aTracks.at(Track);
+    V1 = Tr.ArV1;
+    V2 = Tr.ArV2;
+    return Tr.ArValid;
+}
+
+std::string CAudioCD::accurateRipFile()
+{
+    if ( m_aTracks.empty() )
+        return "";
+
+    std::vector<uint32_t> Offsets;
+    for (const auto& a : m_aTracks)
+    {
+        Offsets.push_back(a.Address);
+    }
+
+    // lead-out
+    Offsets.push_back(m_aTracks.back().Address + m_aTracks.back().Length);
+
+    return CAccurateRip::dbFileName(Offsets, cddbId());
+}
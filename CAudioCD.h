@@ -17,15 +17,52 @@
 #include <iostream>
 #include "CBuf.h"
 #include "AudioCD_Helpers.h"
+#include "CAccurateRip.h"
+#include "CSilenceScan.h"
+#include "CLoudness.h"
+#include "CDeEmphasis.h"
 
 
 
 
+// Result of extracting a track
+enum RIPSTATE
+{
+    RIP_OK,         // all sectors read
+    RIP_PARTIAL,    // unreadable sectors were replaced by silence or
+                    //   blocks failed secure verification
+    RIP_FAILED      // track file is unusable
+};
+
 // Structure to hold the basic information for a cd-track
 struct CDTRACK
 {
+    UINT  TocNumber; // track number in TOC (data tracks count as well)
     ULONG Address;
     ULONG Length;
+    BOOL  ArValid;   // AccurateRip checksums below are valid
+    UINT  ArV1;      // AccurateRip v1 CRC (set by "ExtractTrack")
+    UINT  ArV2;      // AccurateRip v2 CRC (set by "ExtractTrack")
+    ULONG C2Retried; // sectors re-read because C2 flagged errors
+    ULONG C2Bad;     // sectors still flagged after all re-reads
+    ULONG SecRetried;// blocks which differed in the verify pass
+    ULONG SecBad;    // blocks without two matching reads
+    std::vector<ULONGLONG> BlockHash; // block hashes of copy pass (secure mode)
+    RIPSTATE RipState;  // result of "ExtractTrack" / "VerifyTrack"
+    ULONG Recovered;    // sectors read only by the recovery engine
+    ULONG Unreadable;   // sectors replaced by silence
+    ULONG BudgetReads;  // recovery reads left for this track
+    ULONGLONG BudgetEnd;// end of recovery time for this track (ms)
+    ULONG SilLead;      // silent frames at track start
+    ULONG SilTrail;     // silent frames at track end
+    ULONG Trimmed;      // frames not in the wave file (silence trimmed)
+    ULONG LeadCut;      // leading silent frames not written by "ExtractTrack"
+    ULONG FileFrames;   // frames in the wave file
+    BOOL  LoudValid;    // loudness values below are valid
+    double Loudness;    // integrated loudness (LUFS)
+    double TruePeak;    // true peak (dBTP)
+    std::vector<double> LoudBlocks; // gating block energies (album loudness)
+    BOOL  PreEmphasis;  // TOC flags audio with pre-emphasis
 };
 
 
@@ -73,10 +110,15 @@ class CAudioCD
 
         // READ / GET TRACK-DATA
 
-        // Returns the number of tracks avaiable.
+        // Returns the number of audio-tracks avaiable.
         // 0xFFFFFFFF on failure (e.g. no "Open" called)
         ULONG GetTrackCount();
 
+        // Data tracks are skipped, so audio track index and TOC track
+        //   number may differ. CDDB and CD-Text titles use TOC numbers.
+        ULONG GetTocTrackCount();
+        std::vector<UINT> GetTocNumbers();
+
         // Returns the length in seconds of an audio-track.
         // 0xFFFFFFFF on failure (e.g. no "Open" called)
         ULONG GetTrackTime( ULONG Track );
@@ -95,6 +137,35 @@ class CAudioCD
         //   cd-audio-attributes: 44100Hz, 16Bit, Stereo
         BOOL ExtractTrack( ULONG Track, LPCTSTR Path );
 
+        // Secure mode: "ExtractTrack" records a hash per block, so
+        //   "VerifyTrack" can read the track again and re-read the blocks
+        //   which differ until two reads match.
+        void SetSecure( BOOL Secure );
+        BOOL VerifyTrack( ULONG Track, LPCTSTR Path );
+
+        // Silence at start / end of a track is detected while ripping
+        //   (|sample| <= Threshold). With Trim set, "ExtractTrack" holds
+        //   back leading silence and doesn't write runs of at least MinMs
+        //   (an all silent track is cut to MinMs). "TrimSilence" then cuts
+        //   such a run from the end of the file. Returns number of frames
+        //   removed from the track.
+        void SetSilence( int Threshold, ULONG MinMs, BOOL Trim );
+        ULONG TrimSilence( ULONG Track, LPCTSTR Path );
+
+        // Tracks flagged with pre-emphasis are de-emphasized while ripping
+        //   (default), unless switched off here.
+        void SetDeEmphasis( BOOL DeEmphasis );
+        BOOL HasPreEmphasis( ULONG Track );
+
+        // Read offset correction of the drive in samples (as listed by
+        //   AccurateRip, e.g. +6). Track data is shifted while ripping, so
+        //   files and AccurateRip checksums are offset corrected.
+        void SetReadOffset( LONG Samples );
+
+        // Loudness (EBU R128) and true peak are measured while ripping
+        //   if enabled here.
+        void SetLoudness( BOOL Measure );
+
 
 
 
@@ -137,11 +208,164 @@ class CAudioCD
             create request to be used to obtain disc information
         */
         std::string cddbQueryPart();
+
+        /**
+            UTF-8 titles read from CD-Text (index 0 is disc title),
+            empty if disc has no CD-Text
+        */
+        const std::vector<std::string>& cdTextTitles();
+
+        /**
+            AccurateRip v1 / v2 CRCs of a track computed while it was
+            extracted; FALSE if track wasn't (completely) extracted
+        */
+        BOOL accurateRipCrc( ULONG Track, UINT& V1, UINT& V2 );
+
+        /**
+            relative path of the AccurateRip database file of this disc
+        */
+        std::string accurateRipFile();
+
+        /**
+            loudness (LUFS) and true peak (dBTP) of a track measured while
+            it was extracted; FALSE if track wasn't measured
+        */
+        BOOL Loudness( ULONG Track, double& Lufs, double& PeakDb );
+
+        /**
+            loudness (LUFS) and true peak (dBTP) over all measured tracks;
+            FALSE if no track was measured
+        */
+        BOOL AlbumLoudness( double& Lufs, double& PeakDb );
+
+        /**
+            drive delivers C2 error pointers (READ CD is used for ripping)
+        */
+        BOOL HasC2();
+
+        /**
+            limit read speed (speed factor, e.g. 24 for 24x; 0 -> drive max),
+            call before "Open"
+        */
+        void SetMaxSpeed( UINT Speed );
+
+        /**
+            drive vendor / product and max. read speed (x, 0 -> unknown)
+            as probed by "Open"
+        */
+        std::string DriveModel();
+        UINT DriveMaxSpeed();
+
+        /**
+            current read speed of the speed profile (x, 0 -> drive max)
+        */
+        UINT CurrentSpeed();
+
+        /**
+            start sector and length of a track
+        */
+        BOOL GetTrackExtent( ULONG Track, ULONG& Address, ULONG& Length );
+
+        /**
+            read audio sectors the way "ExtractTrack" does (C2 if
+            supported), but w/o recovery (used by the drive benchmark)
+        */
+        BOOL ReadRaw( ULONG Lba, ULONG Count, char* pBuf );
+
+        /**
+            stop the disc (START STOP UNIT), next read spins it up
+        */
+        BOOL SpinDown();
+
+        /**
+            C2 statistic of an extracted track: sectors re-read and
+            sectors still flagged after all re-reads
+        */
+        BOOL GetC2Errors( ULONG Track, ULONG& Retried, ULONG& Bad );
+
+        /**
+            secure mode statistic of a verified track: blocks which
+            differed and blocks without two matching reads
+        */
+        BOOL GetSecureErrors( ULONG Track, ULONG& Retried, ULONG& Bad );
+
+        /**
+            result of extracting a track, with the number of sectors
+            which needed recovery and which were replaced by silence
+        */
+        RIPSTATE GetRipState( ULONG Track, ULONG* pRecovered = NULL, ULONG* pUnreadable = NULL );
         
     protected:
-        HANDLE                  m_hCD;
-        std::vector<CDTRACK>    m_aTracks;
-        CDROM_TOC               m_TOC;
+        // Reads and decodes CD-Text (READ TOC format 5), called by "Open"
+        BOOL ReadCdText();
+
+        // Reads drive model, max. speed and C2 support, called by "Open"
+        void ProbeDrive();
+
+        // Checks if the drive delivers C2 error pointers
+        BOOL ProbeC2( const UCHAR* pCaps );
+
+        // Speed profile: step down after a chunk with errors, step up
+        //   again after SPEED_UP_CHUNKS clean chunks
+        void UpdateSpeed( BOOL Clean );
+
+        // Sends the speed of the current profile level to the drive
+        void ApplySpeed();
+
+        // Reads audio sectors corrected by the read offset; failed reads go
+        //   to the recovery engine if Recover is set
+        BOOL ReadAudio( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track, BOOL Recover = TRUE );
+
+        // Reads audio sectors with IOCTL_CDROM_RAW_READ (no C2 information)
+        BOOL ReadCdda( ULONG Lba, ULONG Count, char* pBuf );
+
+        // Reads audio sectors; with C2 support flagged sectors are re-read
+        BOOL ReadSectors( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track );
+
+        // Recovery after a failed read: retries with backoff, sector wise
+        //   reads at low speed, bounded by the track's retry budget.
+        //   Unreadable sectors become silence. FALSE -> drive is gone.
+        BOOL RecoverSectors( ULONG Lba, ULONG Count, char* pBuf, CDTRACK& Track );
+
+        // Starts the recovery budget of a track
+        void StartBudget( CDTRACK& Track );
+
+        // Stores results of the loudness meter (if enabled)
+        void StoreLoudness( CDTRACK& Track, const CLoudness& Loud );
+
+        // READ CD with C2 error pointers, collects LBAs of flagged sectors
+        BOOL ReadC2( ULONG Lba, ULONG Count, char* pAudio, std::vector<ULONG>& Bad );
+
+        // Reads far away sectors so a re-read doesn't come from drive cache
+        void FlushCache( ULONG Lba );
+
+        // SET CD SPEED and SET STREAMING (read speed in kB/s,
+        //   CD_SPEED_MAX -> fastest)
+        BOOL SetReadSpeed( USHORT KBs );
+
+        // Sends a SCSI command through SCSI pass through
+        BOOL ScsiCmd( const UCHAR* Cdb, UCHAR CdbLen, void* pData, ULONG DataLen, BOOL DataIn = TRUE );
+
+        HANDLE                   m_hCD;
+        std::vector<CDTRACK>     m_aTracks;
+        CDROM_TOC                m_TOC;
+        std::vector<std::string> m_CdText;
+        BOOL                     m_bC2;
+        BOOL                     m_bSecure;
+        USHORT                   m_ReadSpeed;   // speed to go back to after slow re-reads
+        int                      m_SilThreshold;// max. sample value counted as silence
+        ULONG                    m_SilMinFrames;// min. length of silence to trim
+        BOOL                     m_bTrimSilence;// trim silence while ripping
+        BOOL                     m_bLoudness;   // measure loudness while ripping
+        BOOL                     m_bDeEmphasis; // de-emphasize flagged tracks
+        LONG                     m_ReadOffset;  // drive read offset correction (samples)
+        std::vector<char>        m_OffsetBuf;   // sectors read for offset correction
+        UINT                     m_MaxSpeed;    // user limit (x), 0 -> none
+        UINT                     m_DriveSpeed;  // max. read speed of drive (x), 0 -> unknown
+        ULONG                    m_SpeedLevel;  // current step in speed table
+        ULONG                    m_TopLevel;    // fastest allowed step
+        ULONG                    m_CleanChunks; // clean chunks since last step
+        std::string              m_Model;       // drive vendor / product
 };
 
 
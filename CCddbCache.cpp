@@ -0,0 +1,303 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CCddbCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+/// header lines of a cache entry
+static constexpr const char* CACHE_QUERY_TAG = "# cd2netmd-query: ";
+static constexpr const char* CACHE_MATCH_TAG = "# cd2netmd-match: ";
+
+/// genre folders of a freedb dump
+static const char* const FREEDB_GENRES[] = {
+    "blues", "classical", "country", "data", "folk", "jazz",
+    "misc", "newage", "reggae", "rock", "soundtrack"
+};
+
+//------------------------------------------------------------------------------
+//! @brief      make sure path ends with a slash (if not empty)
+//!
+//! @param[in]  dir   The directory
+//!
+//! @return     directory with trailing slash
+//------------------------------------------------------------------------------
+static std::string withSlash(const std::string& dir)
+{
+    if (!dir.empty() && (dir.back() != '/') && (dir.back() != '\\'))
+    {
+        return dir + "/";
+    }
+    return dir;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      read a complete file
+//!
+//! @param[in]  path  The path
+//! @param[out] cont  file content
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+static bool readFile(const std::string& path, std::string& cont)
+{
+    std::ifstream f(path, std::ios::binary);
+
+    if (!f)
+    {
+        return false;
+    }
+
+    std::ostringstream oss;
+    oss << f.rdbuf();
+    cont = oss.str();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create cache object
+//!
+//! @param[in]  cacheDir  The cache directory (must exist), empty -> off
+//! @param[in]  dumpDir   The freedb dump directory, empty -> not used
+//------------------------------------------------------------------------------
+CCddbCache::CCddbCache(const std::string& cacheDir, const std::string& dumpDir)
+    : mCacheDir(withSlash(cacheDir)), mDumpDir(withSlash(dumpDir))
+{
+}
+
+//------------------------------------------------------------------------------
+//! @brief      cache file path for a disc
+//!
+//! @param[in]  queryPart  CDDB query part of disc
+//! @param[in]  cddbId     CDDB disc id
+//!
+//! @return     file path
+//------------------------------------------------------------------------------
+std::string CCddbCache::entryPath(const std::string& queryPart, uint32_t cddbId) const
+{
+    // FNV-1a over the complete TOC keeps colliding disc ids apart
+    uint32_t hash = 2166136261u;
+    for (const auto& c : queryPart)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%08x-%08x.xmcd", cddbId, hash);
+    return mCacheDir + name;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      look up disc info
+//!
+//! @param[in]  queryPart  CDDB query part of disc
+//! @param[in]  cddbId     CDDB disc id
+//! @param[out] xmcd       raw xmcd disc info
+//! @param[out] match      genre+cddbid of matching entry
+//!
+//! @return     true on hit; false on miss
+//------------------------------------------------------------------------------
+bool CCddbCache::lookup(const std::string& queryPart, uint32_t cddbId, std::string& xmcd, std::string& match) const
+{
+    std::string cont;
+
+    if (!mCacheDir.empty() && readFile(entryPath(queryPart, cddbId), cont))
+    {
+        std::istringstream iss(cont);
+        std::string query, line;
+
+        // header: query line, match line, then raw xmcd
+        if (std::getline(iss, line) && (line.find(CACHE_QUERY_TAG) == 0))
+        {
+            query = line.substr(strlen(CACHE_QUERY_TAG));
+        }
+
+        if (std::getline(iss, line) && (line.find(CACHE_MATCH_TAG) == 0))
+        {
+            match = line.substr(strlen(CACHE_MATCH_TAG));
+        }
+
+        if ((query == queryPart) && !match.empty())
+        {
+            xmcd = cont.substr(static_cast<size_t>(iss.tellg()));
+            return true;
+        }
+    }
+
+    if (!mDumpDir.empty() && lookupDump(queryPart, cddbId, xmcd, match))
+    {
+        // next time straight from the cache
+        store(queryPart, cddbId, match, xmcd);
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      store disc info
+//!
+//! @param[in]  queryPart  CDDB query part of disc
+//! @param[in]  cddbId     CDDB disc id
+//! @param[in]  match      genre+cddbid of chosen entry
+//! @param[in]  xmcd       raw xmcd disc info
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+bool CCddbCache::store(const std::string& queryPart, uint32_t cddbId, const std::string& match, const std::string& xmcd) const
+{
+    if (mCacheDir.empty() || match.empty() || xmcd.empty())
+    {
+        return false;
+    }
+
+    // write to temp file first, so a crash never leaves a half written entry
+    std::string path = entryPath(queryPart, cddbId);
+    std::string tmp  = path + ".tmp";
+
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+
+        if (!f)
+        {
+            return false;
+        }
+
+        f << CACHE_QUERY_TAG << queryPart << "\n"
+          << CACHE_MATCH_TAG << match << "\n"
+          << xmcd;
+
+        if (!f.good())
+        {
+            return false;
+        }
+    }
+
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      look up disc info in freedb dump
+//!
+//! @param[in]  queryPart  CDDB query part of disc
+//! @param[in]  cddbId     CDDB disc id
+//! @param[out] xmcd       raw xmcd disc info
+//! @param[out] match      genre+cddbid of matching entry
+//!
+//! @return     true on hit; false on miss
+//------------------------------------------------------------------------------
+bool CCddbCache::lookupDump(const std::string& queryPart, uint32_t cddbId, std::string& xmcd, std::string& match) const
+{
+    char id[16];
+    snprintf(id, sizeof(id), "%08x", cddbId);
+
+    std::vector<uint32_t> toc = queryOffsets(queryPart);
+    std::string cont;
+
+    for (const auto& genre : FREEDB_GENRES)
+    {
+        if (readFile(mDumpDir + genre + "/" + id, cont))
+        {
+            // disc ids collide, the track offsets don't
+            if (xmcdOffsets(cont) == toc)
+            {
+                xmcd  = cont;
+                match = std::string(genre) + "+" + id;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      extract track frame offsets from CDDB query part
+//!             (format: discid+count+offset1+...+offsetN+seconds)
+//!
+//! @param[in]  queryPart  CDDB query part of disc
+//!
+//! @return     track frame offsets
+//------------------------------------------------------------------------------
+std::vector<uint32_t> CCddbCache::queryOffsets(const std::string& queryPart)
+{
+    std::vector<uint32_t> ret;
+    std::vector<uint32_t> tok;
+    const char* p = queryPart.c_str();
+    char* end;
+
+    // skip disc id
+    if ((p = strchr(p, '+')) == nullptr)
+    {
+        return ret;
+    }
+
+    while (*p == '+')
+    {
+        tok.push_back(std::strtoul(p + 1, &end, 10));
+        p = end;
+    }
+
+    // count, offsets ..., seconds
+    if ((tok.size() >= 2) && (tok.front() == (tok.size() - 2)))
+    {
+        ret.assign(tok.begin() + 1, tok.end() - 1);
+    }
+
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      extract track frame offsets from xmcd comment
+//!
+//! @param[in]  xmcd  The xmcd
+//!
+//! @return     track frame offsets
+//------------------------------------------------------------------------------
+std::vector<uint32_t> CCddbCache::xmcdOffsets(const std::string& xmcd)
+{
+    std::vector<uint32_t> ret;
+    std::istringstream iss(xmcd);
+    std::string line;
+    bool inList = false;
+
+    while (std::getline(iss, line))
+    {
+        if (line.find("# Track frame offsets") == 0)
+        {
+            inList = true;
+        }
+        else if (inList)
+        {
+            // list lines look like "#       150"
+            size_t pos = line.find_first_of("0123456789");
+
+            if ((line[0] != '#') || (pos == std::string::npos))
+            {
+                break;
+            }
+
+            ret.push_back(std::strtoul(line.c_str() + pos, nullptr, 10));
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      Local on-disk cache for CDDB / xmcd disc information.
+//!
+//! Every entry lives in its own file, named after the CDDB id and a hash
+//! of the complete TOC (see CAudioCD::cddbQueryPart()). A lookup therefore
+//! is a single file open - no index to load, no directory scan. The entry
+//! stores the raw xmcd text together with the match the user has chosen.
+//!
+//! Optionally a freedb dump directory (<dump>/<genre>/<discid>) is searched
+//! on a cache miss. Hits from the dump are verified against the TOC.
+//------------------------------------------------------------------------------
+class CCddbCache
+{
+public:
+    //--------------------------------------------------------------------------
+    //! @brief      create cache object
+    //!
+    //! @param[in]  cacheDir  The cache directory (must exist), empty -> off
+    //! @param[in]  dumpDir   The freedb dump directory, empty -> not used
+    //--------------------------------------------------------------------------
+    CCddbCache(const std::string& cacheDir, const std::string& dumpDir = "");
+
+    //--------------------------------------------------------------------------
+    //! @brief      look up disc info
+    //!
+    //! @param[in]  queryPart  CDDB query part of disc
+    //! @param[in]  cddbId     CDDB disc id
+    //! @param[out] xmcd       raw xmcd disc info
+    //! @param[out] match      genre+cddbid of matching entry
+    //!
+    //! @return     true on hit; false on miss
+    //--------------------------------------------------------------------------
+    bool lookup(const std::string& queryPart, uint32_t cddbId, std::string& xmcd, std::string& match) const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      store disc info
+    //!
+    //! @param[in]  queryPart  CDDB query part of disc
+    //! @param[in]  cddbId     CDDB disc id
+    //! @param[in]  match      genre+cddbid of chosen entry
+    //! @param[in]  xmcd       raw xmcd disc info
+    //!
+    //! @return     true on success
+    //--------------------------------------------------------------------------
+    bool store(const std::string& queryPart, uint32_t cddbId, const std::string& match, const std::string& xmcd) const;
+
+private:
+    //--------------------------------------------------------------------------
+    //! @brief      cache file path for a disc
+    //--------------------------------------------------------------------------
+    std::string entryPath(const std::string& queryPart, uint32_t cddbId) const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      look up disc info in freedb dump
+    //--------------------------------------------------------------------------
+    bool lookupDump(const std::string& queryPart, uint32_t cddbId, std::string& xmcd, std::string& match) const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      extract track frame offsets from CDDB query part
+    //--------------------------------------------------------------------------
+    static std::vector<uint32_t> queryOffsets(const std::string& queryPart);
+
+    //--------------------------------------------------------------------------
+    //! @brief      extract track frame offsets from xmcd comment
+    //--------------------------------------------------------------------------
+    static std::vector<uint32_t> xmcdOffsets(const std::string& xmcd);
+
+    std::string mCacheDir;
+    std::string mDumpDir;
+};
@@ -0,0 +1,219 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CCddbMirrors.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    /// state of one request, shared with the request threads
+    /// (a cancelled thread may outlive the request)
+    struct SRace
+    {
+        std::mutex              mMtx;
+        std::condition_variable mCv;
+        int                     mRunning = 0;
+        int                     mWinner  = -1;
+        SHttpResult             mResult;
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      check if an answer is usable: HTTP 200 and a CDDB success
+    //!             code (2xx, but not 202 - no match)
+    //!
+    //! @param[in]  res   The result
+    //!
+    //! @return     true if valid
+    //--------------------------------------------------------------------------
+    bool validAnswer(const SHttpResult& res)
+    {
+        if ((res.mStatus != 200) || (res.mBody.size() < 3))
+        {
+            return false;
+        }
+
+        int code = std::atoi(res.mBody.c_str());
+        return (code >= 200) && (code < 300) && (code != 202);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create mirror list
+//!
+//! @param[in]  serverList  comma separated list of server URLs
+//! @param[in]  hedgeMs     delay before the next mirror is asked
+//! @param[in]  timeoutMs   deadline for one request
+//------------------------------------------------------------------------------
+CCddbMirrors::CCddbMirrors(const std::string& serverList, uint32_t hedgeMs, uint32_t timeoutMs)
+    : mHedgeMs(hedgeMs), mTimeoutMs(timeoutMs), mLastWinner(0)
+{
+    std::istringstream iss(serverList);
+    std::string name;
+
+    while (std::getline(iss, name, ','))
+    {
+        // trim blanks
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+
+        if (name.empty())
+        {
+            continue;
+        }
+
+        Mirror_t m = std::make_shared<SMirror>();
+        m->mName   = name;
+
+        if (CHttpClient::parseUrl(name, m->mUrl) && (m->mClient = CHttpClient::create(m->mUrl)))
+        {
+            m->mClient->setTimeout(mTimeoutMs);
+            mMirrors.push_back(m);
+        }
+        else
+        {
+            mRejected.push_back(name);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      URLs which couldn't be used
+//!
+//! @return     list of rejected URLs
+//------------------------------------------------------------------------------
+const std::vector<std::string>& CCddbMirrors::rejected() const
+{
+    return mRejected;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      number of usable mirrors
+//------------------------------------------------------------------------------
+size_t CCddbMirrors::size() const
+{
+    return mMirrors.size();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      send CDDB command to the mirrors; the mirror which answered
+//!             last is asked first (open connection, same database)
+//!
+//! @param[in]  cmd     CDDB command, e.g. "cddb+query+..."
+//! @param[out] result  the winning answer
+//! @param[out] winner  URL of the winning mirror
+//!
+//! @return     true if a mirror answered in time
+//------------------------------------------------------------------------------
+bool CCddbMirrors::request(const std::string& cmd, SHttpResult& result, std::string& winner)
+{
+    typedef std::chrono::steady_clock clk;
+
+    auto race     = std::make_shared<SRace>();
+    auto deadline = clk::now() + std::chrono::milliseconds(mTimeoutMs);
+    auto nextStart = clk::now();
+    std::vector<size_t> started;
+    size_t next = 0;
+
+    result = SHttpResult{};
+    winner.clear();
+
+    std::unique_lock<std::mutex> lk(race->mMtx);
+
+    while (race->mWinner < 0)
+    {
+        // start next mirror if the running ones failed or are too slow
+        if ((next < mMirrors.size()) && ((race->mRunning == 0) || (clk::now() >= nextStart)))
+        {
+            size_t   idx = (mLastWinner + next++) % mMirrors.size();
+            Mirror_t m   = mMirrors[idx];
+
+            // a cancelled request might still be running
+            if (m->mBusy.exchange(true))
+            {
+                continue;
+            }
+
+            // reset cancel state while we own the client, so that a cancel()
+            // coming before the thread enters get() isn't lost
+            m->mClient->arm();
+
+            std::string path = m->mUrl.mPath + "?cmd=" + cmd;
+            race->mRunning++;
+            started.push_back(idx);
+            nextStart = clk::now() + std::chrono::milliseconds(mHedgeMs);
+
+            std::thread([race, m, path, idx]()
+            {
+                SHttpResult res;
+                bool ok = m->mClient->get(path, res) && validAnswer(res);
+                m->mBusy = false;
+
+                std::lock_guard<std::mutex> lock(race->mMtx);
+                race->mRunning--;
+                if (ok && (race->mWinner < 0))
+                {
+                    race->mWinner = static_cast<int>(idx);
+                    race->mResult = std::move(res);
+                }
+                else if ((race->mWinner < 0) && race->mResult.mError.empty())
+                {
+                    // keep first error for the report
+                    race->mResult.mError = res.mError.empty()
+                        ? (m->mUrl.mHost + ": " + res.mBody.substr(0, res.mBody.find_first_of("\r\n"))) : res.mError;
+                }
+                race->mCv.notify_all();
+            }).detach();
+
+            continue;
+        }
+
+        if (((next >= mMirrors.size()) && (race->mRunning == 0)) || (clk::now() >= deadline))
+        {
+            break;
+        }
+
+        race->mCv.wait_until(lk, (next < mMirrors.size()) ? std::min(nextStart, deadline) : deadline);
+    }
+
+    // cancel the requests which lost the race
+    for (const auto& idx : started)
+    {
+        if ((static_cast<int>(idx) != race->mWinner) && mMirrors[idx]->mBusy)
+        {
+            mMirrors[idx]->mClient->cancel();
+        }
+    }
+
+    if (race->mWinner >= 0)
+    {
+        mLastWinner = static_cast<size_t>(race->mWinner);
+        winner      = mMirrors[mLastWinner]->mName;
+        result      = race->mResult;
+        return true;
+    }
+
+    result.mError = race->mResult.mError.empty() ? "No CDDB server answered in time" : race->mResult.mError;
+    if (race->mRunning > 0)
+    {
+        result.mError = "No CDDB server answered within " + std::to_string(mTimeoutMs) + " ms";
+    }
+    return false;
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include "CHttpClient.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      Sends CDDB requests to a list of mirrors.
+//!             The first mirror starts at once, every hedge delay without a
+//!             valid answer starts the next one. The first valid answer wins,
+//!             requests still running are cancelled. The whole request is
+//!             bound to a deadline.
+//------------------------------------------------------------------------------
+class CCddbMirrors
+{
+public:
+    /// one CDDB server
+    struct SMirror
+    {
+        std::string                  mName;          ///< URL as given by user
+        SHttpUrl                     mUrl;           ///< parsed URL
+        std::unique_ptr<CHttpClient> mClient;        ///< connection to server
+        std::atomic_bool             mBusy = {false};///< request running
+    };
+
+    typedef std::shared_ptr<SMirror> Mirror_t;
+
+    //--------------------------------------------------------------------------
+    //! @brief      create mirror list
+    //!
+    //! @param[in]  serverList  comma separated list of server URLs
+    //! @param[in]  hedgeMs     delay before the next mirror is asked
+    //! @param[in]  timeoutMs   deadline for one request
+    //--------------------------------------------------------------------------
+    CCddbMirrors(const std::string& serverList, uint32_t hedgeMs, uint32_t timeoutMs);
+
+    //--------------------------------------------------------------------------
+    //! @brief      URLs which couldn't be used
+    //!
+    //! @return     list of rejected URLs
+    //--------------------------------------------------------------------------
+    const std::vector<std::string>& rejected() const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      number of usable mirrors
+    //--------------------------------------------------------------------------
+    size_t size() const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      send CDDB command to the mirrors; the mirror which answered
+    //!             last is asked first (open connection, same database)
+    //!
+    //! @param[in]  cmd     CDDB command, e.g. "cddb+query+..."
+    //! @param[out] result  the winning answer
+    //! @param[out] winner  URL of the winning mirror
+    //!
+    //! @return     true if a mirror answered in time
+    //--------------------------------------------------------------------------
+    bool request(const std::string& cmd, SHttpResult& result, std::string& winner);
+
+private:
+    std::vector<Mirror_t>    mMirrors;
+    std::vector<std::string> mRejected;
+    uint32_t                 mHedgeMs;
+    uint32_t                 mTimeoutMs;
+    size_t                   mLastWinner;
+};
@@ -0,0 +1,149 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CDeEmphasis.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DEEMPH_SSE2
+#endif
+
+namespace
+{
+    /// biquad y = b0 * x + b1 * x[-1] + b2 * x[-2] - a1 * y[-1] - a2 * y[-2]
+    struct SDeEmphCoeff
+    {
+        double b0, b1, b2, a1, a2;
+
+        //----------------------------------------------------------------------
+        //! @brief      high shelf (RBJ cookbook) fitted to the analog 50/15 us
+        //!             curve at 44.1 kHz (fc 5283 Hz, -9.477 dB, slope 0.4845
+        //!             as used by SoX); deviation < 0.1 dB up to 20 kHz
+        //----------------------------------------------------------------------
+        SDeEmphCoeff()
+        {
+            const double pi    = 3.14159265358979323846;
+            const double A     = std::pow(10.0, -9.477 / 40.0);
+            const double w0    = 2.0 * pi * 5283.0 / 44100.0;
+            const double S     = 0.4845;
+            const double cw    = std::cos(w0);
+            const double sA    = std::sqrt(A);
+            const double alpha = std::sin(w0) / 2.0 * std::sqrt((A + 1.0 / A) * (1.0 / S - 1.0) + 2.0);
+            const double a0    = (A + 1.0) - (A - 1.0) * cw + 2.0 * sA * alpha;
+
+            b0 = A * ((A + 1.0) + (A - 1.0) * cw + 2.0 * sA * alpha) / a0;
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw) / a0;
+            b2 = A * ((A + 1.0) + (A - 1.0) * cw - 2.0 * sA * alpha) / a0;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw) / a0;
+            a2 = ((A + 1.0) - (A - 1.0) * cw - 2.0 * sA * alpha) / a0;
+        }
+    };
+
+    const SDeEmphCoeff& coeff()
+    {
+        static const SDeEmphCoeff c;
+        return c;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create filter
+//------------------------------------------------------------------------------
+CDeEmphasis::CDeEmphasis()
+{
+    start();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      start a new track
+//------------------------------------------------------------------------------
+void CDeEmphasis::start()
+{
+    std::fill(&mX[0][0], &mX[0][0] + 4, 0.0);
+    std::fill(&mY[0][0], &mY[0][0] + 4, 0.0);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      filter PCM data in place (multiple of 4 bytes, in track
+//!             order)
+//!
+//! @param      data   PCM data
+//! @param[in]  bytes  size of data in bytes
+//------------------------------------------------------------------------------
+void CDeEmphasis::process(void* data, size_t bytes)
+{
+    int16_t*            s      = static_cast<int16_t*>(data);
+    size_t              frames = bytes / 4;
+    const SDeEmphCoeff& c      = coeff();
+
+#if defined(DEEMPH_SSE2)
+    const __m128d b0 = _mm_set1_pd(c.b0);
+    const __m128d b1 = _mm_set1_pd(c.b1);
+    const __m128d b2 = _mm_set1_pd(c.b2);
+    const __m128d a1 = _mm_set1_pd(c.a1);
+    const __m128d a2 = _mm_set1_pd(c.a2);
+    __m128d       x1 = _mm_loadu_pd(mX[0]), x2 = _mm_loadu_pd(mX[1]);
+    __m128d       y1 = _mm_loadu_pd(mY[0]), y2 = _mm_loadu_pd(mY[1]);
+
+    for (size_t f = 0; f < frames; f++)
+    {
+        int32_t in;
+        std::copy_n(reinterpret_cast<const char*>(s + f * 2), 4, reinterpret_cast<char*>(&in));
+
+        // L/R -> 2 x int32 -> 2 x double
+        __m128i v = _mm_cvtsi32_si128(in);
+        v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128d x = _mm_cvtepi32_pd(v);
+
+        // feed forward part doesn't depend on the last output
+        __m128d ff = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b0, x), _mm_mul_pd(b1, x1)), _mm_mul_pd(b2, x2));
+        __m128d y  = _mm_sub_pd(ff, _mm_add_pd(_mm_mul_pd(a1, y1), _mm_mul_pd(a2, y2)));
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+
+        // round (to nearest) and saturate
+        v  = _mm_cvtpd_epi32(y);
+        v  = _mm_packs_epi32(v, v);
+        in = _mm_cvtsi128_si32(v);
+        std::copy_n(reinterpret_cast<const char*>(&in), 4, reinterpret_cast<char*>(s + f * 2));
+    }
+
+    _mm_storeu_pd(mX[0], x1);
+    _mm_storeu_pd(mX[1], x2);
+    _mm_storeu_pd(mY[0], y1);
+    _mm_storeu_pd(mY[1], y2);
+#else
+    for (size_t f = 0; f < frames; f++)
+    {
+        for (int ch = 0; ch < 2; ch++)
+        {
+            double x = s[f * 2 + ch];
+            double y = c.b0 * x + c.b1 * mX[0][ch] + c.b2 * mX[1][ch] - c.a1 * mY[0][ch] - c.a2 * mY[1][ch];
+            mX[1][ch] = mX[0][ch];
+            mX[0][ch] = x;
+            mY[1][ch] = mY[0][ch];
+            mY[0][ch] = y;
+
+            y = std::nearbyint(y);
+            s[f * 2 + ch] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, y)));
+        }
+    }
+#endif
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+//! @brief      Streaming de-emphasis filter (50/15 us) for 16 bit stereo PCM
+//!             at 44.1 kHz, applied in place. Both channels run through one
+//!             SSE2 register where available.
+//------------------------------------------------------------------------------
+class CDeEmphasis
+{
+public:
+    CDeEmphasis();
+
+    //--------------------------------------------------------------------------
+    //! @brief      start a new track
+    //--------------------------------------------------------------------------
+    void start();
+
+    //--------------------------------------------------------------------------
+    //! @brief      filter PCM data in place (multiple of 4 bytes, in track
+    //!             order)
+    //!
+    //! @param      data   PCM data
+    //! @param[in]  bytes  size of data in bytes
+    //--------------------------------------------------------------------------
+    void process(void* data, size_t bytes);
+
+private:
+    double mX[2][2];   ///< last two inputs (L/R)
+    double mY[2][2];   ///< last two outputs (L/R)
+};
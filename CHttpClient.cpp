@@ -0,0 +1,660 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include "WinHttpWrapper.h"
+    typedef SOCKET Socket_t;
+    #define closeSocket closesocket
+    #define SEND_FLAGS  0
+    #define SHUT_RDWR   SD_BOTH
+#else
+    #include <netdb.h>
+    #include <sys/socket.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+    typedef int Socket_t;
+    #define INVALID_SOCKET (-1)
+    #define closeSocket ::close
+    #define SEND_FLAGS  MSG_NOSIGNAL
+#endif
+
+#ifdef C2N_OPENSSL
+    #include <csignal>
+    #include <openssl/err.h>
+    #include <openssl/ssl.h>
+#endif
+
+#include "CHttpClient.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+//------------------------------------------------------------------------------
+//! @brief      initialize winsock once per process
+//------------------------------------------------------------------------------
+static void wsaInit()
+{
+    struct SWsaInit
+    {
+        SWsaInit()
+        {
+            WSADATA wsaData;
+            WSAStartup(MAKEWORD(2, 2), &wsaData);
+        }
+        ~SWsaInit()
+        {
+            WSACleanup();
+        }
+    };
+    static SWsaInit init;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      HTTP client using WinHTTP (supports https)
+//------------------------------------------------------------------------------
+class CWinHttpClient : public CHttpClient
+{
+    WinHttpWrapper::HttpRequest mReq;
+
+public:
+    CWinHttpClient(const SHttpUrl& url)
+        : mReq(std::wstring(url.mHost.begin(), url.mHost.end()), url.mPort, url.mSecure)
+    {
+    }
+
+    bool get(const std::string& pathAndQuery, SHttpResult& result) override
+    {
+        WinHttpWrapper::HttpResponse resp;
+        bool ret = mReq.Get(std::wstring(pathAndQuery.begin(), pathAndQuery.end()),
+                            L"Content-Type: text/plain; charset=utf-8", resp);
+
+        result.mStatus  = static_cast<int>(resp.statusCode);
+        result.mBody    = resp.text;
+        result.mLatency = resp.latency;
+        result.mReused  = resp.reused;
+
+        // error texts are plain ASCII
+        result.mError.clear();
+        for (const auto& c : resp.error)
+        {
+            result.mError += static_cast<char>(c);
+        }
+
+        return ret;
+    }
+
+    void setTimeout(uint32_t ms) override
+    {
+        int t = static_cast<int>(ms);
+        mReq.SetTimeouts(t, t, t, t);
+    }
+
+    void cancel() override
+    {
+        mReq.Cancel();
+    }
+
+    void arm() override
+    {
+        mReq.Arm();
+    }
+};
+#endif // _WIN32
+
+//------------------------------------------------------------------------------
+//! @brief      HTTP/1.1 client on plain BSD sockets / winsock; TLS through
+//!             OpenSSL if built with C2N_OPENSSL. Keeps the connection open
+//!             (keep-alive) as long as the server allows it.
+//------------------------------------------------------------------------------
+class CSocketHttpClient : public CHttpClient
+{
+    SHttpUrl    mUrl;
+    Socket_t    mSock    = INVALID_SOCKET;
+    std::string mRx;        ///< received, not yet consumed bytes
+    uint32_t    mTimeout = 0;
+    std::mutex  mSockMtx;   ///< guards socket handle against cancel()
+    std::atomic_bool mCancelled{false}; ///< set by cancel(), reset by arm(); stops any retry
+#ifdef C2N_OPENSSL
+    SSL_CTX*    mSslCtx  = nullptr;
+    SSL*        mSsl     = nullptr;  ///< TLS session on mSock (https only)
+#endif
+
+public:
+    CSocketHttpClient(const SHttpUrl& url) : mUrl(url)
+    {
+#ifdef _WIN32
+        wsaInit();
+#endif
+#ifdef C2N_OPENSSL
+        if (mUrl.mSecure && ((mSslCtx = SSL_CTX_new(TLS_client_method())) != nullptr))
+        {
+            // system trust store (or SSL_CERT_FILE / SSL_CERT_DIR)
+            SSL_CTX_set_default_verify_paths(mSslCtx);
+            SSL_CTX_set_verify(mSslCtx, SSL_VERIFY_PEER, nullptr);
+            SSL_CTX_set_min_proto_version(mSslCtx, TLS1_2_VERSION);
+#ifndef _WIN32
+            // OpenSSL writes w/o MSG_NOSIGNAL; a server closing a kept
+            // alive connection must not kill us
+            std::signal(SIGPIPE, SIG_IGN);
+#endif
+        }
+#endif
+    }
+
+    ~CSocketHttpClient() override
+    {
+        disconnect();
+#ifdef C2N_OPENSSL
+        if (mSslCtx != nullptr)
+        {
+            SSL_CTX_free(mSslCtx);
+        }
+#endif
+    }
+
+    bool get(const std::string& pathAndQuery, SHttpResult& result) override
+    {
+        auto start     = std::chrono::steady_clock::now();
+        bool ret       = false;
+        bool keepAlive = true;
+        std::string req = "GET " + pathAndQuery + " HTTP/1.1\r\n"
+                          "Host: " + mUrl.mHost + "\r\n"
+                          "User-Agent: cd2netmd\r\n"
+                          "Accept: text/plain\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+
+        result = SHttpResult{};
+        result.mReused = (mSock != INVALID_SOCKET);
+
+        // a reused connection might have been closed by the server
+        // in the meantime -> one retry on a fresh connection
+        for (int attempt = 0; (attempt < 2) && !ret && !mCancelled; attempt++)
+        {
+            if ((mSock == INVALID_SOCKET) && !connectServer(result.mError))
+            {
+                break;
+            }
+
+            if (sendAll(req) && readResponse(result, keepAlive))
+            {
+                ret = true;
+            }
+            else
+            {
+                disconnect();
+
+                // the failure was caused by cancel() -> don't send again
+                if (mCancelled)
+                {
+                    result.mError = "Request cancelled";
+                    break;
+                }
+
+                if (!result.mReused)
+                {
+                    break;
+                }
+                result.mReused = false;
+            }
+        }
+
+        if (!ret && mCancelled && result.mError.empty())
+        {
+            result.mError = "Request cancelled";
+        }
+
+        if (!ret && result.mError.empty())
+        {
+            result.mError = "Error while talking to " + mUrl.mHost;
+        }
+
+        if (!keepAlive)
+        {
+            disconnect();
+        }
+
+        result.mLatency = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        return ret;
+    }
+
+    void setTimeout(uint32_t ms) override
+    {
+        mTimeout = ms;
+    }
+
+    void cancel() override
+    {
+        std::lock_guard<std::mutex> lk(mSockMtx);
+        mCancelled = true;
+        if (mSock != INVALID_SOCKET)
+        {
+            // wakes up a blocking send / recv in the requesting thread
+            shutdown(mSock, SHUT_RDWR);
+        }
+    }
+
+    void arm() override
+    {
+        mCancelled = false;
+    }
+
+private:
+    //! apply send / receive timeout to socket
+    void applyTimeout(Socket_t sock)
+    {
+        if (mTimeout > 0)
+        {
+#ifdef _WIN32
+            DWORD tv = mTimeout;
+#else
+            struct timeval tv;
+            tv.tv_sec  = mTimeout / 1000;
+            tv.tv_usec = (mTimeout % 1000) * 1000;
+#endif
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+            setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+        }
+    }
+
+    bool connectServer(std::string& error)
+    {
+        struct addrinfo hints;
+        struct addrinfo* res = nullptr;
+        std::string port = std::to_string(mUrl.mPort);
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        if (getaddrinfo(mUrl.mHost.c_str(), port.c_str(), &hints, &res) != 0)
+        {
+            error = "Can't resolve " + mUrl.mHost;
+            return false;
+        }
+
+        Socket_t sock = INVALID_SOCKET;
+
+        for (struct addrinfo* ai = res; ai != nullptr; ai = ai->ai_next)
+        {
+            sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+            if (sock == INVALID_SOCKET)
+            {
+                continue;
+            }
+
+            applyTimeout(sock);
+
+            if (connect(sock, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0)
+            {
+                break;
+            }
+
+            closeSocket(sock);
+            sock = INVALID_SOCKET;
+        }
+
+        freeaddrinfo(res);
+
+        {
+            // cancel() came in while connecting
+            std::lock_guard<std::mutex> lk(mSockMtx);
+            if ((sock != INVALID_SOCKET) && mCancelled)
+            {
+                closeSocket(sock);
+                sock = INVALID_SOCKET;
+            }
+            mSock = sock;
+        }
+
+        if (mCancelled)
+        {
+            error = "Request cancelled";
+            return false;
+        }
+
+        if (mSock == INVALID_SOCKET)
+        {
+            error = "Can't connect to " + mUrl.mHost + ":" + port;
+            return false;
+        }
+
+        mRx.clear();
+
+        // handshake runs on the published socket, so cancel() can stop it
+        if (mUrl.mSecure && !startTls(error))
+        {
+            disconnect();
+            return false;
+        }
+
+        return true;
+    }
+
+    //! TLS handshake incl. certificate and host name check
+    bool startTls(std::string& error)
+    {
+#ifdef C2N_OPENSSL
+        if ((mSslCtx == nullptr) || ((mSsl = SSL_new(mSslCtx)) == nullptr))
+        {
+            error = "Can't create TLS session";
+            return false;
+        }
+
+        SSL_set_fd(mSsl, static_cast<int>(mSock));
+        SSL_set_tlsext_host_name(mSsl, mUrl.mHost.c_str());
+        SSL_set1_host(mSsl, mUrl.mHost.c_str());
+
+        if (SSL_connect(mSsl) != 1)
+        {
+            long vr = SSL_get_verify_result(mSsl);
+            error   = "TLS handshake with " + mUrl.mHost + " failed";
+
+            if (vr != X509_V_OK)
+            {
+                error += std::string(": ") + X509_verify_cert_error_string(vr);
+            }
+            ERR_clear_error();
+            return false;
+        }
+        return true;
+#else
+        error = "No TLS support for " + mUrl.mHost;
+        return false;
+#endif
+    }
+
+    void disconnect()
+    {
+        std::lock_guard<std::mutex> lk(mSockMtx);
+#ifdef C2N_OPENSSL
+        if (mSsl != nullptr)
+        {
+            SSL_free(mSsl);
+            mSsl = nullptr;
+        }
+#endif
+        if (mSock != INVALID_SOCKET)
+        {
+            closeSocket(mSock);
+            mSock = INVALID_SOCKET;
+        }
+        mRx.clear();
+    }
+
+    bool sendAll(const std::string& data)
+    {
+        size_t sent = 0;
+
+        while (sent < data.size())
+        {
+#ifdef C2N_OPENSSL
+            int rc = (mSsl != nullptr)
+                ? SSL_write(mSsl, data.c_str() + sent, static_cast<int>(data.size() - sent))
+                : send(mSock, data.c_str() + sent, static_cast<int>(data.size() - sent), SEND_FLAGS);
+#else
+            int rc = send(mSock, data.c_str() + sent, static_cast<int>(data.size() - sent), SEND_FLAGS);
+#endif
+
+            if (rc <= 0)
+            {
+                return false;
+            }
+            sent += rc;
+        }
+        return true;
+    }
+
+    //! read more data into receive buffer; false on close / error
+    bool receive()
+    {
+        char buff[4096];
+#ifdef C2N_OPENSSL
+        int rc = (mSsl != nullptr) ? SSL_read(mSsl, buff, sizeof(buff)) : recv(mSock, buff, sizeof(buff), 0);
+#else
+        int rc = recv(mSock, buff, sizeof(buff), 0);
+#endif
+
+        if (rc <= 0)
+        {
+            return false;
+        }
+
+        mRx.append(buff, rc);
+        return true;
+    }
+
+    //! make sure the receive buffer holds at least count bytes
+    bool fill(size_t count)
+    {
+        while (mRx.size() < count)
+        {
+            if (!receive())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! get position of delimiter in receive buffer, reads as needed
+    bool fillUntil(const char* delim, size_t& pos)
+    {
+        while ((pos = mRx.find(delim)) == std::string::npos)
+        {
+            if (!receive())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool readResponse(SHttpResult& result, bool& keepAlive)
+    {
+        size_t pos;
+        long   contentLength = -1;
+        bool   chunked       = false;
+
+        if (!fillUntil("\r\n\r\n", pos))
+        {
+            return false;
+        }
+
+        std::string head = mRx.substr(0, pos + 2);
+        mRx.erase(0, pos + 4);
+
+        // status line: HTTP/1.1 200 OK
+        if ((head.compare(0, 5, "HTTP/") != 0) || ((pos = head.find(' ')) == std::string::npos))
+        {
+            result.mError = "Invalid HTTP response";
+            return false;
+        }
+
+        result.mStatus = std::atoi(head.c_str() + pos + 1);
+        keepAlive      = (head.compare(0, 8, "HTTP/1.0") != 0);
+
+        // header lines
+        size_t line = head.find("\r\n") + 2;
+        while ((pos = head.find("\r\n", line)) != std::string::npos)
+        {
+            std::string hdr = head.substr(line, pos - line);
+            line = pos + 2;
+
+            std::transform(hdr.begin(), hdr.end(), hdr.begin(),
+                [](unsigned char c){ return std::tolower(c); });
+
+            if (hdr.compare(0, 15, "content-length:") == 0)
+            {
+                contentLength = std::atol(hdr.c_str() + 15);
+            }
+            else if ((hdr.compare(0, 18, "transfer-encoding:") == 0) && (hdr.find("chunked") != std::string::npos))
+            {
+                chunked = true;
+            }
+            else if (hdr.compare(0, 11, "connection:") == 0)
+            {
+                if (hdr.find("close") != std::string::npos)
+                {
+                    keepAlive = false;
+                }
+                else if (hdr.find("keep-alive") != std::string::npos)
+                {
+                    keepAlive = true;
+                }
+            }
+        }
+
+        if (chunked)
+        {
+            long chunkSz;
+            do
+            {
+                if (!fillUntil("\r\n", pos))
+                {
+                    return false;
+                }
+
+                chunkSz = std::strtol(mRx.c_str(), nullptr, 16);
+                mRx.erase(0, pos + 2);
+
+                if (chunkSz > 0)
+                {
+                    if (!fill(chunkSz + 2))
+                    {
+                        return false;
+                    }
+                    result.mBody.append(mRx, 0, chunkSz);
+                    mRx.erase(0, chunkSz + 2);
+                }
+            }
+            while (chunkSz > 0);
+
+            // skip trailers up to the empty line
+            while (fillUntil("\r\n", pos) && (pos > 0))
+            {
+                mRx.erase(0, pos + 2);
+            }
+            mRx.erase(0, 2);
+        }
+        else if (contentLength >= 0)
+        {
+            if (!fill(contentLength))
+            {
+                return false;
+            }
+            result.mBody = mRx.substr(0, contentLength);
+            mRx.erase(0, contentLength);
+        }
+        else
+        {
+            // body ends with connection close
+            while (receive());
+            result.mBody = mRx;
+            mRx.clear();
+            keepAlive = false;
+        }
+
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+//! @brief      parse a server URL (http[s]://host[:port][/path])
+//!
+//! @param[in]  url   The url
+//! @param[out] out   The parsed url
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+bool CHttpClient::parseUrl(const std::string& url, SHttpUrl& out)
+{
+    size_t pos, hostStart;
+
+    if (url.compare(0, 8, "https://") == 0)
+    {
+        out.mSecure = true;
+        out.mPort   = 443;
+        hostStart   = 8;
+    }
+    else if (url.compare(0, 7, "http://") == 0)
+    {
+        out.mSecure = false;
+        out.mPort   = 80;
+        hostStart   = 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    std::string host = url.substr(hostStart);
+
+    if ((pos = host.find('/')) != std::string::npos)
+    {
+        out.mPath = host.substr(pos);
+        host.erase(pos);
+    }
+    else
+    {
+        out.mPath = "/";
+    }
+
+    if ((pos = host.rfind(':')) != std::string::npos)
+    {
+        out.mPort = std::atoi(host.c_str() + pos + 1);
+        host.erase(pos);
+    }
+
+    out.mHost = host;
+
+    return !out.mHost.empty() && (out.mPort > 0);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create a client for the given server
+//!             (https -> WinHTTP on Windows, sockets backend with OpenSSL
+//!             elsewhere; http -> plain sockets backend)
+//!
+//! @param[in]  url   server url
+//!
+//! @return     client; nullptr if URL isn't supported on this platform
+//------------------------------------------------------------------------------
+std::unique_ptr<CHttpClient> CHttpClient::create(const SHttpUrl& url)
+{
+    if (url.mSecure)
+    {
+#if defined(_WIN32)
+        return std::unique_ptr<CHttpClient>(new CWinHttpClient(url));
+#elif defined(C2N_OPENSSL)
+        return std::unique_ptr<CHttpClient>(new CSocketHttpClient(url));
+#else
+        // built without TLS backend
+        return nullptr;
+#endif
+    }
+
+    return std::unique_ptr<CHttpClient>(new CSocketHttpClient(url));
+}
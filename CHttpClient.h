@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/// result of a HTTP request
+struct SHttpResult
+{
+    int         mStatus  = 0;     ///< HTTP status code
+    std::string mBody;            ///< response body
+    std::string mError;           ///< error text (if any)
+    uint32_t    mLatency = 0;     ///< request start until last byte read in ms
+    bool        mReused  = false; ///< request used an already open connection
+};
+
+/// parsed server URL
+struct SHttpUrl
+{
+    bool        mSecure = false;  ///< https
+    std::string mHost;            ///< host name
+    int         mPort   = 80;     ///< port
+    std::string mPath;            ///< path (at least "/")
+};
+
+//------------------------------------------------------------------------------
+//! @brief      Platform neutral HTTP client interface.
+//!             One client talks to one server and keeps the connection
+//!             open between requests where possible.
+//------------------------------------------------------------------------------
+class CHttpClient
+{
+public:
+    virtual ~CHttpClient() = default;
+
+    //--------------------------------------------------------------------------
+    //! @brief      do a GET request
+    //!
+    //! @param[in]  pathAndQuery  path and query of the request
+    //! @param[out] result        The result
+    //!
+    //! @return     true -> request done (check status code); false -> error
+    //--------------------------------------------------------------------------
+    virtual bool get(const std::string& pathAndQuery, SHttpResult& result) = 0;
+
+    //--------------------------------------------------------------------------
+    //! @brief      set timeout for connect, send and receive
+    //!
+    //! @param[in]  ms    timeout in milliseconds (0 -> system default)
+    //--------------------------------------------------------------------------
+    virtual void setTimeout(uint32_t ms) = 0;
+
+    //--------------------------------------------------------------------------
+    //! @brief      abort a running request (may be called from another thread);
+    //!             the request fails and isn't retried
+    //--------------------------------------------------------------------------
+    virtual void cancel() = 0;
+
+    //--------------------------------------------------------------------------
+    //! @brief      reset the cancel state before a request is started; must
+    //!             not be called while get() runs. get() itself never resets
+    //!             it, so a cancel() between arm() and get() isn't lost.
+    //--------------------------------------------------------------------------
+    virtual void arm() = 0;
+
+    //--------------------------------------------------------------------------
+    //! @brief      parse a server URL (http[s]://host[:port][/path])
+    //!
+    //! @param[in]  url   The url
+    //! @param[out] out   The parsed url
+    //!
+    //! @return     true on success
+    //--------------------------------------------------------------------------
+    static bool parseUrl(const std::string& url, SHttpUrl& out);
+
+    //--------------------------------------------------------------------------
+    //! @brief      create a client for the given server
+    //!             (https -> WinHTTP on Windows, sockets backend with OpenSSL
+    //!             elsewhere; http -> plain sockets backend)
+    //!
+    //! @param[in]  url   server url
+    //!
+    //! @return     client; nullptr if URL isn't supported on this platform
+    //--------------------------------------------------------------------------
+    static std::unique_ptr<CHttpClient> create(const SHttpUrl& url);
+};
@@ -0,0 +1,483 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CLoudness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LOUD_SSE2
+#endif
+
+namespace
+{
+    /// biquad coefficients b0, b1, b2, a1, a2
+    struct SBiquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      K-weighting filter stages for a sample rate (BS.1770)
+    //--------------------------------------------------------------------------
+    void kWeighting(double rate, SBiquad& shelf, SBiquad& hp)
+    {
+        const double pi = 3.14159265358979323846;
+
+        // stage 1: high shelf
+        double f0 = 1681.974450955533;
+        double G  = 3.999843853973347;
+        double Q  = 0.7071752369554196;
+        double K  = std::tan(pi * f0 / rate);
+        double Vh = std::pow(10.0, G / 20.0);
+        double Vb = std::pow(Vh, 0.4996667741545416);
+        double a0 = 1.0 + K / Q + K * K;
+
+        shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+        shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+        shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+        // stage 2: high pass
+        f0 = 38.13547087602444;
+        Q  = 0.5003270373238773;
+        K  = std::tan(pi * f0 / rate);
+        a0 = 1.0 + K / Q + K * K;
+
+        hp.b0 = 1.0;
+        hp.b1 = -2.0;
+        hp.b2 = 1.0;
+        hp.a1 = 2.0 * (K * K - 1.0) / a0;
+        hp.a2 = (1.0 - K / Q + K * K) / a0;
+    }
+
+    /// K-weighting for 44.1 kHz
+    struct SKFilter
+    {
+        SBiquad shelf, hp;
+        SKFilter() { kWeighting(44100.0, shelf, hp); }
+    };
+
+    const SKFilter& kFilter()
+    {
+        static const SKFilter f;
+        return f;
+    }
+
+    /// true peak interpolation (BS.1770-4 annex 2), 4 phases * 12 taps
+    const double TP_COEFF[4][12] = {
+        { 0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000,
+         -0.0594482421875,  0.1373291015625,  0.9721679687500, -0.1022949218750,
+          0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500},
+        {-0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250,
+         -0.1665039062500,  0.4650878906250,  0.7797851562500, -0.2003173828125,
+          0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375},
+        {-0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000,
+         -0.2003173828125,  0.7797851562500,  0.4650878906250, -0.1665039062500,
+          0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875},
+        {-0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750,
+         -0.1022949218750,  0.9721679687500,  0.1373291015625, -0.0594482421875,
+          0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750},
+    };
+
+    constexpr uint32_t TP_TAPS = 12;
+
+    //--------------------------------------------------------------------------
+    //! @brief      max. abs. interpolated value of the 4 phases
+    //!
+    //! @param[in]  h     history, oldest first (TP_TAPS frames, L/R)
+    //!
+    //! @return     peak of both channels
+    //--------------------------------------------------------------------------
+    inline double tpPeak(const double (*h)[2])
+    {
+#if defined(LOUD_SSE2)
+        __m128d peak = _mm_setzero_pd();
+        __m128d sign = _mm_set1_pd(-0.0);
+
+        for (int p = 0; p < 4; p++)
+        {
+            __m128d acc = _mm_setzero_pd();
+            for (uint32_t t = 0; t < TP_TAPS; t++)
+            {
+                acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(h[t]), _mm_set1_pd(TP_COEFF[p][TP_TAPS - 1 - t])));
+            }
+            peak = _mm_max_pd(peak, _mm_andnot_pd(sign, acc));
+        }
+
+        double r[2];
+        _mm_storeu_pd(r, peak);
+        return std::max(r[0], r[1]);
+#else
+        double peak = 0.0;
+        for (int p = 0; p < 4; p++)
+        {
+            double l = 0.0, r = 0.0;
+            for (uint32_t t = 0; t < TP_TAPS; t++)
+            {
+                l += h[t][0] * TP_COEFF[p][TP_TAPS - 1 - t];
+                r += h[t][1] * TP_COEFF[p][TP_TAPS - 1 - t];
+            }
+            peak = std::max(peak, std::max(std::fabs(l), std::fabs(r)));
+        }
+        return peak;
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      block energy -> loudness
+    //--------------------------------------------------------------------------
+    inline double lufs(double energy)
+    {
+        return -0.691 + 10.0 * std::log10(energy);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create meter
+//------------------------------------------------------------------------------
+CLoudness::CLoudness()
+{
+    start();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      start a new track
+//------------------------------------------------------------------------------
+void CLoudness::start()
+{
+    memset(mState, 0, sizeof(mState));
+    memset(mHist, 0, sizeof(mHist));
+    memset(mSteps, 0, sizeof(mSteps));
+    mHistPos    = 0;
+    mPeak       = 0.0;
+    mStepSum    = 0.0;
+    mStepFrames = 0;
+    mStepCount  = 0;
+    mBlocks.clear();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      add PCM data (multiple of 4 bytes, in track order)
+//!
+//! @param[in]  data   PCM data
+//! @param[in]  bytes  size of data in bytes
+//------------------------------------------------------------------------------
+void CLoudness::update(const void* data, size_t bytes)
+{
+    const int16_t*  s      = static_cast<const int16_t*>(data);
+    size_t          frames = bytes / 4;
+    const SBiquad&  k1     = kFilter().shelf;
+    const SBiquad&  k2     = kFilter().hp;
+    const double    scale  = 1.0 / 32768.0;
+
+#if defined(LOUD_SSE2)
+    // both channels in one register: transposed direct form II
+    __m128d z1a = _mm_loadu_pd(mState[0]), z2a = _mm_loadu_pd(mState[1]);
+    __m128d z1b = _mm_loadu_pd(mState[2]), z2b = _mm_loadu_pd(mState[3]);
+    __m128d sum = _mm_setzero_pd();
+    const __m128d b0a = _mm_set1_pd(k1.b0), b1a = _mm_set1_pd(k1.b1), b2a = _mm_set1_pd(k1.b2);
+    const __m128d a1a = _mm_set1_pd(k1.a1), a2a = _mm_set1_pd(k1.a2);
+    const __m128d b0b = _mm_set1_pd(k2.b0), b1b = _mm_set1_pd(k2.b1), b2b = _mm_set1_pd(k2.b2);
+    const __m128d a1b = _mm_set1_pd(k2.a1), a2b = _mm_set1_pd(k2.a2);
+#endif
+
+    for (size_t f = 0; f < frames; f++)
+    {
+        double l = s[f * 2] * scale;
+        double r = s[f * 2 + 1] * scale;
+
+        // true peak
+        mHist[mHistPos][0] = mHist[mHistPos + TP_TAPS][0] = l;
+        mHist[mHistPos][1] = mHist[mHistPos + TP_TAPS][1] = r;
+        mHistPos = (mHistPos + 1) % TP_TAPS;
+        mPeak    = std::max(mPeak, tpPeak(&mHist[mHistPos]));
+
+#if defined(LOUD_SSE2)
+        __m128d x = _mm_set_pd(r, l);
+        __m128d y = _mm_add_pd(_mm_mul_pd(b0a, x), z1a);
+        z1a = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(b1a, x), z2a), _mm_mul_pd(a1a, y));
+        z2a = _mm_sub_pd(_mm_mul_pd(b2a, x), _mm_mul_pd(a2a, y));
+
+        x   = y;
+        y   = _mm_add_pd(_mm_mul_pd(b0b, x), z1b);
+        z1b = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(b1b, x), z2b), _mm_mul_pd(a1b, y));
+        z2b = _mm_sub_pd(_mm_mul_pd(b2b, x), _mm_mul_pd(a2b, y));
+
+        sum = _mm_add_pd(sum, _mm_mul_pd(y, y));
+#else
+        double in[2] = {l, r};
+        for (int c = 0; c < 2; c++)
+        {
+            double y = k1.b0 * in[c] + mState[0][c];
+            mState[0][c] = k1.b1 * in[c] + mState[1][c] - k1.a1 * y;
+            mState[1][c] = k1.b2 * in[c] - k1.a2 * y;
+
+            double x = y;
+            y = k2.b0 * x + mState[2][c];
+            mState[2][c] = k2.b1 * x + mState[3][c] - k2.a1 * y;
+            mState[3][c] = k2.b2 * x - k2.a2 * y;
+
+            mStepSum += y * y;
+        }
+#endif
+
+        // 100 ms step done -> new 400 ms block (75% overlap)
+        if (++mStepFrames == STEP_FRAMES)
+        {
+#if defined(LOUD_SSE2)
+            double part[2];
+            _mm_storeu_pd(part, sum);
+            mStepSum += part[0] + part[1];
+            sum = _mm_setzero_pd();
+#endif
+            mSteps[mStepCount % 4] = mStepSum;
+            mStepSum   = 0.0;
+            mStepFrames = 0;
+
+            if (++mStepCount >= 4)
+            {
+                mBlocks.push_back((mSteps[0] + mSteps[1] + mSteps[2] + mSteps[3]) / (4.0 * STEP_FRAMES));
+            }
+        }
+    }
+
+#if defined(LOUD_SSE2)
+    double part[2];
+    _mm_storeu_pd(part, sum);
+    mStepSum += part[0] + part[1];
+
+    _mm_storeu_pd(mState[0], z1a);
+    _mm_storeu_pd(mState[1], z2a);
+    _mm_storeu_pd(mState[2], z1b);
+    _mm_storeu_pd(mState[3], z2b);
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! @brief      true peak in dBTP
+//------------------------------------------------------------------------------
+double CLoudness::truePeak() const
+{
+    return (mPeak > 0.0) ? (20.0 * std::log10(mPeak)) : SILENCE_LUFS;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      gated integrated loudness of a set of blocks
+//!
+//! @param[in]  blocks  block energies (e.g. of all tracks of an album)
+//!
+//! @return     loudness in LUFS; SILENCE_LUFS if all blocks are gated
+//------------------------------------------------------------------------------
+double CLoudness::integrated(const std::vector<double>& blocks)
+{
+    // absolute gate -70 LUFS
+    const double absGate = std::pow(10.0, (-70.0 + 0.691) / 10.0);
+    double sum = 0.0;
+    size_t cnt = 0;
+
+    for (double e : blocks)
+    {
+        if (e > absGate)
+        {
+            sum += e;
+            cnt++;
+        }
+    }
+
+    if (cnt == 0)
+    {
+        return SILENCE_LUFS;
+    }
+
+    // relative gate 10 LU below the absolute gated loudness
+    const double relGate = (sum / cnt) * 0.1;
+    double relSum = 0.0;
+    size_t relCnt = 0;
+
+    for (double e : blocks)
+    {
+        if ((e > absGate) && (e > relGate))
+        {
+            relSum += e;
+            relCnt++;
+        }
+    }
+
+    return (relCnt > 0) ? lufs(relSum / relCnt) : SILENCE_LUFS;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      apply gain to a wave file; a look-ahead limiter keeps the
+//!             true peak below the ceiling. The result is written to a
+//!             temporary file which replaces the wave file when done, so a
+//!             failure leaves the file untouched.
+//!
+//! @param[in]  path       wave file (44 byte header, 16 bit stereo)
+//! @param[in]  gainDb     gain in dB
+//! @param[in]  ceilingDb  max. true peak in dBTP
+//! @param[in]  peakDb     true peak of file before gain (limiter is
+//!                        skipped if gain can't exceed the ceiling)
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+bool CLoudness::applyGain(const std::string& path, double gainDb, double ceilingDb, double peakDb)
+{
+    constexpr size_t   HEADER = 44;
+    constexpr uint32_t LA     = 64;              ///< look-ahead (frames)
+    constexpr uint32_t DELAY  = LA + LA / 2;     ///< min filter + smoothing
+    constexpr uint32_t RING   = 256;             ///< ring size (> 2 * LA + 1)
+    constexpr size_t   CHUNK  = 16384;           ///< frames per file access
+
+    const std::string tmp = path + ".gain";
+    std::ifstream f(path, std::ios::binary);
+    std::ofstream o(tmp, std::ios::binary | std::ios::trunc);
+    char header[HEADER];
+
+    if (!f || !o || !f.read(header, HEADER) || !o.write(header, HEADER))
+    {
+        o.close();
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    const double gain    = std::pow(10.0, gainDb / 20.0);
+    const double ceiling = std::pow(10.0, ceilingDb / 20.0);
+    const bool   limit   = (peakDb + gainDb) > ceilingDb;
+    const double release = 1.0 / (0.05 * 44100.0); ///< full recovery in 50 ms
+
+    // limiter state
+    double   smp[RING][2] = {};       ///< delayed input
+    double   hist[TP_TAPS * 2][2] = {};
+    uint32_t histPos = 0;
+    double   minVal[RING];            ///< monotonic queue for sliding min
+    uint64_t minIdx[RING];
+    uint32_t qHead = 0, qTail = 0;
+    double   mn[RING];                ///< sliding min values
+    double   boxSum = 0.0;
+    double   g      = 1.0;
+
+    std::vector<int16_t> in(CHUNK * 2), out(CHUNK * 2);
+    uint64_t inFrames = 0, outFrames = 0, pushed = 0, total;
+    bool     ok = true;
+
+    f.seekg(0, std::ios::end);
+    total = (static_cast<uint64_t>(f.tellg()) - HEADER) / 4;
+    f.seekg(HEADER);
+
+    // one frame into the limiter; emits the frame DELAY frames back
+    auto push = [&](double l, double r, size_t& nOut)
+    {
+        uint64_t n = pushed++;
+        l *= gain;
+        r *= gain;
+        smp[n % RING][0] = l;
+        smp[n % RING][1] = r;
+
+        double req = 1.0;
+        if (limit)
+        {
+            hist[histPos][0] = hist[histPos + TP_TAPS][0] = l;
+            hist[histPos][1] = hist[histPos + TP_TAPS][1] = r;
+            histPos = (histPos + 1) % TP_TAPS;
+            double pk = std::max(tpPeak(&hist[histPos]), std::max(std::fabs(l), std::fabs(r)));
+            req = (pk > ceiling) ? (ceiling / pk) : 1.0;
+        }
+
+        // sliding min over [n - 2 * LA, n] -> value for frame n - LA
+        while ((qTail != qHead) && (minVal[(qTail - 1) % RING] >= req)) qTail--;
+        minVal[qTail % RING] = req;
+        minIdx[qTail % RING] = n;
+        qTail++;
+        while ((minIdx[qHead % RING] + 2 * LA) < n) qHead++;
+
+        if (n < LA) return;
+        uint64_t c = n - LA;
+        mn[c % RING] = minVal[qHead % RING];
+        boxSum += mn[c % RING];
+        if (c > LA) boxSum -= mn[(c - LA - 1) % RING];
+        if (c < LA) return;
+
+        // box average over [c - LA, c] -> gain for frame c - LA / 2
+        uint64_t b  = c - LA / 2;
+        double   gb = boxSum / (LA + 1);
+        g = std::min(gb, g + release);
+
+        if ((b >= DELAY) && ((b - DELAY) < total))
+        {
+            for (int ch = 0; ch < 2; ch++)
+            {
+                double v = std::round(smp[b % RING][ch] * g * 32768.0);
+                out[nOut * 2 + ch] = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, v)));
+            }
+            nOut++;
+        }
+    };
+
+    // pre-roll (silence, so the windows are filled)
+    size_t nOut = 0;
+    for (uint32_t i = 0; i < DELAY; i++) push(0.0, 0.0, nOut);
+
+    while (ok && (outFrames < total))
+    {
+        size_t nIn = static_cast<size_t>(std::min<uint64_t>(CHUNK - DELAY, total - inFrames));
+
+        if ((nIn > 0) && !f.read(reinterpret_cast<char*>(in.data()), nIn * 4))
+        {
+            ok = false;
+            break;
+        }
+        inFrames += nIn;
+
+        nOut = 0;
+        for (size_t i = 0; i < nIn; i++)
+        {
+            push(in[i * 2] / 32768.0, in[i * 2 + 1] / 32768.0, nOut);
+        }
+
+        // end of file -> flush the delay line
+        if (inFrames == total)
+        {
+            for (uint32_t i = 0; i < 2 * DELAY; i++) push(0.0, 0.0, nOut);
+        }
+
+        ok         = static_cast<bool>(o.write(reinterpret_cast<const char*>(out.data()), nOut * 4));
+        outFrames += nOut;
+    }
+
+    f.close();
+    o.close();
+    ok = ok && !o.fail();
+
+    std::error_code ec;
+    if (ok)
+    {
+        std::filesystem::rename(tmp, path, ec);
+    }
+
+    if (!ok || ec)
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
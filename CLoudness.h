@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      Streaming loudness meter after EBU R128 / ITU-R BS.1770 for
+//!             16 bit stereo PCM at 44.1 kHz.
+//!
+//! K-weighting and true peak (4x oversampling) filter both channels at once
+//! (SSE2 doubles where available). The energies of the 400 ms gating blocks
+//! are kept, so album loudness can be computed from the blocks of all
+//! tracks without touching the audio again.
+//------------------------------------------------------------------------------
+class CLoudness
+{
+public:
+    CLoudness();
+
+    //--------------------------------------------------------------------------
+    //! @brief      start a new track
+    //--------------------------------------------------------------------------
+    void start();
+
+    //--------------------------------------------------------------------------
+    //! @brief      add PCM data (multiple of 4 bytes, in track order)
+    //!
+    //! @param[in]  data   PCM data
+    //! @param[in]  bytes  size of data in bytes
+    //--------------------------------------------------------------------------
+    void update(const void* data, size_t bytes);
+
+    //! integrated loudness of data so far in LUFS (SILENCE_LUFS if silent)
+    double integrated() const { return integrated(mBlocks); }
+
+    //! true peak in dBTP
+    double truePeak() const;
+
+    //! mean square energies of the gating blocks
+    const std::vector<double>& blocks() const { return mBlocks; }
+
+    //--------------------------------------------------------------------------
+    //! @brief      gated integrated loudness of a set of blocks
+    //!
+    //! @param[in]  blocks  block energies (e.g. of all tracks of an album)
+    //!
+    //! @return     loudness in LUFS; SILENCE_LUFS if all blocks are gated
+    //--------------------------------------------------------------------------
+    static double integrated(const std::vector<double>& blocks);
+
+    //--------------------------------------------------------------------------
+    //! @brief      apply gain to a wave file; a look-ahead limiter keeps the
+    //!             true peak below the ceiling. The file is replaced only if
+    //!             all went well.
+    //!
+    //! @param[in]  path       wave file (44 byte header, 16 bit stereo)
+    //! @param[in]  gainDb     gain in dB
+    //! @param[in]  ceilingDb  max. true peak in dBTP
+    //! @param[in]  peakDb     true peak of file before gain (limiter is
+    //!                        skipped if gain can't exceed the ceiling)
+    //!
+    //! @return     true on success
+    //--------------------------------------------------------------------------
+    static bool applyGain(const std::string& path, double gainDb, double ceilingDb, double peakDb);
+
+    /// loudness reported for silence
+    static constexpr double SILENCE_LUFS = -70.0;
+
+private:
+    /// 100 ms at 44.1 kHz
+    static constexpr uint32_t STEP_FRAMES = 4410;
+
+    double   mState[4][2];     ///< biquad states (2 stages * 2, per channel)
+    double   mHist[24][2];     ///< true peak history (doubled ring)
+    uint32_t mHistPos;         ///< position in history ring
+    double   mPeak;            ///< max. abs. value (true peak, linear)
+    double   mStepSum;         ///< sum of squares in current 100 ms step
+    uint32_t mStepFrames;      ///< frames in current step
+    double   mSteps[4];        ///< sums of the last 4 steps
+    uint32_t mStepCount;       ///< steps done
+    std::vector<double> mBlocks;
+};
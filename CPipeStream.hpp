@@ -2,6 +2,8 @@
 #include <fileapi.h>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <string_view>
 #include <windows.h>
 
 //------------------------------------------------------------------------------
@@ -56,3 +58,66 @@ public:
     {
     }
 };
+
+//------------------------------------------------------------------------------
+//! @brief      Framed reader for the read side of a non-blocking pipe.
+//!             Data is collected until a line end ('\n' or '\r') is seen,
+//!             so an update split over two reads isn't lost.
+//------------------------------------------------------------------------------
+class CPipeReader
+{
+    HANDLE mhRead;
+    std::string mBuf;
+
+    /// limit for a line w/o line end (garbage protection)
+    static constexpr size_t MAX_LINE = 64 * 1024;
+
+public:
+    CPipeReader() = delete;
+
+    CPipeReader(HANDLE h) : mhRead(h)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      read all data available in pipe and hand out every
+    //!             complete, non-empty line
+    //!
+    //! @param[in]  onLine  callback taking a std::string_view (w/o line end)
+    //!
+    //! @return     number of lines handled
+    //--------------------------------------------------------------------------
+    template<typename F>
+    int poll(F onLine)
+    {
+        char  buff[4096];
+        DWORD read  = 0;
+        int   lines = 0;
+
+        // drain the pipe
+        while (ReadFile(mhRead, buff, sizeof(buff), &read, nullptr) && (read > 0))
+        {
+            mBuf.append(buff, read);
+        }
+
+        size_t start = 0, end;
+        while ((end = mBuf.find_first_of("\r\n", start)) != std::string::npos)
+        {
+            if (end > start)
+            {
+                onLine(std::string_view(mBuf.data() + start, end - start));
+                lines++;
+            }
+            start = end + 1;
+        }
+
+        mBuf.erase(0, start);
+
+        if (mBuf.size() > MAX_LINE)
+        {
+            mBuf.clear();
+        }
+
+        return lines;
+    }
+};
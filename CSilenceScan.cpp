@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CSilenceScan.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIL_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIL_NEON
+#endif
+
+namespace
+{
+    /// samples per vector
+    constexpr size_t VEC_SAMPLES = 8;
+
+    //--------------------------------------------------------------------------
+    //! @brief      check a single frame
+    //--------------------------------------------------------------------------
+    inline bool silentFrame(const int16_t* f, int threshold)
+    {
+        return (f[0] <= threshold) && (f[0] >= -threshold)
+            && (f[1] <= threshold) && (f[1] >= -threshold);
+    }
+
+#if defined(SIL_SSE2)
+    //--------------------------------------------------------------------------
+    //! @brief      true if all 8 samples (4 frames) are silent
+    //--------------------------------------------------------------------------
+    inline bool silentVec(const int16_t* s, __m128i hi, __m128i lo)
+    {
+        __m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i loud = _mm_or_si128(_mm_cmpgt_epi16(v, hi), _mm_cmplt_epi16(v, lo));
+        return _mm_movemask_epi8(loud) == 0;
+    }
+#elif defined(SIL_NEON)
+    inline bool silentVec(const int16_t* s, int16x8_t hi, int16x8_t lo)
+    {
+        int16x8_t  v    = vld1q_s16(s);
+        uint16x8_t loud = vorrq_u16(vcgtq_s16(v, hi), vcltq_s16(v, lo));
+        uint64x2_t l64  = vreinterpretq_u64_u16(loud);
+        return (vgetq_lane_u64(l64, 0) | vgetq_lane_u64(l64, 1)) == 0;
+    }
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! @brief      count silent frames at start of a buffer
+//!
+//! @param[in]  s          samples (interleaved stereo)
+//! @param[in]  frames     number of frames
+//! @param[in]  threshold  max. absolute sample value counted as silence
+//!
+//! @return     number of silent frames
+//------------------------------------------------------------------------------
+size_t CSilenceScan::silentHead(const int16_t* s, size_t frames, int threshold)
+{
+    size_t f = 0;
+
+#if defined(SIL_SSE2)
+    __m128i hi = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    __m128i lo = _mm_set1_epi16(static_cast<int16_t>(-threshold));
+#elif defined(SIL_NEON)
+    int16x8_t hi = vdupq_n_s16(static_cast<int16_t>(threshold));
+    int16x8_t lo = vdupq_n_s16(static_cast<int16_t>(-threshold));
+#endif
+
+#if defined(SIL_SSE2) || defined(SIL_NEON)
+    // skip silent vectors; the first loud one is resolved below
+    while (((f + VEC_SAMPLES / 2) <= frames) && silentVec(s + f * 2, hi, lo))
+    {
+        f += VEC_SAMPLES / 2;
+    }
+#endif
+
+    while ((f < frames) && silentFrame(s + f * 2, threshold))
+    {
+        f++;
+    }
+
+    return f;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      count silent frames at end of a buffer
+//!
+//! @param[in]  s          samples (interleaved stereo)
+//! @param[in]  frames     number of frames
+//! @param[in]  threshold  max. absolute sample value counted as silence
+//!
+//! @return     number of silent frames
+//------------------------------------------------------------------------------
+size_t CSilenceScan::silentTail(const int16_t* s, size_t frames, int threshold)
+{
+    size_t f = frames;
+
+#if defined(SIL_SSE2)
+    __m128i hi = _mm_set1_epi16(static_cast<int16_t>(threshold));
+    __m128i lo = _mm_set1_epi16(static_cast<int16_t>(-threshold));
+#elif defined(SIL_NEON)
+    int16x8_t hi = vdupq_n_s16(static_cast<int16_t>(threshold));
+    int16x8_t lo = vdupq_n_s16(static_cast<int16_t>(-threshold));
+#endif
+
+#if defined(SIL_SSE2) || defined(SIL_NEON)
+    while ((f >= VEC_SAMPLES / 2) && silentVec(s + (f - VEC_SAMPLES / 2) * 2, hi, lo))
+    {
+        f -= VEC_SAMPLES / 2;
+    }
+#endif
+
+    while ((f > 0) && silentFrame(s + (f - 1) * 2, threshold))
+    {
+        f--;
+    }
+
+    return frames - f;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      start a new track
+//!
+//! @param[in]  threshold  max. absolute sample value counted as silence
+//------------------------------------------------------------------------------
+void CSilenceScan::start(int threshold)
+{
+    mThreshold = (threshold < 0) ? 0 : ((threshold > 32767) ? 32767 : threshold);
+    mFrames    = 0;
+    mLead      = 0;
+    mTrail     = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      add track data (multiple of 4 bytes, in track order)
+//!
+//! @param[in]  data   PCM data
+//! @param[in]  bytes  size of data in bytes
+//------------------------------------------------------------------------------
+void CSilenceScan::update(const void* data, size_t bytes)
+{
+    const int16_t* s = static_cast<const int16_t*>(data);
+    size_t frames    = bytes / 4;
+    size_t tail;
+
+    // still in leading silence?
+    if (mLead == mFrames)
+    {
+        size_t head = silentHead(s, frames, mThreshold);
+        mLead += head;
+        tail   = (head == frames) ? frames : silentTail(s, frames, mThreshold);
+    }
+    else
+    {
+        tail = silentTail(s, frames, mThreshold);
+    }
+
+    // whole buffer silent -> silence at end grows
+    mTrail   = (tail == frames) ? (mTrail + frames) : tail;
+    mFrames += frames;
+}
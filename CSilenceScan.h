@@ -0,0 +1,84 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+//------------------------------------------------------------------------------
+//! @brief      Streaming scanner for leading and trailing silence of a track
+//!             (16 bit stereo PCM). A frame is silent if both samples are
+//!             within +/- threshold. The scan uses SSE2 or NEON where
+//!             available.
+//------------------------------------------------------------------------------
+class CSilenceScan
+{
+public:
+    //--------------------------------------------------------------------------
+    //! @brief      start a new track
+    //!
+    //! @param[in]  threshold  max. absolute sample value counted as silence
+    //--------------------------------------------------------------------------
+    void start(int threshold);
+
+    //--------------------------------------------------------------------------
+    //! @brief      add track data (multiple of 4 bytes, in track order)
+    //!
+    //! @param[in]  data   PCM data
+    //! @param[in]  bytes  size of data in bytes
+    //--------------------------------------------------------------------------
+    void update(const void* data, size_t bytes);
+
+    //! silent frames at track start
+    uint64_t leading() const { return mLead; }
+
+    //! silent frames at track end
+    uint64_t trailing() const { return mTrail; }
+
+    //! frames scanned
+    uint64_t frames() const { return mFrames; }
+
+    //! track is silent from start to end
+    bool allSilent() const { return mLead == mFrames; }
+
+    //--------------------------------------------------------------------------
+    //! @brief      count silent frames at start of a buffer
+    //!
+    //! @param[in]  s          samples (interleaved stereo)
+    //! @param[in]  frames     number of frames
+    //! @param[in]  threshold  max. absolute sample value counted as silence
+    //!
+    //! @return     number of silent frames
+    //--------------------------------------------------------------------------
+    static size_t silentHead(const int16_t* s, size_t frames, int threshold);
+
+    //--------------------------------------------------------------------------
+    //! @brief      count silent frames at end of a buffer
+    //!
+    //! @param[in]  s          samples (interleaved stereo)
+    //! @param[in]  frames     number of frames
+    //! @param[in]  threshold  max. absolute sample value counted as silence
+    //!
+    //! @return     number of silent frames
+    //--------------------------------------------------------------------------
+    static size_t silentTail(const int16_t* s, size_t frames, int threshold);
+
+private:
+    int      mThreshold = 0;
+    uint64_t mFrames    = 0;  ///< frames scanned so far
+    uint64_t mLead      = 0;  ///< leading silent frames
+    uint64_t mTrail     = 0;  ///< silent frames at end of data scanned so far
+};
@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// clock used for all pipeline statistics
+typedef std::chrono::steady_clock StatClock_t;
+
+//------------------------------------------------------------------------------
+//! @brief      milliseconds elapsed since a given time point
+//!
+//! @param[in]  start  The start time point
+//!
+//! @return     elapsed time in ms
+//------------------------------------------------------------------------------
+inline uint64_t msSince(const StatClock_t::time_point& start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(StatClock_t::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      This class adds the life time of a scope to a busy counter.
+//!             Used to measure the utilisation of the pipeline stages.
+//------------------------------------------------------------------------------
+class CStageTimer
+{
+    std::atomic<uint64_t>&  mBusyMs;
+    StatClock_t::time_point mStart;
+
+public:
+    CStageTimer() = delete;
+
+    CStageTimer(std::atomic<uint64_t>& busyMs) : mBusyMs(busyMs), mStart(StatClock_t::now())
+    {
+    }
+
+    ~CStageTimer()
+    {
+        mBusyMs += msSince(mStart);
+    }
+};
@@ -0,0 +1,538 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CTrackPipeline.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "CLoudness.h"
+
+//------------------------------------------------------------------------------
+//! @brief      create pipeline
+//!
+//! @param      abort  abort flag (user abort, rip failure)
+//------------------------------------------------------------------------------
+CTrackPipeline::CTrackPipeline(std::atomic_bool& abort) : mAbort(abort)
+{
+}
+
+//------------------------------------------------------------------------------
+//! @brief      destroys the object; threads must be done (see finish())
+//------------------------------------------------------------------------------
+CTrackPipeline::~CTrackPipeline()
+{
+    finish();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      start encoder and NetMD write threads
+//!
+//! @param[in]  cfg    settings
+//! @param[in]  tools  platform dependent steps
+//------------------------------------------------------------------------------
+void CTrackPipeline::start(const SConfig& cfg, const STools& tools)
+{
+    mCfg   = cfg;
+    mTools = tools;
+
+    // no need for more than one encoder thread if we don't encode
+    if (!mTools.mEncode || (mCfg.mEncThreads < 1))
+    {
+        mCfg.mEncThreads = 1;
+    }
+
+    mRunning = mCfg.mEncThreads;
+    for (int i = 0; i < mCfg.mEncThreads; i++)
+    {
+        mXenc.emplace_back(&CTrackPipeline::tfunc_xencode, this);
+    }
+
+    mMdWrite = std::thread(&CTrackPipeline::tfunc_mdwrite, this);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      queue a ripped track for encoding / transfer
+//!
+//! @param[in]  job   The track
+//------------------------------------------------------------------------------
+void CTrackPipeline::queue(const STrackDescr& job)
+{
+    mXencMtxTracks.lock();
+    mXencTracks.push_back(job);
+    mXencMtxTracks.unlock();
+
+    // notify encoder threads (taking the mutex makes sure no thread
+    // misses the new job between predicate check and wait)
+    {
+        std::lock_guard<std::mutex> lk(mXencM);
+    }
+    mXencCv.notify_one();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      no more tracks; wait until all are encoded and written and
+//!             late titles are done
+//------------------------------------------------------------------------------
+void CTrackPipeline::finish()
+{
+    {
+        std::lock_guard<std::mutex> lk(mXencM);
+        std::lock_guard<std::mutex> lkTracks(mXencMtxTracks);
+        mXencComplete = true;
+    }
+    mXencCv.notify_all();
+
+    for (auto& t : mXenc)
+    {
+        if (t.joinable()) t.join();
+    }
+
+    if (mMdWrite.joinable())
+    {
+        mMdWrite.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      publish titles (disc title at index 0, then track titles)
+//!
+//! @param[in]  titles  The titles
+//------------------------------------------------------------------------------
+void CTrackPipeline::setTitles(const std::vector<std::string>& titles)
+{
+    {
+        std::lock_guard<std::mutex> lk(mTitleMtx);
+        mTitles      = titles;
+        mTitlesReady = true;
+    }
+    mTitleCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      check if titles are available (doesn't block)
+//!
+//! @return     true -> titles available
+//------------------------------------------------------------------------------
+bool CTrackPipeline::titlesReady()
+{
+    std::lock_guard<std::mutex> lk(mTitleMtx);
+    return mTitlesReady;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      wait until titles are available
+//!
+//! @return     true -> titles available; false -> aborted
+//------------------------------------------------------------------------------
+bool CTrackPipeline::waitTitles()
+{
+    std::unique_lock<std::mutex> lk(mTitleMtx);
+    mTitleCv.wait(lk, [this]{return mTitlesReady;});
+    return !mAbort;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      get title; on first use titles are planned (see STools)
+//!
+//! @param[in]  no    title number (0 -> disc title, 1 ... -> track title)
+//!
+//! @return     title; empty if not available
+//------------------------------------------------------------------------------
+std::string CTrackPipeline::title(size_t no)
+{
+    std::lock_guard<std::mutex> lk(mTitleMtx);
+
+    if (mTitlesReady && !mPlanned)
+    {
+        if (mTools.mPlanTitles && !mTitles.empty())
+        {
+            mTools.mPlanTitles(mTitles);
+        }
+        mPlanned = true;
+    }
+
+    return (no < mTitles.size()) ? mTitles.at(no) : std::string{};
+}
+
+//------------------------------------------------------------------------------
+//! @brief      first transfer is due: from now on the MD is changed, so
+//!             declining the title dialog doesn't abort anymore
+//!
+//! @return     true -> go on with the transfer; false -> user aborted
+//------------------------------------------------------------------------------
+bool CTrackPipeline::startTransfer()
+{
+    std::lock_guard<std::mutex> lk(mTitleMtx);
+    mMdTouched = !mAbort;
+    return mMdTouched;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      check if the first transfer has started (MD erased)
+//!
+//! @return     true -> started
+//------------------------------------------------------------------------------
+bool CTrackPipeline::transferStarted()
+{
+    std::lock_guard<std::mutex> lk(mTitleMtx);
+    return mMdTouched;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      user declined to go on without titles: abort, unless the
+//!             first transfer has started in the meantime
+//!
+//! @return     true -> aborted; false -> tracks stay untitled
+//------------------------------------------------------------------------------
+bool CTrackPipeline::abortBeforeTransfer()
+{
+    std::lock_guard<std::mutex> lk(mTitleMtx);
+    if (!mMdTouched)
+    {
+        mAbort = true;
+    }
+    return !mMdTouched;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      erase and title MD before the first track is written
+//!
+//! Called when the first transfer is due - not before, so an abort in the
+//! title dialog before that point leaves the MD untouched. After that point
+//! declining the dialog means going on untitled (see startTransfer()).
+//!
+//! @return     true -> disc title still has to be written
+//------------------------------------------------------------------------------
+bool CTrackPipeline::prepareMD()
+{
+    bool discTitlePending = false;
+
+    if (!mCfg.mAppend)
+    {
+        mTools.mEraseDisc();
+
+        // don't let the title dialog hold back the transfer
+        if (titlesReady())
+        {
+            mTools.mDiscTitle();
+        }
+        else
+        {
+            discTitlePending = true;
+        }
+    }
+
+    return discTitlePending;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      title tracks (and disc) which were transferred before the
+//!             titles were available
+//!
+//! @param      untitled          CD track indices of untitled tracks
+//! @param      discTitlePending  disc title still has to be written
+//------------------------------------------------------------------------------
+void CTrackPipeline::patchTitles(std::vector<int>& untitled, bool& discTitlePending)
+{
+    if (mAbort)
+    {
+        untitled.clear();
+        discTitlePending = false;
+        return;
+    }
+
+    if (discTitlePending)
+    {
+        mTools.mDiscTitle();
+        discTitlePending = false;
+    }
+
+    for (const auto& no : untitled)
+    {
+        std::string t = title(no + 1);
+
+        if (!t.empty())
+        {
+            if (mCfg.mVerbose)
+            {
+                std::cout << "Late title for track " << no + 1 << ": " << t << std::endl;
+            }
+            mTools.mTrackTitle(mCfg.mMdOffset + no, t);
+        }
+    }
+
+    untitled.clear();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      delete a track file (unless files are kept)
+//!
+//! @param[in]  file  The file
+//------------------------------------------------------------------------------
+void CTrackPipeline::removeFile(const std::string& file)
+{
+    if (!mCfg.mKeepFiles)
+    {
+        std::remove(file.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      thread function for netmd transfer
+//!
+//! Tracks are transferred as soon as they are ready. If the titles aren't
+//! known yet (e.g. the user still has to choose a CDDB entry), the tracks
+//! are written untitled and renamed once the titles are available. The MD
+//! is erased with the first transfer only (see prepareMD()).
+//!
+//! @return     0
+//------------------------------------------------------------------------------
+int CTrackPipeline::tfunc_mdwrite()
+{
+    STrackDescr      currJob;
+    bool             go               = true;
+    bool             prepared         = false;
+    bool             discTitlePending = false;
+    std::vector<int> untitled;
+
+    do
+    {
+        mTrfMtxTracks.lock();
+        if (mTrfTracks.size() > 0)
+        {
+            currJob = mTrfTracks[0];
+            mTrfTracks.erase(mTrfTracks.begin());
+        }
+        else
+        {
+            currJob = {"", ""};
+            if (mTrfComplete)
+            {
+                go = false;
+            }
+        }
+        mTrfMtxTracks.unlock();
+
+        // MD is touched not before the first transfer is due
+        if (!currJob.mFile.empty() && !prepared && startTransfer())
+        {
+            discTitlePending = prepareMD();
+            prepared         = true;
+        }
+
+        if (!currJob.mFile.empty() && mAbort)
+        {
+            removeFile(currJob.mFile);
+        }
+        else if (!currJob.mFile.empty())
+        {
+            // bind title right before the transfer, if already known
+            if (titlesReady())
+            {
+                patchTitles(untitled, discTitlePending);
+                currJob.mName = title(currJob.mNo + 1);
+            }
+            else
+            {
+                currJob.mName.clear();
+                untitled.push_back(currJob.mNo);
+            }
+
+            if (currJob.mPartial && mCfg.mVerbose)
+            {
+                std::cout << "Track " << currJob.mNo + 1 << " contains unreadable or unverified parts." << std::endl;
+            }
+
+            if (++mTrfTrack == 1)
+            {
+                mFirstTrfMs = msSince(mCfg.mStart);
+            }
+            CStageTimer tm(mTrfBusyMs);
+            mTools.mWriteTrack(currJob.mFile, currJob.mName);
+            removeFile(currJob.mFile);
+        }
+        else if (go)
+        {
+            std::unique_lock<std::mutex> lk(mTrfM);
+            mTrfCv.wait(lk, [this]{return mTrfReady;});
+            mTrfReady = false;
+        }
+    }
+    while(go);
+
+    // all tracks transferred -> now it's time to wait for the titles
+    if (!untitled.empty() || discTitlePending)
+    {
+        waitTitles();
+        patchTitles(untitled, discTitlePending);
+    }
+
+    if (mAbort && prepared)
+    {
+        std::cerr << "Aborted after the transfer had started: " << mTrfTrack << " track(s) were written to MD"
+                  << (titlesReady() ? "." : " untitled.") << std::endl;
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      pick the next job for an encoder thread
+//!             (call with locked mXencMtxTracks)
+//!
+//! While the NetMD write thread has tracks queued, the longest pending track
+//! is encoded first, so a long track at the end of the disc doesn't add its
+//! full encoding time to the total. If the transfer queue runs dry, the
+//! head-of-line track is preferred to feed the NetMD write thread again.
+//!
+//! @return     iterator to job in mXencTracks
+//------------------------------------------------------------------------------
+TrackVector_t::iterator CTrackPipeline::pickEncodeJob()
+{
+    bool trfStarving;
+
+    mTrfMtxTracks.lock();
+    trfStarving = mTrfTracks.empty();
+    mTrfMtxTracks.unlock();
+
+    if (trfStarving)
+    {
+        auto hol = std::find_if(mXencTracks.begin(), mXencTracks.end(),
+                                [this](const STrackDescr& t){ return t.mNo == mNextCommit; });
+
+        if (hol != mXencTracks.end())
+        {
+            return hol;
+        }
+    }
+
+    return std::max_element(mXencTracks.begin(), mXencTracks.end(),
+                            [](const STrackDescr& a, const STrackDescr& b){ return a.mSize < b.mSize; });
+}
+
+//------------------------------------------------------------------------------
+//! @brief      park an encoded track in the reorder buffer and hand over all
+//!             tracks which are ready in disc order to the NetMD write thread
+//!
+//! @param[in]  job   The encoded job
+//------------------------------------------------------------------------------
+void CTrackPipeline::commitEncodedTrack(const STrackDescr& job)
+{
+    bool notify = false;
+
+    mXencMtxTracks.lock();
+    mReorder[job.mNo] = job;
+
+    mTrfMtxTracks.lock();
+    for (auto it = mReorder.begin(); (it != mReorder.end()) && (it->first == mNextCommit);)
+    {
+        mTrfTracks.push_back(it->second);
+        it = mReorder.erase(it);
+        mNextCommit++;
+        notify = true;
+    }
+    mTrfMtxTracks.unlock();
+    mXencMtxTracks.unlock();
+
+    if (notify)
+    {
+        // notify md write thread
+        {
+            std::lock_guard<std::mutex> lk(mTrfM);
+            mTrfReady = true;
+        }
+        mTrfCv.notify_one();
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      thread function for external encoder
+//!
+//! @return     0
+//------------------------------------------------------------------------------
+int CTrackPipeline::tfunc_xencode()
+{
+    STrackDescr currJob;
+    bool        go = true;
+
+    do
+    {
+        mXencMtxTracks.lock();
+        if (mXencTracks.size() > 0)
+        {
+            auto it = pickEncodeJob();
+            currJob = *it;
+            mXencTracks.erase(it);
+        }
+        else
+        {
+            currJob = {"", ""};
+            if (mXencComplete)
+            {
+                go = false;
+            }
+        }
+        mXencMtxTracks.unlock();
+
+        if (!currJob.mFile.empty())
+        {
+            if (currJob.mGain != 0.0)
+            {
+                // gain stage right before encoding / SP transfer; encoder and
+                // netmdcli read files only, so this is an extra pass over the
+                // track. On failure the file is left as ripped.
+                CStageTimer tm(mEncBusyMs);
+                if (!CLoudness::applyGain(currJob.mFile, currJob.mGain, mCfg.mTruePeak, currJob.mPeak))
+                {
+                    std::cerr << "Can't normalize track " << currJob.mNo + 1 << ", it is transferred without gain!" << std::endl;
+                }
+            }
+
+            if (mTools.mEncode)
+            {
+                mEncTrack ++;
+                CStageTimer tm(mEncBusyMs);
+                mTools.mEncode(currJob.mFile);
+            }
+
+            commitEncodedTrack(currJob);
+        }
+        else if (go)
+        {
+            std::unique_lock<std::mutex> lk(mXencM);
+            mXencCv.wait(lk, [this]
+            {
+                std::lock_guard<std::mutex> lkTracks(mXencMtxTracks);
+                return !mXencTracks.empty() || mXencComplete;
+            });
+        }
+    }
+    while(go);
+
+    // last encoder thread done
+    if (--mRunning == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mTrfM);
+            std::lock_guard<std::mutex> lkTracks(mTrfMtxTracks);
+            mTrfComplete = true;
+            mTrfReady    = true;
+        }
+        mTrfCv.notify_one();
+    }
+
+    return 0;
+}
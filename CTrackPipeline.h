@@ -0,0 +1,215 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include "CStageTimer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// store track file name and title
+struct STrackDescr
+{
+    std::string mName;            ///< track title
+    std::string mFile;            ///< file name
+    int         mNo      = -1;    ///< track index on CD (0 based)
+    uint32_t    mSize    = 0;     ///< track size in bytes (encoder scheduling)
+    bool        mPartial = false; ///< rip contains unreadable / unverified parts
+    double      mGain    = 0.0;   ///< normalisation gain in dB (0 -> none)
+    double      mPeak    = 0.0;   ///< true peak before gain in dBTP
+};
+
+/// define track vector type
+typedef std::vector<STrackDescr> TrackVector_t;
+
+//------------------------------------------------------------------------------
+//! @brief      Encoder and NetMD write stages of cd2netmd, platform neutral.
+//!
+//! Ripped tracks are queued by the caller. Encoder threads pick the longest
+//! pending track while the transfer has work queued, else the one the
+//! transfer waits for; encoded tracks pass a reorder buffer and are handed
+//! over to the write thread in disc order. The MD is erased when the first
+//! transfer is due. Tracks transferred before the titles are known are
+//! titled late, once they are.
+//!
+//! Encoder, NetMD commands and title planning are given as callbacks, so
+//! cd2netmd runs the real tools and bench/pipesim the stand-ins.
+//------------------------------------------------------------------------------
+class CTrackPipeline
+{
+public:
+    /// platform dependent steps
+    struct STools
+    {
+        /// encode a track file in place; empty -> no external encoding
+        std::function<bool(const std::string& file)> mEncode;
+
+        /// transfer a track to MD
+        std::function<bool(const std::string& file, const std::string& title)> mWriteTrack;
+
+        /// erase MD (not called in append mode)
+        std::function<void()> mEraseDisc;
+
+        /// write disc title (use title(0))
+        std::function<void()> mDiscTitle;
+
+        /// (re-)title a track on MD (0 based MD track number)
+        std::function<void(int mdTrack, const std::string& title)> mTrackTitle;
+
+        /// fit the titles into the MD TOC; called once before first use
+        std::function<void(std::vector<std::string>& titles)> mPlanTitles;
+    };
+
+    /// settings
+    struct SConfig
+    {
+        int    mEncThreads = 1;     ///< parallel encoder jobs
+        bool   mAppend     = false; ///< append to MD, don't erase it
+        int    mMdOffset   = 0;     ///< tracks on MD before our first one
+        double mTruePeak   = -1.0;  ///< max. true peak after gain in dBTP
+        bool   mKeepFiles  = false; ///< don't delete track files
+        bool   mVerbose    = false; ///< verbose output
+        StatClock_t::time_point mStart = StatClock_t::now(); ///< program start
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      create pipeline
+    //!
+    //! @param      abort  abort flag (user abort, rip failure)
+    //--------------------------------------------------------------------------
+    CTrackPipeline(std::atomic_bool& abort);
+    ~CTrackPipeline();
+
+    //--------------------------------------------------------------------------
+    //! @brief      start encoder and NetMD write threads
+    //!
+    //! @param[in]  cfg    settings
+    //! @param[in]  tools  platform dependent steps
+    //--------------------------------------------------------------------------
+    void start(const SConfig& cfg, const STools& tools);
+
+    //--------------------------------------------------------------------------
+    //! @brief      queue a ripped track for encoding / transfer
+    //!
+    //! @param[in]  job   The track
+    //--------------------------------------------------------------------------
+    void queue(const STrackDescr& job);
+
+    //--------------------------------------------------------------------------
+    //! @brief      no more tracks; wait until all are encoded and written and
+    //!             late titles are done
+    //--------------------------------------------------------------------------
+    void finish();
+
+    //--------------------------------------------------------------------------
+    //! @brief      publish titles (disc title at index 0, then track titles)
+    //!
+    //! @param[in]  titles  The titles
+    //--------------------------------------------------------------------------
+    void setTitles(const std::vector<std::string>& titles);
+
+    //--------------------------------------------------------------------------
+    //! @brief      check if titles are available (doesn't block)
+    //--------------------------------------------------------------------------
+    bool titlesReady();
+
+    //--------------------------------------------------------------------------
+    //! @brief      wait until titles are available
+    //!
+    //! @return     true -> titles available; false -> aborted
+    //--------------------------------------------------------------------------
+    bool waitTitles();
+
+    //--------------------------------------------------------------------------
+    //! @brief      get title; on first use titles are planned (see STools)
+    //!
+    //! @param[in]  no    title number (0 -> disc title, 1 ... -> track title)
+    //!
+    //! @return     title; empty if not available
+    //--------------------------------------------------------------------------
+    std::string title(size_t no);
+
+    //--------------------------------------------------------------------------
+    //! @brief      check if the first transfer has started (MD erased)
+    //--------------------------------------------------------------------------
+    bool transferStarted();
+
+    //--------------------------------------------------------------------------
+    //! @brief      user declined to go on without titles: abort, unless the
+    //!             first transfer has started in the meantime
+    //!
+    //! @return     true -> aborted; false -> tracks stay untitled
+    //--------------------------------------------------------------------------
+    bool abortBeforeTransfer();
+
+    int encTrack() const { return mEncTrack; }  ///< tracks given to the encoder
+    int trfTrack() const { return mTrfTrack; }  ///< tracks given to the transfer
+
+    std::atomic<uint64_t> mEncBusyMs  = {0};    ///< busy time of encoder threads
+    std::atomic<uint64_t> mTrfBusyMs  = {0};    ///< busy time of transfer
+    std::atomic<uint64_t> mFirstTrfMs = {0};    ///< time to first track transfer
+
+private:
+    bool startTransfer();
+    bool prepareMD();
+    void patchTitles(std::vector<int>& untitled, bool& discTitlePending);
+    TrackVector_t::iterator pickEncodeJob();
+    void commitEncodedTrack(const STrackDescr& job);
+    void removeFile(const std::string& file);
+    int  tfunc_xencode();
+    int  tfunc_mdwrite();
+
+    std::atomic_bool& mAbort;
+    SConfig           mCfg;
+    STools            mTools;
+
+    /// NetMD write thread
+    std::mutex              mTrfMtxTracks;     ///< guards mTrfTracks
+    TrackVector_t           mTrfTracks;        ///< tracks ready for transfer, disc order
+    std::mutex              mTrfM;             ///< NetMD write thread synchronization
+    std::condition_variable mTrfCv;
+    bool                    mTrfReady    = false;
+    bool                    mTrfComplete = false;
+    std::thread             mMdWrite;
+
+    /// encoder threads
+    std::mutex                 mXencMtxTracks; ///< guards mXencTracks, mReorder
+    TrackVector_t              mXencTracks;    ///< ripped tracks
+    std::map<int, STrackDescr> mReorder;       ///< encoded tracks waiting for in-order commit
+    int                        mNextCommit = 0;///< next track index to hand over
+    std::atomic_int            mRunning    = {0};
+    std::mutex                 mXencM;         ///< encoder threads synchronization
+    std::condition_variable    mXencCv;
+    bool                       mXencComplete = false;
+    std::vector<std::thread>   mXenc;
+
+    /// titles
+    std::mutex               mTitleMtx;        ///< guards titles and mMdTouched
+    std::condition_variable  mTitleCv;
+    bool                     mTitlesReady = false;
+    bool                     mPlanned     = false;
+    bool                     mMdTouched   = false; ///< first transfer started
+    std::vector<std::string> mTitles;
+
+    std::atomic_int mEncTrack = {0};
+    std::atomic_int mTrfTrack = {0};
+};
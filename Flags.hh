@@ -143,7 +143,10 @@ inline void Flags::Var(T & var, char shortFlag, std::string longFlag, T defaultV
   struct option op;
   this->entry(op, shortFlag, longFlag, defaultValue, description, descriptionGroup);
 
-  this->optionStr += ":";
+  // long only options have no entry in the short option string
+  if (shortFlag) {
+    this->optionStr += ":";
+  }
 
   op.has_arg = required_argument;
   var = defaultValue;
@@ -6,6 +6,7 @@
 
 #include "WinHttpWrapper.h"
 #include <winhttp.h>
+#include <chrono>
 // #pragma comment(lib, "Winhttp.lib")
 
 void WinHttpWrapper::HttpRequest::setup(const std::wstring& domain,
@@ -17,6 +18,9 @@ void WinHttpWrapper::HttpRequest::setup(const std::wstring& domain,
             const std::wstring& server_username,
             const std::wstring& server_password)
 {
+    // new server -> new session
+    Close();
+
     m_Domain = domain;
     m_Port   = port;
     m_Secure = secure;
@@ -27,6 +31,86 @@ void WinHttpWrapper::HttpRequest::setup(const std::wstring& domain,
     m_ServerPassword = server_password;
 }
 
+void WinHttpWrapper::HttpRequest::Close()
+{
+    if (m_hConnect) WinHttpCloseHandle(m_hConnect);
+    if (m_hSession) WinHttpCloseHandle(m_hSession);
+    m_hConnect = NULL;
+    m_hSession = NULL;
+}
+
+void WinHttpWrapper::HttpRequest::Cancel()
+{
+    std::lock_guard<std::mutex> lk(m_ReqMtx);
+    m_Cancelled = true;
+
+    // closing the handle makes the blocking WinHttp call
+    // in the requesting thread return with an error
+    if (m_hRequest) WinHttpCloseHandle(m_hRequest);
+    m_hRequest = NULL;
+}
+
+void WinHttpWrapper::HttpRequest::Arm()
+{
+    std::lock_guard<std::mutex> lk(m_ReqMtx);
+    m_Cancelled = false;
+}
+
+HINTERNET WinHttpWrapper::HttpRequest::LiveRequest()
+{
+    // Cancel() closes the handle from another thread; its value may be
+    // handed out again right away, so never use a copy after that
+    std::lock_guard<std::mutex> lk(m_ReqMtx);
+    return m_Cancelled ? NULL : m_hRequest;
+}
+
+void WinHttpWrapper::HttpRequest::SetTimeouts(int resolve, int connect, int send, int receive)
+{
+    m_ResolveTimeout = resolve;
+    m_ConnectTimeout = connect;
+    m_SendTimeout = send;
+    m_ReceiveTimeout = receive;
+
+    if (m_hSession)
+        WinHttpSetTimeouts(m_hSession, m_ResolveTimeout, m_ConnectTimeout, m_SendTimeout, m_ReceiveTimeout);
+}
+
+bool WinHttpWrapper::HttpRequest::Connect(const std::wstring& user_agent, const std::wstring& domain,
+    int port, std::wstring& error)
+{
+    if (m_hSession && m_hConnect)
+        return true;
+
+    Close();
+
+    // Use WinHttpOpen to obtain a session handle.
+    m_hSession = WinHttpOpen(user_agent.c_str(),
+        // WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
+        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        WINHTTP_NO_PROXY_NAME,
+        WINHTTP_NO_PROXY_BYPASS, 0);
+
+    if (!m_hSession)
+    {
+        error = L"WinHttpOpen fails!";
+        return false;
+    }
+
+    WinHttpSetTimeouts(m_hSession, m_ResolveTimeout, m_ConnectTimeout, m_SendTimeout, m_ReceiveTimeout);
+
+    // Specify an HTTP server.
+    m_hConnect = WinHttpConnect(m_hSession, domain.c_str(), port, 0);
+
+    if (!m_hConnect)
+    {
+        Close();
+        error = L"WinHttpConnect fails!";
+        return false;
+    }
+
+    return true;
+}
+
 bool WinHttpWrapper::HttpRequest::Get(
     const std::wstring& rest_of_path,
     const std::wstring& requestHeader,
@@ -94,13 +178,25 @@ bool WinHttpWrapper::HttpRequest::Request(
     const std::string& body,
     HttpResponse& response)
 {
-    return http(verb, m_UserAgent, m_Domain,
+    auto start = std::chrono::steady_clock::now();
+    response.reused = (m_hSession != NULL) && (m_hConnect != NULL);
+
+    bool ret = http(verb, m_UserAgent, m_Domain,
         rest_of_path, m_Port, m_Secure,
         requestHeader, body,
         response.text, response.header,
         response.statusCode, response.error,
         m_ProxyUsername, m_ProxyPassword,
         m_ServerUsername, m_ServerPassword);
+
+    response.latency = static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+    // don't reuse a session which might be broken
+    if (!ret)
+        Close();
+
+    return ret;
 }
 
 
@@ -119,53 +215,56 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
     DWORD dwSize = 0;
     DWORD dwDownloaded = 0;
     BOOL  bResults = FALSE;
-    HINTERNET hSession = NULL;
-    HINTERNET hConnect = NULL;
     HINTERNET hRequest = NULL;
     BOOL bDone = FALSE;
     DWORD dwProxyAuthScheme = 0;
 
     dwStatusCode = 0;
 
-    // Use WinHttpOpen to obtain a session handle.
-    hSession = WinHttpOpen(user_agent.c_str(),
-        // WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-        WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS, 0);
-
-    // Specify an HTTP server.
-    if (hSession)
+    // fetches the request handle before each WinHttp call on it
+    auto live = [&]() -> bool
     {
-        hConnect = WinHttpConnect(hSession, domain.c_str(), port, 0);
-    }
-    else
+        if ((hRequest = LiveRequest()) == NULL)
+            error = L"Request cancelled";
+        return hRequest != NULL;
+    };
+
+    // Session and connection are reused between requests.
+    if (!Connect(user_agent, domain, port, error))
     {
-        error = L"WinHttpOpen fails!";
         return false;
     }
 
     // Create an HTTP request handle.
-    if (hConnect)
-    {
-        DWORD flag = secure ? WINHTTP_FLAG_SECURE : 0;
-        hRequest = WinHttpOpenRequest(hConnect, verb.c_str(), rest_of_path.c_str(),
-            NULL, WINHTTP_NO_REFERER,
-            WINHTTP_DEFAULT_ACCEPT_TYPES,
-            WINHTTP_FLAG_REFRESH | flag);
-    }
-    else
-    {
-        WinHttpCloseHandle(hSession);
-        error = L"WinHttpConnect fails!";
-        return false;
-    }
+    DWORD flag = secure ? WINHTTP_FLAG_SECURE : 0;
+    hRequest = WinHttpOpenRequest(m_hConnect, verb.c_str(), rest_of_path.c_str(),
+        NULL, WINHTTP_NO_REFERER,
+        WINHTTP_DEFAULT_ACCEPT_TYPES,
+        WINHTTP_FLAG_REFRESH | flag);
 
     if (hRequest == NULL)
         bDone = TRUE;
+    else
+    {
+        // publish handle for Cancel()
+        std::lock_guard<std::mutex> lk(m_ReqMtx);
+        if (m_Cancelled)
+        {
+            WinHttpCloseHandle(hRequest);
+            hRequest = NULL;
+            bDone = TRUE;
+        }
+        m_hRequest = hRequest;
+    }
 
     while (!bDone)
     {
+        if (!live())
+        {
+            bResults = FALSE;
+            break;
+        }
+
         //  If a proxy authentication challenge was responded to, reset
         //  those credentials before each SendRequest, because the proxy  
         //  may require re-authentication after responding to a 401 or  
@@ -173,7 +272,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
         //  407-401-407-401- loop.
         if (dwProxyAuthScheme != 0 && szProxyUsername != L"")
         {
-            bResults = WinHttpSetCredentials(hRequest,
+            bResults = live() && WinHttpSetCredentials(hRequest,
                 WINHTTP_AUTH_TARGET_PROXY,
                 dwProxyAuthScheme,
                 szProxyUsername.c_str(),
@@ -186,7 +285,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
         }
 
         // Send a request.
-        if (hRequest)
+        if (live())
         {
             if (requestHeader.empty())
             {
@@ -207,11 +306,13 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                 error = L"WinHttpSendRequest fails!";
             }
         }
+        else
+            bResults = FALSE;
 
         // End the request.
         if (bResults)
         {
-            bResults = WinHttpReceiveResponse(hRequest, NULL);
+            bResults = live() && WinHttpReceiveResponse(hRequest, NULL);
             if (!bResults)
             {
                 error = L"WinHttpReceiveResponse fails!";
@@ -227,7 +328,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
         if (bResults)
         {
             dwSize = sizeof(dwStatusCode);
-            bResults = WinHttpQueryHeaders(hRequest,
+            bResults = live() && WinHttpQueryHeaders(hRequest,
                 WINHTTP_QUERY_STATUS_CODE |
                 WINHTTP_QUERY_FLAG_NUMBER,
                 WINHTTP_HEADER_NAME_BY_INDEX,
@@ -241,12 +342,14 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
             }
 
             // Get response header
-            WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF,
+            DWORD dwHeaderError = 0;
+            if (bResults && live() && !WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF,
                 WINHTTP_HEADER_NAME_BY_INDEX, NULL,
-                &dwSize, WINHTTP_NO_HEADER_INDEX);
+                &dwSize, WINHTTP_NO_HEADER_INDEX))
+                dwHeaderError = GetLastError();
 
             // Allocate memory for the buffer.
-            if (GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+            if ((dwHeaderError == ERROR_INSUFFICIENT_BUFFER) && live())
             {
                 responseHeader.resize(dwSize + 1);
 
@@ -273,6 +376,11 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                 {
                     // Check for available data.
                     dwSize = 0;
+                    if (!live())
+                    {
+                        bResults = FALSE;
+                        break;
+                    }
                     if (!WinHttpQueryDataAvailable(hRequest, &dwSize))
                     {
                         error = L"Error in WinHttpQueryDataAvailable: ";
@@ -287,6 +395,11 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                     temp.resize(dwSize);
                     // Read the data.
                     ZeroMemory((void*)(&temp[0]), dwSize);
+                    if (!live())
+                    {
+                        bResults = FALSE;
+                        break;
+                    }
                     if (!WinHttpReadData(hRequest, (LPVOID)(&temp[0]),
                         dwSize, &dwDownloaded))
                     {
@@ -306,7 +419,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                 //printf(" The server requires authentication. Sending credentials...\n");
 
                 // Obtain the supported and preferred schemes.
-                bResults = WinHttpQueryAuthSchemes(hRequest,
+                bResults = live() && WinHttpQueryAuthSchemes(hRequest,
                     &dwSupportedSchemes,
                     &dwFirstScheme,
                     &dwTarget);
@@ -325,7 +438,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                         bDone = TRUE;
                     else
                     {
-                        bResults = WinHttpSetCredentials(hRequest,
+                        bResults = live() && WinHttpSetCredentials(hRequest,
                             dwTarget,
                             dwSelectedScheme,
                             szServerUsername.c_str(),
@@ -351,7 +464,7 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
                 //printf("The proxy requires authentication.  Sending credentials...\n");
 
                 // Obtain the supported and preferred schemes.
-                bResults = WinHttpQueryAuthSchemes(hRequest,
+                bResults = live() && WinHttpQueryAuthSchemes(hRequest,
                     &dwSupportedSchemes,
                     &dwFirstScheme,
                     &dwTarget);
@@ -389,10 +502,19 @@ bool WinHttpWrapper::HttpRequest::http(const std::wstring& verb, const std::wstr
             bDone = TRUE;
     }
 
-    // Close any open handles.
-    if (hRequest) WinHttpCloseHandle(hRequest);
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
+    // Close request handle only, session and connection stay open
+    // for the next request (keep-alive). Cancel() might have closed it.
+    {
+        std::lock_guard<std::mutex> lk(m_ReqMtx);
+        if (m_hRequest) WinHttpCloseHandle(m_hRequest);
+        m_hRequest = NULL;
+    }
+
+    if (m_Cancelled)
+    {
+        error = L"Request cancelled";
+        bResults = FALSE;
+    }
 
     // Report any errors.
     if (!bResults)
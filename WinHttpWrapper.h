@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
@@ -15,19 +17,23 @@ namespace WinHttpWrapper
 {
     struct HttpResponse
     {
-        HttpResponse() : statusCode(0) {}
+        HttpResponse() : statusCode(0), latency(0), reused(false) {}
         void Reset()
         {
             text = "";
             header = L"";
             statusCode = 0;
             error = L"";
+            latency = 0;
+            reused = false;
         }
 
         std::string text;
         std::wstring header;
         DWORD statusCode;
         std::wstring error;
+        DWORD latency;  // time from request start until last byte read in ms
+        bool reused;    // request used an already open session / connection
     };
 
     class HttpRequest
@@ -50,7 +56,38 @@ namespace WinHttpWrapper
             , m_ProxyPassword(proxy_password)
             , m_ServerUsername(server_username)
             , m_ServerPassword(server_password)
+            , m_hSession(NULL)
+            , m_hConnect(NULL)
+            , m_hRequest(NULL)
+            , m_Cancelled(false)
+            , m_ResolveTimeout(0)
+            , m_ConnectTimeout(60000)
+            , m_SendTimeout(30000)
+            , m_ReceiveTimeout(30000)
         {}
+
+        // session and connection handles are owned by this object
+        HttpRequest(const HttpRequest&) = delete;
+        HttpRequest& operator=(const HttpRequest&) = delete;
+
+        ~HttpRequest()
+        {
+            Close();
+        }
+
+        // closes session and connection; next request will open new ones
+        void Close();
+
+        // aborts a running request (may be called from another thread)
+        // by closing its request handle
+        void Cancel();
+
+        // resets the cancel state; call before a request is started,
+        // never while one is running
+        void Arm();
+
+        // timeouts in ms (see WinHttpSetTimeouts), applied to the session
+        void SetTimeouts(int resolve, int connect, int send, int receive);
         
         void setup(const std::wstring& domain,
             int port,
@@ -85,7 +122,7 @@ namespace WinHttpWrapper
             const std::wstring& requestHeader,
             const std::string& body,
             HttpResponse& response);
-        static bool http(
+        bool http(
             const std::wstring& verb, const std::wstring& user_agent, const std::wstring& domain,
             const std::wstring& rest_of_path, int port, bool secure,
             const std::wstring& requestHeader, const std::string& body,
@@ -96,6 +133,14 @@ namespace WinHttpWrapper
 
         static DWORD ChooseAuthScheme(DWORD dwSupportedSchemes);
 
+        // handle of the running request for the next WinHttp call;
+        // NULL once Cancel() closed it
+        HINTERNET LiveRequest();
+
+        // opens session and connection if not yet done
+        bool Connect(const std::wstring& user_agent, const std::wstring& domain,
+            int port, std::wstring& error);
+
         std::wstring m_Domain;
         int m_Port;
         bool m_Secure;
@@ -104,6 +149,22 @@ namespace WinHttpWrapper
         std::wstring m_ProxyPassword;
         std::wstring m_ServerUsername;
         std::wstring m_ServerPassword;
+
+        // kept open between requests, so that WinHTTP can reuse
+        // the keep-alive connection (no new TCP / TLS handshake)
+        HINTERNET m_hSession;
+        HINTERNET m_hConnect;
+
+        // handle of the running request, guarded by m_ReqMtx
+        // (closed from Cancel() in another thread)
+        HINTERNET m_hRequest;
+        std::mutex m_ReqMtx;
+        std::atomic<bool> m_Cancelled;
+
+        int m_ResolveTimeout;
+        int m_ConnectTimeout;
+        int m_SendTimeout;
+        int m_ReceiveTimeout;
     };
 
 }
@@ -0,0 +1,551 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "CCddbStub.h"
+#include "../cddb.h"
+#include <arpa/inet.h>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <netinet/in.h>
+#include <random>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef C2N_OPENSSL
+    #include <openssl/ec.h>
+    #include <openssl/err.h>
+    #include <openssl/evp.h>
+    #include <openssl/pem.h>
+    #include <openssl/ssl.h>
+    #include <openssl/x509v3.h>
+#endif
+
+namespace
+{
+    //! decode the cmd parameter of a request path ('+' and %XX escapes)
+    std::string cmdParam(const std::string& path)
+    {
+        std::string out;
+        size_t pos = path.find("cmd=");
+
+        if (pos == std::string::npos)
+        {
+            return out;
+        }
+
+        for (size_t i = pos + 4; (i < path.size()) && (path[i] != '&'); i++)
+        {
+            if (path[i] == '+')
+            {
+                out += ' ';
+            }
+            else if ((path[i] == '%') && (i + 2 < path.size()))
+            {
+                out += static_cast<char>(std::strtol(path.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                out += path[i];
+            }
+        }
+        return out;
+    }
+
+    //! split at blanks
+    std::vector<std::string> tokens(const std::string& s)
+    {
+        std::vector<std::string> out;
+        std::istringstream iss(s);
+        std::string tok;
+
+        while (iss >> tok)
+        {
+            out.push_back(tok);
+        }
+        return out;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create server (not started)
+//!
+//! @param[in]  cfg   server settings
+//------------------------------------------------------------------------------
+CCddbStub::CCddbStub(const SConfig& cfg)
+    : mCfg(cfg), mLatencyMs(cfg.mLatencyMs)
+{
+}
+
+//------------------------------------------------------------------------------
+//! @brief      stop server and free TLS context
+//------------------------------------------------------------------------------
+CCddbStub::~CCddbStub()
+{
+    stop();
+#ifdef C2N_OPENSSL
+    if (mSslCtx != nullptr)
+    {
+        SSL_CTX_free(static_cast<SSL_CTX*>(mSslCtx));
+    }
+#endif
+}
+
+//------------------------------------------------------------------------------
+//! @brief      load corpus, open listening socket, start accept thread
+//!
+//! @param[out] error  error text
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+bool CCddbStub::start(std::string& error)
+{
+    std::error_code ec;
+
+    for (const auto& e : std::filesystem::directory_iterator(mCfg.mCorpusDir, ec))
+    {
+        if (e.path().extension() != ".xmcd")
+        {
+            continue;
+        }
+
+        std::ifstream     in(e.path(), std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+
+        // "210 <genre> <discid> CD database entry follows ..."
+        SRecord rec;
+        rec.mData = ss.str();
+        std::vector<std::string> head = tokens(rec.mData.substr(0, rec.mData.find('\n')));
+
+        SXmcdData data;
+        if ((head.size() >= 3) && (head[0] == "210") && (parseXmcd(rec.mData, data) == 0))
+        {
+            rec.mGenre  = head[1];
+            rec.mDiscId = head[2];
+            rec.mTitle  = data.mDiscTitle;
+            mRecords.push_back(std::move(rec));
+        }
+    }
+
+    if (mRecords.empty())
+    {
+        error = "No xmcd records in '" + mCfg.mCorpusDir + "'";
+        return false;
+    }
+
+    if (mCfg.mTls && !initTls(error))
+    {
+        return false;
+    }
+
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    int on = 1;
+
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(static_cast<uint16_t>(mCfg.mPort));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (((mListen = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        || (setsockopt(mListen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0)
+        || (bind(mListen, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+        || (listen(mListen, 64) != 0)
+        || (getsockname(mListen, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0))
+    {
+        error = "Can't listen on port " + std::to_string(mCfg.mPort);
+        if (mListen >= 0)
+        {
+            close(mListen);
+            mListen = -1;
+        }
+        return false;
+    }
+
+    mPort    = ntohs(addr.sin_port);
+    mRunning = true;
+    mAcceptThread = std::thread(&CCddbStub::acceptLoop, this);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      stop server, close all connections
+//------------------------------------------------------------------------------
+void CCddbStub::stop()
+{
+    if (!mRunning.exchange(false))
+    {
+        return;
+    }
+
+    mStopCv.notify_all();
+
+    // wakes up accept()
+    shutdown(mListen, SHUT_RDWR);
+    close(mListen);
+    mAcceptThread.join();
+
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lk(mMtx);
+        for (int s : mSockets)
+        {
+            shutdown(s, SHUT_RDWR);
+        }
+        workers.swap(mWorkers);
+    }
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      URL of cddb.cgi on this server
+//------------------------------------------------------------------------------
+std::string CCddbStub::url() const
+{
+    return std::string(mCfg.mTls ? "https" : "http") + "://localhost:" + std::to_string(mPort) + "/~cddb/cddb.cgi";
+}
+
+//------------------------------------------------------------------------------
+//! @brief      number of requests received so far
+//------------------------------------------------------------------------------
+uint64_t CCddbStub::requests() const
+{
+    return mRequests;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      number of TCP connections accepted so far
+//------------------------------------------------------------------------------
+uint64_t CCddbStub::connections() const
+{
+    return mConnections;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      change latency while running
+//!
+//! @param[in]  ms    new latency in ms
+//------------------------------------------------------------------------------
+void CCddbStub::setLatency(uint32_t ms)
+{
+    mLatencyMs = ms;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      answer a CDDB command
+//!
+//! @param[in]  cmd   decoded command, e.g. "cddb read rock 9b0bb80c"
+//!
+//! @return     CDDB response
+//------------------------------------------------------------------------------
+std::string CCddbStub::answer(const std::string& cmd) const
+{
+    std::vector<std::string> tok = tokens(cmd);
+
+    if ((tok.size() >= 3) && (tok[0] == "cddb") && (tok[1] == "query"))
+    {
+        std::vector<const SRecord*> hits;
+
+        for (const auto& r : mRecords)
+        {
+            if (r.mDiscId == tok[2])
+            {
+                hits.push_back(&r);
+            }
+        }
+
+        if (hits.empty())
+        {
+            return "202 No match for disc ID " + tok[2] + ".\r\n";
+        }
+        else if (hits.size() == 1)
+        {
+            return "200 " + hits[0]->mGenre + " " + hits[0]->mDiscId + " " + hits[0]->mTitle + "\r\n";
+        }
+
+        std::string out = "210 Found exact matches, list follows (until terminating `.')\r\n";
+        for (const auto* r : hits)
+        {
+            out += r->mGenre + " " + r->mDiscId + " " + r->mTitle + "\r\n";
+        }
+        return out + ".\r\n";
+    }
+    else if ((tok.size() >= 4) && (tok[0] == "cddb") && (tok[1] == "read"))
+    {
+        for (const auto& r : mRecords)
+        {
+            if ((r.mGenre == tok[2]) && (r.mDiscId == tok[3]))
+            {
+                return r.mData;
+            }
+        }
+        return "401 " + tok[2] + " " + tok[3] + " No such CD entry in database.\r\n";
+    }
+
+    return "500 Command syntax error.\r\n";
+}
+
+//------------------------------------------------------------------------------
+//! @brief      accept connections until stopped
+//------------------------------------------------------------------------------
+void CCddbStub::acceptLoop()
+{
+    while (mRunning)
+    {
+        int sock = accept(mListen, nullptr, nullptr);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lk(mMtx);
+        if (!mRunning)
+        {
+            close(sock);
+            break;
+        }
+
+        mConnections++;
+        mSockets.push_back(sock);
+        mWorkers.emplace_back(&CCddbStub::serve, this, sock);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      sleep for the latency (plus jitter)
+//!
+//! @return     false if server was stopped meanwhile
+//------------------------------------------------------------------------------
+bool CCddbStub::waitLatency()
+{
+    thread_local std::minstd_rand rnd(std::random_device{}());
+    uint32_t ms = mLatencyMs;
+
+    if (mCfg.mJitterMs > 0)
+    {
+        ms += rnd() % (mCfg.mJitterMs + 1);
+    }
+
+    std::unique_lock<std::mutex> lk(mMtx);
+    return !mStopCv.wait_for(lk, std::chrono::milliseconds(ms), [this](){ return !mRunning; });
+}
+
+//------------------------------------------------------------------------------
+//! @brief      serve one connection (keep-alive)
+//!
+//! @param[in]  sock  connection socket
+//------------------------------------------------------------------------------
+void CCddbStub::serve(int sock)
+{
+#ifdef C2N_OPENSSL
+    SSL* ssl = nullptr;
+
+    if (mSslCtx != nullptr)
+    {
+        ssl = SSL_new(static_cast<SSL_CTX*>(mSslCtx));
+        SSL_set_fd(ssl, sock);
+
+        if (SSL_accept(ssl) != 1)
+        {
+            ERR_clear_error();
+            SSL_free(ssl);
+            ssl = nullptr;
+            shutdown(sock, SHUT_RDWR);
+        }
+    }
+
+    auto rd = [&](char* b, int n){ return (ssl != nullptr) ? SSL_read(ssl, b, n) : static_cast<int>(recv(sock, b, n, 0)); };
+    auto wr = [&](const char* b, int n){ return (ssl != nullptr) ? SSL_write(ssl, b, n) : static_cast<int>(send(sock, b, n, MSG_NOSIGNAL)); };
+#else
+    auto rd = [&](char* b, int n){ return static_cast<int>(recv(sock, b, n, 0)); };
+    auto wr = [&](const char* b, int n){ return static_cast<int>(send(sock, b, n, MSG_NOSIGNAL)); };
+#endif
+
+    std::string rx;
+    char buff[4096];
+    bool keepAlive = true;
+
+    while (keepAlive && mRunning)
+    {
+        size_t end;
+        int    rc = 1;
+
+        while (((end = rx.find("\r\n\r\n")) == std::string::npos) && ((rc = rd(buff, sizeof(buff))) > 0))
+        {
+            rx.append(buff, rc);
+        }
+
+        if (end == std::string::npos)
+        {
+            break;
+        }
+
+        std::string head = rx.substr(0, end + 2);
+        rx.erase(0, end + 4);
+        mRequests++;
+
+        // GET <path> HTTP/1.x
+        std::vector<std::string> req = tokens(head.substr(0, head.find("\r\n")));
+        std::string lower = head;
+        for (auto& c : lower)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        keepAlive = (req.size() == 3) && (req[2] == "HTTP/1.1") && (lower.find("connection: close") == std::string::npos);
+
+        if (!waitLatency())
+        {
+            break;
+        }
+
+        std::string status = "200 OK";
+        std::string body;
+
+        if ((req.size() == 3) && (req[0] == "GET") && (req[1].find("/cddb.cgi?") != std::string::npos))
+        {
+            body = answer(cmdParam(req[1]));
+        }
+        else
+        {
+            status = "404 Not Found";
+            body   = "Not found\r\n";
+        }
+
+        std::string resp = "HTTP/1.1 " + status + "\r\n"
+                           "Content-Type: text/plain; charset=UTF-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: " + (keepAlive ? "keep-alive" : "close") + "\r\n\r\n" + body;
+
+        for (size_t sent = 0; sent < resp.size(); )
+        {
+            if ((rc = wr(resp.c_str() + sent, static_cast<int>(resp.size() - sent))) <= 0)
+            {
+                keepAlive = false;
+                break;
+            }
+            sent += rc;
+        }
+    }
+
+#ifdef C2N_OPENSSL
+    if (ssl != nullptr)
+    {
+        SSL_free(ssl);
+    }
+#endif
+
+    std::lock_guard<std::mutex> lk(mMtx);
+    for (auto it = mSockets.begin(); it != mSockets.end(); ++it)
+    {
+        if (*it == sock)
+        {
+            mSockets.erase(it);
+            break;
+        }
+    }
+    close(sock);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      create TLS context with a self-signed certificate for localhost
+//!
+//! @param[out] error  error text
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+bool CCddbStub::initTls(std::string& error)
+{
+#ifdef C2N_OPENSSL
+    bool          ok   = false;
+    EVP_PKEY*     key  = nullptr;
+    X509*         cert = X509_new();
+    SSL_CTX*      ctx  = SSL_CTX_new(TLS_server_method());
+    EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+
+    if ((cert != nullptr) && (ctx != nullptr) && (kctx != nullptr)
+        && (EVP_PKEY_keygen_init(kctx) == 1)
+        && (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) == 1)
+        && (EVP_PKEY_keygen(kctx, &key) == 1))
+    {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), static_cast<long>(time(nullptr)));
+        X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+        X509_set_pubkey(cert, key);
+
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+
+        X509V3_CTX v3;
+        X509V3_set_ctx_nodb(&v3);
+        X509V3_set_ctx(&v3, cert, cert, nullptr, nullptr, 0);
+
+        for (const auto& ext : {std::make_pair(NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1"),
+                                std::make_pair(NID_basic_constraints, "critical,CA:TRUE")})
+        {
+            if (X509_EXTENSION* e = X509V3_EXT_conf_nid(nullptr, &v3, ext.first, ext.second))
+            {
+                X509_add_ext(cert, e, -1);
+                X509_EXTENSION_free(e);
+            }
+        }
+
+        ok = (X509_sign(cert, key, EVP_sha256()) > 0)
+            && (SSL_CTX_use_certificate(ctx, cert) == 1)
+            && (SSL_CTX_use_PrivateKey(ctx, key) == 1);
+
+        if (ok && !mCfg.mCertOut.empty())
+        {
+            FILE* f = fopen(mCfg.mCertOut.c_str(), "w");
+            ok = (f != nullptr) && (PEM_write_X509(f, cert) == 1);
+            if (f != nullptr)
+            {
+                fclose(f);
+            }
+        }
+    }
+
+    if (ok)
+    {
+        mSslCtx = ctx;
+    }
+    else
+    {
+        error = "Can't create TLS certificate";
+        SSL_CTX_free(ctx);
+    }
+
+    EVP_PKEY_CTX_free(kctx);
+    EVP_PKEY_free(key);
+    X509_free(cert);
+    ERR_clear_error();
+    return ok;
+#else
+    error = "Built without TLS support";
+    return false;
+#endif
+}
@@ -0,0 +1,128 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      Local stand-in for a CDDB server (CDDB protocol over HTTP,
+//!             like cddb.cgi). Query and read are answered from the xmcd
+//!             records of a corpus folder after a configurable latency.
+//!             Keep-alive is supported; https if built with C2N_OPENSSL
+//!             (self-signed certificate for localhost, created at start).
+//!             POSIX only - used by the host benchmarks and tests.
+//------------------------------------------------------------------------------
+class CCddbStub
+{
+public:
+    /// server settings
+    struct SConfig
+    {
+        int         mPort      = 0;     ///< TCP port; 0 -> any free port
+        uint32_t    mLatencyMs = 0;     ///< delay before every answer
+        uint32_t    mJitterMs  = 0;     ///< random extra delay (0 ... jitter)
+        bool        mTls       = false; ///< https
+        std::string mCorpusDir;         ///< folder with *.xmcd records
+        std::string mCertOut;           ///< write certificate (PEM) here (https)
+    };
+
+    CCddbStub(const SConfig& cfg);
+    ~CCddbStub();
+
+    CCddbStub(const CCddbStub&) = delete;
+    CCddbStub& operator=(const CCddbStub&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! @brief      load corpus, open listening socket, start accept thread
+    //!
+    //! @param[out] error  error text
+    //!
+    //! @return     true on success
+    //--------------------------------------------------------------------------
+    bool start(std::string& error);
+
+    //--------------------------------------------------------------------------
+    //! @brief      stop server, close all connections
+    //--------------------------------------------------------------------------
+    void stop();
+
+    //--------------------------------------------------------------------------
+    //! @brief      URL of cddb.cgi on this server
+    //--------------------------------------------------------------------------
+    std::string url() const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      number of requests received so far
+    //--------------------------------------------------------------------------
+    uint64_t requests() const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      number of TCP connections accepted so far
+    //--------------------------------------------------------------------------
+    uint64_t connections() const;
+
+    //--------------------------------------------------------------------------
+    //! @brief      change latency while running
+    //!
+    //! @param[in]  ms    new latency in ms
+    //--------------------------------------------------------------------------
+    void setLatency(uint32_t ms);
+
+    //--------------------------------------------------------------------------
+    //! @brief      answer a CDDB command (the part after "?cmd=", decoded)
+    //!
+    //! @param[in]  cmd   e.g. "cddb query 9b0bb80c 12 150 ... 2998"
+    //!
+    //! @return     CDDB response
+    //--------------------------------------------------------------------------
+    std::string answer(const std::string& cmd) const;
+
+private:
+    /// one xmcd record of the corpus
+    struct SRecord
+    {
+        std::string mGenre;
+        std::string mDiscId;
+        std::string mTitle;
+        std::string mData;     ///< complete read response
+    };
+
+    void acceptLoop();
+    void serve(int sock);
+    bool waitLatency();
+    bool initTls(std::string& error);
+
+    SConfig                  mCfg;
+    std::vector<SRecord>     mRecords;
+    int                      mListen = -1;
+    int                      mPort   = 0;
+    std::atomic<uint32_t>    mLatencyMs;
+    std::atomic<uint64_t>    mRequests    = {0};
+    std::atomic<uint64_t>    mConnections = {0};
+    std::atomic_bool         mRunning     = {false};
+    std::thread              mAcceptThread;
+    std::vector<std::thread> mWorkers;
+    std::vector<int>         mSockets;   ///< open connections
+    std::mutex               mMtx;
+    std::condition_variable  mStopCv;
+    void*                    mSslCtx = nullptr; ///< SSL_CTX (https)
+};
@@ -0,0 +1,160 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Stand-in for atracdenc, used to time the cd2netmd pipeline without the
+// real encoder (cd2netmd -t bench/ or pipesim). It takes the same command
+// line, keeps one core busy for the time the real encoder would need at a
+// configurable realtime factor and writes an .aea file of the right size.
+//
+// environment:
+//   BENCH_ENC_RTF   realtime factor of one encoder job (default: 20)
+//
+#include "benchwav.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      print usage
+//------------------------------------------------------------------------------
+static int usage()
+{
+    std::cerr << "usage: atracdenc -e atrac3 --bitrate=128|64 -i <in.wav> -o <out.aea>" << std::endl;
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      stand-in encoder main
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string in, out, codec;
+    int bitrate = 128;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if ((arg == "-e") && (i + 1 < argc))
+        {
+            codec = argv[++i];
+        }
+        else if ((arg == "-i") && (i + 1 < argc))
+        {
+            in = argv[++i];
+        }
+        else if ((arg == "-o") && (i + 1 < argc))
+        {
+            out = argv[++i];
+        }
+        else if (arg.compare(0, 10, "--bitrate=") == 0)
+        {
+            bitrate = std::atoi(arg.c_str() + 10);
+        }
+        else if ((arg == "--bitrate") && (i + 1 < argc))
+        {
+            bitrate = std::atoi(argv[++i]);
+        }
+    }
+
+    if ((codec != "atrac3") || in.empty() || out.empty() || ((bitrate != 128) && (bitrate != 64)))
+    {
+        return usage();
+    }
+
+    SWavInfo wav;
+    if (!wavReadInfo(in, wav) || (wav.mFormat != 1))
+    {
+        std::cerr << "Can't read PCM wave file " << in << std::endl;
+        return 2;
+    }
+
+    double rtf = 20.0;
+    if (const char* env = std::getenv("BENCH_ENC_RTF"))
+    {
+        rtf = std::max(0.1, std::atof(env));
+    }
+
+    // read samples, so the file access costs are real as well
+    std::vector<int16_t> pcm(wav.mDataSize / 2);
+    if (FILE* f = fopen(in.c_str(), "rb"))
+    {
+        fseek(f, wav.mDataStart, SEEK_SET);
+        size_t rd = fread(pcm.data(), 2, pcm.size(), f);
+        pcm.resize(rd);
+        fclose(f);
+    }
+
+    typedef std::chrono::steady_clock clk;
+    auto   start    = clk::now();
+    auto   duration = std::chrono::duration<double>(wav.seconds() / rtf);
+    double acc      = 0.0;
+    int    percent  = -1;
+    size_t pos      = 0;
+
+    // busy loop over the samples until the emulated encoding time is over
+    for (;;)
+    {
+        for (int n = 0; (n < 4096) && !pcm.empty(); n++, pos = (pos + 1) % pcm.size())
+        {
+            acc = acc * 0.999 + std::sin(pcm[pos] * 0.001);
+        }
+
+        double done = (clk::now() - start) / duration;
+        int    p    = static_cast<int>(std::min(done, 1.0) * 100.0);
+
+        if (p != percent)
+        {
+            percent = p;
+            std::cout << "Encoding: " << percent << "%" << std::endl;
+        }
+
+        if (done >= 1.0)
+        {
+            break;
+        }
+    }
+
+    // 1024 samples per frame, 384 bytes (LP2) / 192 bytes (LP4) each
+    uint32_t frameSz = (bitrate == 128) ? 384 : 192;
+    uint32_t frames  = (wav.mDataSize / 4 + 1023) / 1024;
+
+    FILE* f = fopen(out.c_str(), "wb");
+    if (f == nullptr)
+    {
+        std::cerr << "Can't create " << out << std::endl;
+        return 2;
+    }
+
+    std::vector<char> buf(frameSz, static_cast<char>(static_cast<int>(acc) & 0xff));
+    std::vector<char> hdr(AEA_HEADER_SIZE, 0);
+    hdr[1] = 0x08;
+    fwrite(hdr.data(), 1, hdr.size(), f);
+
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        fwrite(buf.data(), 1, buf.size(), f);
+    }
+
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+//
+// Minimal WAVE helpers shared by the stand-in tools and the pipeline
+// simulation. Only the layouts written by cd2netmd are supported:
+// 16 bit stereo PCM (44 byte header) and the ATRAC3 wrapper written
+// by atrac3WaveHeader().
+//
+
+/// CD audio byte rate
+static constexpr uint32_t CDDA_BYTES_PER_SEC = 44100 * 4;
+
+/// ATRAC3 wave format tag (WAVE_FORMAT_SONY_SCX)
+static constexpr uint16_t WAVE_FMT_ATRAC3 = 0x270;
+
+/// size of the header atracdenc puts in front of the frames
+static constexpr uint32_t AEA_HEADER_SIZE = 96;
+
+/// wave file information
+struct SWavInfo
+{
+    uint16_t mFormat    = 0;  ///< format tag
+    uint32_t mByteRate  = 0;  ///< average bytes per second
+    uint32_t mDataSize  = 0;  ///< size of data chunk
+    long     mDataStart = 0;  ///< offset of data chunk payload
+
+    //! audio duration in seconds
+    double seconds() const
+    {
+        return mByteRate ? (static_cast<double>(mDataSize) / mByteRate) : 0.0;
+    }
+};
+
+//------------------------------------------------------------------------------
+//! @brief      write a little endian value
+//!
+//! @param      f     file
+//! @param[in]  v     value
+//! @param[in]  sz    byte count
+//------------------------------------------------------------------------------
+inline void wavPutLe(FILE* f, uint32_t v, int sz)
+{
+    for (int i = 0; i < sz; i++)
+    {
+        fputc((v >> (8 * i)) & 0xff, f);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      write the header of a 16 bit stereo 44.1 kHz PCM wave file
+//!
+//! @param      f         file
+//! @param[in]  dataSize  size of PCM data
+//------------------------------------------------------------------------------
+inline void wavWritePcmHeader(FILE* f, uint32_t dataSize)
+{
+    fwrite("RIFF", 1, 4, f);
+    wavPutLe(f, dataSize + 36, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wavPutLe(f, 16, 4);
+    wavPutLe(f, 1, 2);                  // PCM
+    wavPutLe(f, 2, 2);                  // channels
+    wavPutLe(f, 44100, 4);              // sample rate
+    wavPutLe(f, CDDA_BYTES_PER_SEC, 4); // byte rate
+    wavPutLe(f, 4, 2);                  // block align
+    wavPutLe(f, 16, 2);                 // bits per sample
+    fwrite("data", 1, 4, f);
+    wavPutLe(f, dataSize, 4);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      write the ATRAC3 wave header (same layout as cd2netmd's
+//!             atrac3WaveHeader())
+//!
+//! @param      f         file
+//! @param[in]  lp4       true -> LP4; false -> LP2
+//! @param[in]  dataSize  size of ATRAC3 frames
+//------------------------------------------------------------------------------
+inline void wavWriteAtrac3Header(FILE* f, bool lp4, uint32_t dataSize)
+{
+    fwrite("RIFF", 1, 4, f);
+    wavPutLe(f, 0xC + 8 + 0x20 + dataSize, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    wavPutLe(f, 0x20, 4);
+    wavPutLe(f, WAVE_FMT_ATRAC3, 2);
+    wavPutLe(f, 2, 2);
+    wavPutLe(f, 44100, 4);
+    wavPutLe(f, lp4 ? 8268 : 16537, 4);
+    wavPutLe(f, lp4 ? 0xc0 : 0x180, 2);
+    wavPutLe(f, 0, 2);
+    wavPutLe(f, 0xE, 2);
+    fwrite(lp4 ? "\x01\x00\x44\xAC\x00\x00\x01\x00\x01\x00\x01\x00\x00\x00"
+               : "\x01\x00\x44\xAC\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00", 1, 0xE, f);
+    fwrite("data", 1, 4, f);
+    wavPutLe(f, dataSize, 4);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      read format and data chunk position of a wave file
+//!
+//! @param[in]  file  file name
+//! @param[out] info  wave information
+//!
+//! @return     true on success
+//------------------------------------------------------------------------------
+inline bool wavReadInfo(const std::string& file, SWavInfo& info)
+{
+    FILE* f = fopen(file.c_str(), "rb");
+    bool  ok = false;
+
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    unsigned char hdr[12], chunk[8], fmt[12];
+
+    if ((fread(hdr, 1, 12, f) == 12) && !memcmp(hdr, "RIFF", 4) && !memcmp(hdr + 8, "WAVE", 4))
+    {
+        while (fread(chunk, 1, 8, f) == 8)
+        {
+            uint32_t sz = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | (static_cast<uint32_t>(chunk[7]) << 24);
+
+            if (!memcmp(chunk, "fmt ", 4) && (sz >= 12) && (fread(fmt, 1, 12, f) == 12))
+            {
+                // format tag, channels, sample rate, byte rate
+                info.mFormat   = fmt[0] | (fmt[1] << 8);
+                info.mByteRate = fmt[8] | (fmt[9] << 8) | (fmt[10] << 16) | (static_cast<uint32_t>(fmt[11]) << 24);
+                fseek(f, sz - 12 + (sz & 1), SEEK_CUR);
+            }
+            else if (!memcmp(chunk, "data", 4))
+            {
+                info.mDataSize  = sz;
+                info.mDataStart = ftell(f);
+                ok = (info.mByteRate > 0);
+                break;
+            }
+            else
+            {
+                fseek(f, sz + (sz & 1), SEEK_CUR);
+            }
+        }
+    }
+
+    fclose(f);
+    return ok;
+}
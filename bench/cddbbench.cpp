@@ -0,0 +1,353 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Micro benchmarks of the metadata path: CDDB query / read parsing,
+// MD title transliteration and group title creation. Every function runs
+// over a corpus of CDDB responses (folder bench/corpus); the results are
+// reported as ns/op and heap allocations/op.
+//
+#include "../cddb.h"
+#include "../Flags.hh"
+#include "../utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BENCH_CORPUS
+    #define BENCH_CORPUS "corpus"
+#endif
+
+// The replacements below are kept out of line, GCC would otherwise see
+// malloc / free pairs through inlined new / delete and warn about them.
+#if defined(__GNUC__)
+    #define BENCH_NOINLINE __attribute__((noinline))
+#else
+    #define BENCH_NOINLINE
+#endif
+
+/// heap statistics (all threads)
+static std::atomic<uint64_t> g_u64Allocs = {0};
+static std::atomic<uint64_t> g_u64AllocBytes = {0};
+
+BENCH_NOINLINE void* operator new(std::size_t sz)
+{
+    g_u64Allocs++;
+    g_u64AllocBytes += sz;
+
+    if (void* p = std::malloc(sz ? sz : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void* operator new[](std::size_t sz)
+{
+    return operator new(sz);
+}
+
+BENCH_NOINLINE void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+BENCH_NOINLINE void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+BENCH_NOINLINE void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/// keeps the optimizer from dropping results
+static volatile size_t g_sink = 0;
+
+//------------------------------------------------------------------------------
+//! @brief      line based xmcd parser as used before parseXmcd() (getline,
+//!             find and substr per line; transliteration left out). Kept as
+//!             reference for the parser benchmark only: it neither joins
+//!             continuation lines nor sorts keys by track number.
+//!
+//! @param[in]  input  CDDB data response
+//! @param[out] info   disc and track titles in input order
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+static int parseXmcdOld(const std::string& input, std::vector<std::string>& info)
+{
+    std::string line, tok;
+    size_t pos;
+    std::istringstream iss(input);
+    while(std::getline(iss, line))
+    {
+        if ((line.find("DTITLE") == 0) || (line.find("TTITLE") == 0))
+        {
+            tok.clear();
+
+            if ((pos = line.find("=")) != line.npos)
+            {
+                tok = line.substr(pos + 1);
+            }
+
+            if ((pos = tok.find("/")) != tok.npos)
+            {
+                tok.replace(pos, 1, "-");
+            }
+
+            // remove \r
+            if ((pos = tok.rfind("\r")) != tok.npos)
+            {
+                tok.erase(pos, 1);
+            }
+
+            if (tok.size() > 0)
+            {
+                info.push_back(tok);
+            }
+        }
+    }
+
+    return info.empty() ? -1 : 0;
+}
+
+/// one corpus file
+struct SCorpusFile
+{
+    std::string mName;
+    std::string mContent;
+};
+
+/// one benchmark result
+struct SBenchResult
+{
+    double mNsPerOp     = 0.0;
+    double mAllocsPerOp = 0.0;
+    double mBytesPerOp  = 0.0;
+};
+
+//------------------------------------------------------------------------------
+//! @brief      run a function until min. time is reached and measure it
+//!
+//! @param[in]  fn         function under test (one op)
+//! @param[in]  minTimeMs  min. measuring time in ms
+//!
+//! @return     benchmark result
+//------------------------------------------------------------------------------
+static SBenchResult runBench(const std::function<void()>& fn, int minTimeMs)
+{
+    typedef std::chrono::steady_clock clk;
+    SBenchResult res;
+    uint64_t iters = 1;
+
+    // warm up
+    fn();
+
+    for (;;)
+    {
+        uint64_t allocs = g_u64Allocs;
+        uint64_t bytes  = g_u64AllocBytes;
+        auto     start  = clk::now();
+
+        for (uint64_t i = 0; i < iters; i++)
+        {
+            fn();
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(clk::now() - start).count();
+
+        if ((ns >= minTimeMs * 1e6) || (iters >= (1ull << 30)))
+        {
+            res.mNsPerOp     = ns / iters;
+            res.mAllocsPerOp = static_cast<double>(g_u64Allocs - allocs) / iters;
+            res.mBytesPerOp  = static_cast<double>(g_u64AllocBytes - bytes) / iters;
+            break;
+        }
+
+        // aim a bit above the min. time with the next run
+        double scale = (ns > 0.0) ? (minTimeMs * 1.4e6 / ns) : 100.0;
+        iters = std::max(iters + 1, static_cast<uint64_t>(iters * std::min(std::max(scale, 2.0), 100.0)));
+    }
+
+    return res;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      load all corpus files
+//!
+//! @param[in]  dir    corpus folder
+//! @param[out] files  loaded files, sorted by name
+//!
+//! @return     true if at least one file was loaded
+//------------------------------------------------------------------------------
+static bool loadCorpus(const std::string& dir, std::vector<SCorpusFile>& files)
+{
+    std::error_code ec;
+
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec))
+    {
+        if (e.is_regular_file())
+        {
+            std::ifstream     in(e.path(), std::ios::binary);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            files.push_back({e.path().filename().string(), ss.str()});
+        }
+    }
+
+    std::sort(files.begin(), files.end(), [](const SCorpusFile& a, const SCorpusFile& b){ return a.mName < b.mName; });
+    return !files.empty();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      benchmark main
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    bool        help = false;
+    int         minTimeMs;
+    std::string corpusDir, filter;
+
+    Flags parser;
+    parser.Bool(help     , 'h', "help"    , "Prints help screen and exits program.");
+    parser.Var (minTimeMs, '\0', "min-time", 200                      , "Min. measuring time per benchmark in ms.");
+    parser.Var (corpusDir, '\0', "corpus"  , std::string{BENCH_CORPUS}, "Folder with CDDB responses (*.xmcd: read, *.txt: query).");
+    parser.Var (filter   , '\0', "filter"  , std::string{""}         , "Run only benchmarks containing this text.");
+
+    if (!parser.Parse(argc, argv))
+    {
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+    else if (help)
+    {
+        parser.PrintHelp(argv[0]);
+        return 0;
+    }
+
+    std::vector<SCorpusFile> corpus;
+
+    if (!loadCorpus(corpusDir, corpus))
+    {
+        std::cerr << "No corpus files found in '" << corpusDir << "'!" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::pair<std::string, std::function<void()>>> benches;
+
+    for (const auto& cf : corpus)
+    {
+        const std::string& in = cf.mContent;
+
+        if (cf.mName.size() > 4 && (cf.mName.compare(cf.mName.size() - 4, 4, ".txt") == 0))
+        {
+            benches.push_back({"parseCddbResults/" + cf.mName, [&in]()
+            {
+                CddbMatches_t matches;
+                g_sink = g_sink + parseCddbResults(in, matches) + matches.size();
+            }});
+            continue;
+        }
+
+        // xmcd record: raw titles for the transliteration benchmarks
+        auto rawTitles = std::make_shared<std::vector<std::string>>();
+        {
+            SXmcdData data;
+            parseXmcd(in, data);
+            rawTitles->push_back(data.mDiscTitle);
+            rawTitles->insert(rawTitles->end(), data.mTrackTitles.begin(), data.mTrackTitles.end());
+        }
+
+        benches.push_back({"parseXmcd/" + cf.mName, [&in]()
+        {
+            SXmcdData data;
+            g_sink = g_sink + parseXmcd(in, data) + data.mTrackTitles.size();
+        }});
+
+        benches.push_back({"parseXmcdOld/" + cf.mName, [&in]()
+        {
+            std::vector<std::string> info;
+            g_sink = g_sink + parseXmcdOld(in, info) + info.size();
+        }});
+
+        benches.push_back({"parseCddbInfo/" + cf.mName, [&in]()
+        {
+            std::vector<std::string> info;
+            g_sink = g_sink + parseCddbInfo(in, info) + info.size();
+        }});
+
+        benches.push_back({"toMdTitle/ascii/" + cf.mName, [rawTitles]()
+        {
+            for (const auto& t : *rawTitles)
+            {
+                g_sink = g_sink + toMdTitle(t, MdCharset::ASCII).size();
+            }
+        }});
+
+        benches.push_back({"toMdTitle/kana/" + cf.mName, [rawTitles]()
+        {
+            for (const auto& t : *rawTitles)
+            {
+                g_sink = g_sink + toMdTitle(t, MdCharset::KANA).size();
+            }
+        }});
+
+        benches.push_back({"makeGroupTitle/" + cf.mName, [rawTitles]()
+        {
+            g_sink = g_sink + makeGroupTitle(rawTitles->at(0)).size();
+        }});
+    }
+
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right
+              << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op" << std::endl
+              << std::string(80, '-') << std::endl;
+
+    for (const auto& b : benches)
+    {
+        if (!filter.empty() && (b.first.find(filter) == std::string::npos))
+        {
+            continue;
+        }
+
+        SBenchResult res = runBench(b.second, minTimeMs);
+
+        std::cout << std::left << std::setw(44) << b.first << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(1) << res.mNsPerOp
+                  << std::setw(12) << std::setprecision(1) << res.mAllocsPerOp
+                  << std::setw(12) << std::setprecision(0) << res.mBytesPerOp << std::endl;
+    }
+
+    return 0;
+}
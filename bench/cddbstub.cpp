@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Local stand-in CDDB server for tests and benchmarks of the metadata path.
+// Answers cddb query / read from the xmcd records in bench/corpus after a
+// configurable latency. Use it with cd2netmd or pipesim like
+//   cddbstub --port 8880 --latency 300 &
+//   ... --cddb-server http://localhost:8880/~cddb/cddb.cgi
+//
+#include "CCddbStub.h"
+#include "../Flags.hh"
+#include <csignal>
+#include <iostream>
+
+#ifndef BENCH_CORPUS
+    #define BENCH_CORPUS "corpus"
+#endif
+
+//------------------------------------------------------------------------------
+//! @brief      stand-in server main; runs until SIGINT / SIGTERM
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    bool help = false;
+    int  latency, jitter;
+    CCddbStub::SConfig cfg;
+
+    Flags parser;
+    parser.Bool(help          , 'h', "help"    , "Prints help screen and exits program.");
+    parser.Bool(cfg.mTls      , '\0', "tls"    , "Serve https with a self-signed certificate for localhost.");
+    parser.Var (cfg.mPort     , '\0', "port"   , 8880                     , "TCP port on localhost. 0 -> any free port.");
+    parser.Var (latency       , '\0', "latency", 0                        , "Delay in ms before every answer.");
+    parser.Var (jitter        , '\0', "jitter" , 0                        , "Random extra delay in ms (0 ... jitter).");
+    parser.Var (cfg.mCorpusDir, '\0', "corpus" , std::string{BENCH_CORPUS}, "Folder with xmcd records (*.xmcd).");
+    parser.Var (cfg.mCertOut  , '\0', "cert-out", std::string{""}         , "Write certificate (PEM) to this file (--tls). "
+                                                                            "Clients can trust it through SSL_CERT_FILE.");
+
+    if (!parser.Parse(argc, argv) || (latency < 0) || (jitter < 0))
+    {
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+    else if (help)
+    {
+        parser.PrintHelp(argv[0]);
+        return 0;
+    }
+
+    cfg.mLatencyMs = static_cast<uint32_t>(latency);
+    cfg.mJitterMs  = static_cast<uint32_t>(jitter);
+
+    // block signals in all threads, wait for them below
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+
+    CCddbStub   stub(cfg);
+    std::string error;
+
+    if (!stub.start(error))
+    {
+        std::cerr << error << std::endl;
+        return 2;
+    }
+
+    std::cout << "CDDB stand-in server: " << stub.url() << std::endl;
+
+    int sig;
+    sigwait(&sigs, &sig);
+    stub.stop();
+
+    std::cout << stub.requests() << " requests on " << stub.connections() << " connections." << std::endl;
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Tests of the sockets HTTP backend against the local stand-in CDDB server:
+// CDDB query / read, keep-alive reuse, cancel and - if built with OpenSSL - https
+// incl. certificate check.
+//
+#include "CCddbStub.h"
+#include "../CHttpClient.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#ifndef BENCH_CORPUS
+    #define BENCH_CORPUS "corpus"
+#endif
+
+static int g_iFailed = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; g_iFailed++; } } while (0)
+
+static const char* QUERY = "/~cddb/cddb.cgi?cmd=cddb+query+9b0bb80c+12+150+9150+2998&hello=me+localhost+bench+1&proto=6";
+static const char* READ  = "/~cddb/cddb.cgi?cmd=cddb+read+rock+9b0bb80c&hello=me+localhost+bench+1&proto=6";
+
+//------------------------------------------------------------------------------
+//! @brief      query and read on one client, checks keep-alive
+//!
+//! @param[in]  stub  running server
+//------------------------------------------------------------------------------
+static void queryAndRead(const CCddbStub& stub)
+{
+    SHttpUrl url;
+    CHECK(CHttpClient::parseUrl(stub.url(), url));
+
+    std::unique_ptr<CHttpClient> client = CHttpClient::create(url);
+    CHECK(client != nullptr);
+    if (client == nullptr)
+    {
+        return;
+    }
+
+    client->setTimeout(2000);
+
+    uint64_t requests    = stub.requests();
+    uint64_t connections = stub.connections();
+    SHttpResult res;
+    CHECK(client->get(QUERY, res));
+    CHECK(res.mStatus == 200);
+    CHECK(res.mBody.compare(0, 17, "200 rock 9b0bb80c") == 0);
+    CHECK(!res.mReused);
+
+    CHECK(client->get(READ, res));
+    CHECK(res.mStatus == 200);
+    CHECK(res.mBody.compare(0, 17, "210 rock 9b0bb80c") == 0);
+    CHECK(res.mBody.find("TTITLE11=Outro") != std::string::npos);
+    CHECK(res.mReused);
+
+    CHECK(client->get("/~cddb/cddb.cgi?cmd=cddb+query+00000000+1+150+60", res));
+    CHECK(res.mBody.compare(0, 3, "202") == 0);
+
+    // all three requests on one connection
+    CHECK(stub.requests() - requests == 3);
+    CHECK(stub.connections() - connections == 1);
+
+    // a cancel() before get() isn't lost, arm() resets it
+    client->cancel();
+    CHECK(!client->get(QUERY, res));
+    CHECK(res.mError == "Request cancelled");
+    CHECK(stub.requests() - requests == 3);
+
+    client->arm();
+    CHECK(client->get(QUERY, res) && (res.mStatus == 200));
+    CHECK(stub.requests() - requests == 4);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      test main
+//------------------------------------------------------------------------------
+int main()
+{
+    std::string error;
+
+    // plain http
+    {
+        CCddbStub::SConfig cfg;
+        cfg.mCorpusDir = BENCH_CORPUS;
+        CCddbStub stub(cfg);
+
+        CHECK(stub.start(error));
+        queryAndRead(stub);
+    }
+
+#ifdef C2N_OPENSSL
+    // https with self-signed certificate
+    {
+        std::string cert = "/tmp/httptest_" + std::to_string(getpid()) + ".pem";
+        CCddbStub::SConfig cfg;
+        cfg.mCorpusDir = BENCH_CORPUS;
+        cfg.mTls       = true;
+        cfg.mCertOut   = cert;
+        CCddbStub stub(cfg);
+
+        CHECK(stub.start(error));
+
+        // not trusted yet -> handshake must fail
+        {
+            SHttpUrl url;
+            SHttpResult res;
+            CHECK(CHttpClient::parseUrl(stub.url(), url));
+            auto client = CHttpClient::create(url);
+            CHECK((client != nullptr) && !client->get(QUERY, res));
+            CHECK(res.mError.find("TLS handshake") != std::string::npos);
+        }
+
+        // trust the server certificate
+        setenv("SSL_CERT_FILE", cert.c_str(), 1);
+        queryAndRead(stub);
+        unlink(cert.c_str());
+    }
+#else
+    std::cout << "https skipped (built without OpenSSL)" << std::endl;
+#endif
+
+    if (g_iFailed > 0)
+    {
+        std::cerr << g_iFailed << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,256 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Tests and latency benchmark of the hedged CDDB requests (CCddbMirrors)
+// against local stand-in CDDB servers. The tests check hedging, the
+// deadline and that a cancelled request isn't sent again; --bench runs
+// many requests against servers with random latency and prints the
+// latency distribution with and without hedging.
+//
+#include "CCddbStub.h"
+#include "../CCddbMirrors.h"
+#include "../Flags.hh"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef BENCH_CORPUS
+    #define BENCH_CORPUS "corpus"
+#endif
+
+static int g_iFailed = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; g_iFailed++; } } while (0)
+
+/// CDDB query as sent by cd2netmd (known disc)
+static const char* QUERY = "cddb+query+9b0bb80c+12+150+9150+2998&hello=me+localhost+bench+1&proto=6";
+
+typedef std::unique_ptr<CCddbStub> Stub_t;
+typedef std::chrono::steady_clock  clk;
+
+//------------------------------------------------------------------------------
+//! @brief      start stand-in servers
+//!
+//! @param[in]  count      number of servers
+//! @param[in]  latencyMs  latency of each server
+//! @param[in]  jitterMs   random extra latency
+//! @param[out] list       comma separated server URLs
+//!
+//! @return     servers
+//------------------------------------------------------------------------------
+static std::vector<Stub_t> startStubs(int count, uint32_t latencyMs, uint32_t jitterMs, std::string& list)
+{
+    std::vector<Stub_t> stubs;
+    std::string error;
+    list.clear();
+
+    for (int i = 0; i < count; i++)
+    {
+        CCddbStub::SConfig cfg;
+        cfg.mCorpusDir = BENCH_CORPUS;
+        cfg.mLatencyMs = latencyMs;
+        cfg.mJitterMs  = jitterMs;
+
+        stubs.emplace_back(new CCddbStub(cfg));
+        if (!stubs.back()->start(error))
+        {
+            std::cerr << error << std::endl;
+            exit(2);
+        }
+        list += (list.empty() ? "" : ",") + stubs.back()->url();
+    }
+    return stubs;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      one request, returns time needed in ms
+//------------------------------------------------------------------------------
+static int64_t timedRequest(CCddbMirrors& mirrors, SHttpResult& res, std::string& winner, bool& ok)
+{
+    auto start = clk::now();
+    ok = mirrors.request(QUERY, res, winner);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clk::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      functional tests
+//------------------------------------------------------------------------------
+static void runTests()
+{
+    std::string list, winner;
+    SHttpResult res;
+    bool        ok;
+    int64_t     ms;
+
+    // fast first mirror answers, the second one isn't asked
+    {
+        auto stubs = startStubs(2, 10, 0, list);
+        CCddbMirrors mirrors(list, 200, 2000);
+
+        ms = timedRequest(mirrors, res, winner, ok);
+        CHECK(ok && (winner == stubs[0]->url()));
+        CHECK(res.mBody.compare(0, 17, "200 rock 9b0bb80c") == 0);
+        CHECK(ms < 200);
+        CHECK(stubs[1]->requests() == 0);
+    }
+
+    // slow first mirror: second one is asked after the hedge delay and wins;
+    // the cancelled request on the kept-alive connection isn't sent again
+    {
+        auto stubs = startStubs(2, 0, 0, list);
+        CCddbMirrors mirrors(list, 100, 3000);
+
+        CHECK(mirrors.request(QUERY, res, winner) && (winner == stubs[0]->url()));
+
+        stubs[0]->setLatency(1500);
+        stubs[1]->setLatency(20);
+
+        ms = timedRequest(mirrors, res, winner, ok);
+        CHECK(ok && (winner == stubs[1]->url()));
+        CHECK((ms >= 100) && (ms < 600));
+
+        // give a wrongly retrying loser the time to reconnect
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        CHECK(stubs[0]->requests() == 2);
+        CHECK(stubs[0]->connections() == 1);
+
+        // the winner is asked first next time
+        stubs[0]->setLatency(0);
+        CHECK(mirrors.request(QUERY, res, winner) && (winner == stubs[1]->url()));
+        CHECK(stubs[1]->requests() == 2);
+    }
+
+    // nobody answers within the deadline
+    {
+        auto stubs = startStubs(2, 2000, 0, list);
+        CCddbMirrors mirrors(list, 50, 300);
+
+        ms = timedRequest(mirrors, res, winner, ok);
+        CHECK(!ok && winner.empty());
+        CHECK((ms >= 300) && (ms < 600));
+        CHECK(res.mError.find("300 ms") != std::string::npos);
+    }
+
+    // unknown disc (202) on all mirrors is no valid answer
+    {
+        auto stubs = startStubs(2, 0, 0, list);
+        CCddbMirrors mirrors(list, 50, 1000);
+
+        ok = mirrors.request("cddb+query+00000000+1+150+60&proto=6", res, winner);
+        CHECK(!ok);
+        CHECK(stubs[0]->requests() == 1);
+        CHECK(stubs[1]->requests() == 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      latency distribution of requests
+//!
+//! @param[in]  count    number of requests
+//! @param[in]  mirrors  number of servers
+//! @param[in]  latency  base latency of each server
+//! @param[in]  jitter   random extra latency of each server
+//! @param[in]  hedgeMs  hedge delay
+//------------------------------------------------------------------------------
+static void runBench(int count, int mirrors, uint32_t latency, uint32_t jitter, uint32_t hedgeMs)
+{
+    std::string list, winner;
+    auto stubs = startStubs(mirrors, latency, jitter, list);
+
+    auto measure = [&](const std::string& servers, uint32_t hedge, const char* label)
+    {
+        CCddbMirrors cm(servers, hedge, 10000);
+        std::vector<int64_t> lat;
+        SHttpResult res;
+        bool ok;
+        int  errors = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            lat.push_back(timedRequest(cm, res, winner, ok));
+            errors += ok ? 0 : 1;
+        }
+
+        std::sort(lat.begin(), lat.end());
+        auto pct = [&lat](double p){ return lat[std::min(lat.size() - 1, static_cast<size_t>(p * lat.size()))]; };
+
+        std::cout << std::left << std::setw(28) << label << std::right
+                  << std::setw(8) << pct(0.5) << std::setw(8) << pct(0.95)
+                  << std::setw(8) << pct(0.99) << std::setw(8) << lat.back()
+                  << std::setw(8) << errors << std::endl;
+    };
+
+    std::cout << count << " requests, " << mirrors << " servers, latency " << latency << " + 0..."
+              << jitter << " ms" << std::endl
+              << std::left << std::setw(28) << "ms" << std::right << std::setw(8) << "p50" << std::setw(8) << "p95"
+              << std::setw(8) << "p99" << std::setw(8) << "max" << std::setw(8) << "errors" << std::endl;
+
+    measure(stubs[0]->url(), hedgeMs, "single server");
+    measure(list, hedgeMs, ("hedged after " + std::to_string(hedgeMs) + " ms").c_str());
+}
+
+//------------------------------------------------------------------------------
+//! @brief      test / benchmark main
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    bool help = false;
+    int  count, mirrors, latency, jitter, hedge;
+
+    Flags parser;
+    parser.Bool(help   , 'h', "help"    , "Prints help screen and exits program.");
+    parser.Var (count  , '\0', "bench"  , 0  , "Run this many requests and print latency percentiles instead of the tests.");
+    parser.Var (mirrors, '\0', "mirrors", 3  , "Number of servers (--bench).");
+    parser.Var (latency, '\0', "latency", 20 , "Base latency of the servers in ms (--bench).");
+    parser.Var (jitter , '\0', "jitter" , 400, "Random extra latency of the servers in ms (--bench).");
+    parser.Var (hedge  , '\0', "hedge"  , 60 , "Hedge delay in ms (--bench).");
+
+    if (!parser.Parse(argc, argv) || (mirrors < 1) || (latency < 0) || (jitter < 0) || (hedge < 0))
+    {
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+    else if (help)
+    {
+        parser.PrintHelp(argv[0]);
+        return 0;
+    }
+
+    if (count > 0)
+    {
+        runBench(count, mirrors, latency, jitter, hedge);
+        return 0;
+    }
+
+    runTests();
+
+    if (g_iFailed > 0)
+    {
+        std::cerr << g_iFailed << " check(s) failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Stand-in for netmdcli, used to time the cd2netmd pipeline without a
+// NetMD device (cd2netmd -t bench/ or pipesim). It understands the commands
+// cd2netmd sends, emulates the transfer time of a track and prints the
+// progress lines parsePercent() reads. The emulated MD is always empty.
+//
+// environment:
+//   BENCH_TRF_SP    transfer speed in SP mode  (realtime factor, default: 4)
+//   BENCH_TRF_LP2   transfer speed in LP2 mode (realtime factor, default: 16)
+//   BENCH_TRF_LP4   transfer speed in LP4 mode (realtime factor, default: 32)
+//   BENCH_MD_CMD_MS time for every device command (USB setup, TOC write; default: 200)
+//
+#include "benchwav.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! @brief      get a numeric setting from environment
+//!
+//! @param[in]  name  variable name
+//! @param[in]  def   default value
+//!
+//! @return     value
+//------------------------------------------------------------------------------
+static double envValue(const char* name, double def)
+{
+    const char* env = std::getenv(name);
+    return (env != nullptr) ? std::max(0.0, std::atof(env)) : def;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      emulate the transfer of a wave file
+//!
+//! @param[in]  file  wave file
+//! @param[in]  mode  "sp", "lp2", "lp4" or empty (-> taken from file)
+//!
+//! @return     0 -> ok; else -> error
+//------------------------------------------------------------------------------
+static int sendTrack(const std::string& file, std::string mode)
+{
+    SWavInfo wav;
+
+    if (!wavReadInfo(file, wav))
+    {
+        std::cerr << "Can't read wave file " << file << std::endl;
+        return 2;
+    }
+
+    if (mode.empty())
+    {
+        if (wav.mFormat == WAVE_FMT_ATRAC3)
+        {
+            mode = (wav.mByteRate < 10000) ? "lp4" : "lp2";
+        }
+        else
+        {
+            mode = "sp";
+        }
+    }
+
+    double speed = (mode == "lp4") ? envValue("BENCH_TRF_LP4", 32.0)
+                 : (mode == "lp2") ? envValue("BENCH_TRF_LP2", 16.0)
+                 :                   envValue("BENCH_TRF_SP" ,  4.0);
+
+    typedef std::chrono::steady_clock clk;
+    auto     start   = clk::now();
+    auto     total   = std::chrono::duration<double>(wav.seconds() / std::max(speed, 0.1));
+    uint32_t bytes   = wav.mDataSize;
+    int      percent = -1;
+
+    for (;;)
+    {
+        double done = std::min((clk::now() - start) / total, 1.0);
+        int    p    = static_cast<int>(done * 100.0);
+
+        if (p != percent)
+        {
+            percent = p;
+            std::cout << "Transferred " << static_cast<uint32_t>(bytes * done) << " of "
+                      << bytes << " bytes (" << percent << "%)" << std::endl;
+        }
+
+        if (done >= 1.0)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      stand-in netmdcli main
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args;
+    std::string mode;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "-v")
+        {
+            continue;
+        }
+        else if ((arg == "-d") && (i + 1 < argc))
+        {
+            mode = argv[++i];
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty())
+    {
+        std::cerr << "usage: netmdcli [-v] [-d lp2|lp4] <command> [args]" << std::endl;
+        return 1;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(envValue("BENCH_MD_CMD_MS", 200.0))));
+
+    const std::string& cmd = args[0];
+
+    if (cmd == "json_short")
+    {
+        std::cout << R"({"device":"Bench NetMD","title":"","otf_enc":1,"trk_count":0,)"
+                  << R"("t_used":0,"t_total":4800,"t_free":4800})" << std::endl;
+    }
+    else if (cmd == "json")
+    {
+        std::cout << R"({"device":"Bench NetMD","title":"","otf_enc":1,"trk_count":0,)"
+                  << R"("t_used":0,"t_total":4800,"t_free":4800,"groups":[],"tracks":[]})" << std::endl;
+    }
+    else if ((cmd == "send") && (args.size() > 1))
+    {
+        return sendTrack(args[1], mode);
+    }
+    else if ((cmd == "erase") || (cmd == "rename_disc") || (cmd == "rename") || (cmd == "add_group"))
+    {
+        // nothing to emulate beside the command time
+    }
+    else
+    {
+        std::cerr << "Unknown command " << cmd << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,461 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+
+//
+// Pipeline benchmark for Linux hosts w/o CD drive and NetMD device.
+// A synthetic CD image is "ripped" at a configurable read speed, the
+// tracks are encoded by the stand-in atracdenc and transferred through the
+// stand-in netmdcli - both are started as external processes, same as in
+// cd2netmd. Encoder scheduling, reorder buffer, transfer and late titling
+// are the ones of cd2netmd (CTrackPipeline); only drive, encoder and device
+// are simulated here. Like in cd2netmd the device is probed while the drive
+// spins up, and the CDDB titles may come in after the first transfer
+// (--cddb-ms). At the end wall time and busy time / utilisation of each
+// stage are printed.
+//
+#include "benchwav.hpp"
+#include "../CStageTimer.hpp"
+#include "../CTrackPipeline.h"
+#include "../Flags.hh"
+#include "../progress.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/// CD sector size and sectors per second at 1x
+static constexpr uint32_t CD_SECTOR_SIZE  = 2352;
+static constexpr uint32_t CD_SECTORS_PER_SEC = 75;
+
+/// simulation settings
+struct SSimConfig
+{
+    int         mTracks     = 12;
+    int         mTrackLen   = 240;
+    int         mLastLen    = 0;
+    double      mReadSpeed  = 8.0;
+    int         mSpinUpMs   = 1500;
+    int         mCddbMs     = 0;
+    std::string mXEncoding  = "no";
+    std::string mEncoding   = "sp";
+    int         mEncThreads = 0;
+    std::string mToolchain;
+    std::string mWorkDir;
+    bool        mVerbose    = false;
+
+    /// length of track t in seconds
+    int trackLen(int t) const
+    {
+        return ((t == mTracks - 1) && (mLastLen > 0)) ? mLastLen : mTrackLen;
+    }
+};
+
+std::atomic_bool g_bAbort = {false};
+std::atomic<uint64_t> g_u64RipBusyMs = {0};
+StatClock_t::time_point g_tpStart;
+
+//------------------------------------------------------------------------------
+//! @brief      run a tool and feed its output lines to parsePercent()
+//!
+//! @param[in]  cmdLine  command line
+//! @param[in]  verbose  print last percent value
+//!
+//! @return     exit code of the tool; -1 if it can't be started
+//------------------------------------------------------------------------------
+static int runTool(const std::string& cmdLine, bool verbose)
+{
+    FILE* p = popen((cmdLine + " 2>&1").c_str(), "r");
+
+    if (p == nullptr)
+    {
+        return -1;
+    }
+
+    char line[512];
+    int  percent = 0;
+
+    while (fgets(line, sizeof(line), p) != nullptr)
+    {
+        parsePercent(line, percent);
+    }
+
+    int rc = pclose(p);
+
+    if (verbose)
+    {
+        std::cout << "  " << cmdLine << " -> " << percent << "%, rc " << rc << std::endl;
+    }
+
+    return (rc == 0) ? 0 : ((rc < 0) ? -1 : WEXITSTATUS(rc));
+}
+
+//------------------------------------------------------------------------------
+//! @brief      "rip" one track of the synthetic CD image at read speed
+//!
+//! @param[in]  cfg   simulation settings
+//! @param[in]  t     track index
+//! @param[in]  file  track file
+//!
+//! @return     true -> ok
+//------------------------------------------------------------------------------
+static bool ripTrack(const SSimConfig& cfg, int t, const std::string& file)
+{
+    typedef std::chrono::duration<double> sec_t;
+
+    // 1 second of audio at 1x, split into chunks the size of a read request
+    const uint32_t chunkSectors = 26;
+    const uint32_t chunkBytes   = chunkSectors * CD_SECTOR_SIZE;
+    std::vector<int16_t> chunk(chunkBytes / 2);
+    uint32_t noise = 0x12345678;
+
+    uint32_t sectors = cfg.trackLen(t) * CD_SECTORS_PER_SEC;
+    auto     start   = StatClock_t::now();
+    FILE*    f       = fopen(file.c_str(), "wb");
+
+    if (f == nullptr)
+    {
+        std::cerr << "Can't create " << file << std::endl;
+        return false;
+    }
+
+    wavWritePcmHeader(f, sectors * CD_SECTOR_SIZE);
+
+    for (uint32_t s = 0, pos = 0; s < sectors; s += chunkSectors)
+    {
+        uint32_t cnt = std::min(chunkSectors, sectors - s);
+
+        // tone per track plus some noise, so the "encoder" has real data
+        for (uint32_t i = 0; i < cnt * CD_SECTOR_SIZE / 4; i++, pos++)
+        {
+            noise = noise * 1664525 + 1013904223;
+            int16_t v = static_cast<int16_t>(8000.0 * std::sin(pos * (t + 1) * 0.0125) + (noise >> 22) - 512);
+            chunk[2 * i]     = v;
+            chunk[2 * i + 1] = v;
+        }
+
+        fwrite(chunk.data(), 1, cnt * CD_SECTOR_SIZE, f);
+
+        // drive read speed
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<StatClock_t::duration>(
+            sec_t((s + cnt) / (CD_SECTORS_PER_SEC * cfg.mReadSpeed))));
+    }
+
+    fclose(f);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      encode a track in place through the stand-in atracdenc
+//!             (see externAtrac3Encode())
+//!
+//! @param[in]  cfg   simulation settings
+//! @param[in]  wav   track file
+//!
+//! @return     true -> ok
+//------------------------------------------------------------------------------
+static bool encodeTrack(const SSimConfig& cfg, const std::string& wav)
+{
+    bool lp4 = (cfg.mXEncoding == "lp4");
+    bool ok  = false;
+    std::string aea = wav + ".aea";
+    std::ostringstream cmd;
+    cmd << "\"" << cfg.mToolchain << "atracdenc\" -e atrac3 --bitrate=" << (lp4 ? 64 : 128)
+        << " -i \"" << wav << "\" -o \"" << aea << "\"";
+
+    if (runTool(cmd.str(), cfg.mVerbose) == 0)
+    {
+        // wrap atrac3 frames into a wave file
+        FILE* in  = fopen(aea.c_str(), "rb");
+        FILE* out = fopen(wav.c_str(), "wb");
+
+        if ((in != nullptr) && (out != nullptr))
+        {
+            fseek(in, 0, SEEK_END);
+            uint32_t sz = static_cast<uint32_t>(ftell(in)) - AEA_HEADER_SIZE;
+            fseek(in, AEA_HEADER_SIZE, SEEK_SET);
+            wavWriteAtrac3Header(out, lp4, sz);
+
+            char   buff[16'384];
+            size_t rd;
+            while ((rd = fread(buff, 1, sizeof(buff), in)) > 0)
+            {
+                fwrite(buff, 1, rd, out);
+            }
+            ok = true;
+        }
+
+        if (in  != nullptr) fclose(in);
+        if (out != nullptr) fclose(out);
+        unlink(aea.c_str());
+    }
+
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      Prints the pipeline statistics (same layout as cd2netmd --stats).
+//!
+//! @param[in]  cfg        simulation settings
+//! @param[in]  pipe       pipeline
+//! @param[in]  startupMs  time needed until the rip starts
+//------------------------------------------------------------------------------
+static void printStats(const SSimConfig& cfg, const CTrackPipeline& pipe, uint64_t startupMs)
+{
+    uint64_t wallMs = msSince(g_tpStart);
+
+    auto stageLine = [wallMs](const char* stage, uint64_t busyMs, int workers = 1)
+    {
+        std::cout << std::left << std::setw(22) << stage << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (busyMs / 1000.0) << "s";
+
+        if (wallMs > 0)
+        {
+            std::cout << " (" << std::setw(3) << ((busyMs * 100) / (wallMs * std::max(workers, 1))) << "% busy";
+            if (workers > 1)
+            {
+                std::cout << " on " << workers << " threads";
+            }
+            std::cout << ")";
+        }
+        std::cout << std::endl;
+    };
+
+    uint64_t discMs = 0;
+
+    for (int t = 0; t < cfg.mTracks; t++)
+    {
+        discMs += static_cast<uint64_t>(cfg.trackLen(t)) * 1000;
+    }
+
+    std::cout << std::endl
+              << "Statistics:" << std::endl
+              << "===========" << std::endl;
+
+    stageLine("Total wall time:"      , wallMs);
+    stageLine("Startup:"              , startupMs);
+    stageLine("Time to 1st transfer:" , pipe.mFirstTrfMs);
+    stageLine("CD-Rip:"               , g_u64RipBusyMs);
+
+    if (cfg.mXEncoding != "no")
+    {
+        stageLine("X-Encode:"         , pipe.mEncBusyMs, cfg.mEncThreads);
+    }
+
+    stageLine("MD Transfer:"          , pipe.mTrfBusyMs);
+
+    std::cout << std::left << std::setw(22) << "Disc time:" << std::right << std::setw(8)
+              << (discMs / 1000.0) << "s" << std::endl;
+
+    if (wallMs > 0)
+    {
+        std::cout << std::left << std::setw(22) << "Disc speed:" << std::right << std::setw(8)
+                  << (static_cast<double>(discMs) / wallMs) << "x" << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      pipeline benchmark main
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    SSimConfig cfg;
+    bool   help = false;
+    double encRtf, trfSp, trfLp2, trfLp4;
+    int    cmdMs;
+
+    // stand-in tools are built next to this program
+    std::string self = argv[0];
+    std::string toolDir = (self.rfind('/') != std::string::npos) ? self.substr(0, self.rfind('/') + 1) : "./";
+
+    Flags parser;
+    parser.Bool(help          , 'h', "help"       , "Prints help screen and exits program.");
+    parser.Bool(cfg.mVerbose  , 'v', "verbose"    , "Prints every tool run.");
+    parser.Var (cfg.mTracks   , '\0', "tracks"    , 12              , "Number of tracks on the synthetic CD.");
+    parser.Var (cfg.mTrackLen , '\0', "track-len" , 240             , "Length of each track in seconds.");
+    parser.Var (cfg.mLastLen  , '\0', "last-len"  , 0               , "Length of the last track in seconds. 0 -> same as the others.");
+    parser.Var (cfg.mReadSpeed, '\0', "read-speed", 8.0             , "CD read speed (e.g. 8 for 8x).");
+    parser.Var (cfg.mSpinUpMs , '\0', "spin-up"   , 1500            , "Spin-up time of the drive in ms.");
+    parser.Var (cfg.mCddbMs   , '\0', "cddb-ms"   , 0               , "Time until the CDDB titles are known in ms.");
+    parser.Var (cfg.mEncoding , 'e', "encode"     , std::string{"sp"}, "On-the-fly encoding mode of the device: sp, lp2, lp4.");
+    parser.Var (cfg.mXEncoding, 'x', "ext-encode" , std::string{"no"}, "External encoding: no, lp2, lp4.");
+    parser.Var (cfg.mEncThreads, '\0', "enc-threads", 0             , "Number of parallel encoder jobs. 0 -> one per CPU core.");
+    parser.Var (encRtf        , '\0', "enc-rtf"   , 20.0            , "Realtime factor of one encoder job.");
+    parser.Var (trfSp         , '\0', "trf-sp"    , 4.0             , "Transfer speed in SP mode (realtime factor).");
+    parser.Var (trfLp2        , '\0', "trf-lp2"   , 16.0            , "Transfer speed in LP2 mode (realtime factor).");
+    parser.Var (trfLp4        , '\0', "trf-lp4"   , 32.0            , "Transfer speed in LP4 mode (realtime factor).");
+    parser.Var (cmdMs         , '\0', "md-cmd-ms" , 200             , "Time of every NetMD command in ms.");
+    parser.Var (cfg.mToolchain, 't', "toolchain"  , toolDir         , "Path to the stand-in tools (with trailing slash).");
+    parser.Var (cfg.mWorkDir  , '\0', "work-dir"  , std::string{"/tmp"}, "Folder for the track files.");
+
+    if (!parser.Parse(argc, argv))
+    {
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+    else if (help)
+    {
+        parser.PrintHelp(argv[0]);
+        return 0;
+    }
+
+    if ((cfg.mTracks < 1) || (cfg.mTracks > 99) || (cfg.mTrackLen < 1) || (cfg.mLastLen < 0) || (cfg.mReadSpeed <= 0.0)
+        || ((cfg.mXEncoding != "no") && (cfg.mXEncoding != "lp2") && (cfg.mXEncoding != "lp4"))
+        || ((cfg.mEncoding != "sp") && (cfg.mEncoding != "lp2") && (cfg.mEncoding != "lp4")))
+    {
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+
+    if (cfg.mXEncoding != "no")
+    {
+        cfg.mEncoding = "sp";
+    }
+
+    if (cfg.mEncThreads <= 0)
+    {
+        cfg.mEncThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // settings for the stand-in tools
+    setenv("BENCH_ENC_RTF"  , std::to_string(encRtf).c_str(), 1);
+    setenv("BENCH_TRF_SP"   , std::to_string(trfSp).c_str() , 1);
+    setenv("BENCH_TRF_LP2"  , std::to_string(trfLp2).c_str(), 1);
+    setenv("BENCH_TRF_LP4"  , std::to_string(trfLp4).c_str(), 1);
+    setenv("BENCH_MD_CMD_MS", std::to_string(cmdMs).c_str() , 1);
+
+    std::vector<std::string> files;
+
+    for (int t = 0; t < cfg.mTracks; t++)
+    {
+        files.push_back(cfg.mWorkDir + "/pipesim_" + std::to_string(getpid()) + "_" + std::to_string(t + 1) + ".wav");
+    }
+
+    std::cout << "Synthetic CD: " << cfg.mTracks << " x " << cfg.mTrackLen << "s, read speed "
+              << cfg.mReadSpeed << "x, mode " << ((cfg.mXEncoding != "no") ? (cfg.mXEncoding + " (external)") : cfg.mEncoding)
+              << std::endl;
+
+    g_tpStart = StatClock_t::now();
+
+    // probe device while the drive spins up, like cd2netmd does
+    int probe = 0;
+    std::thread MDProbe([&cfg, &probe]()
+    {
+        probe = runTool("\"" + cfg.mToolchain + "netmdcli\" json_short", cfg.mVerbose);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.mSpinUpMs));
+    MDProbe.join();
+
+    if (probe != 0)
+    {
+        std::cerr << "Can't run stand-in netmdcli from '" << cfg.mToolchain << "'!" << std::endl;
+        return 2;
+    }
+
+    // device stand-in; LP modes are grouped, so the disc title names the group
+    std::string netmd   = "\"" + cfg.mToolchain + "netmdcli\" -v ";
+    std::string mode    = (cfg.mXEncoding == "no") && (cfg.mEncoding != "sp") ? ("-d " + cfg.mEncoding + " ") : "";
+    bool        isLp    = (cfg.mXEncoding != "no") || (cfg.mEncoding != "sp");
+    std::atomic_int written = {0};
+
+    CTrackPipeline pipe(g_bAbort);
+
+    CTrackPipeline::SConfig pipeCfg;
+    pipeCfg.mEncThreads = cfg.mEncThreads;
+    pipeCfg.mVerbose    = cfg.mVerbose;
+    pipeCfg.mStart      = g_tpStart;
+
+    CTrackPipeline::STools pipeTools;
+    if (cfg.mXEncoding != "no")
+    {
+        pipeTools.mEncode = [&cfg](const std::string& file){ return encodeTrack(cfg, file); };
+    }
+    pipeTools.mWriteTrack = [&](const std::string& file, const std::string& title)
+    {
+        bool ok = runTool(netmd + mode + "send \"" + file + "\" \"" + title + "\"", cfg.mVerbose) == 0;
+        if (ok) written++;
+        return ok;
+    };
+    pipeTools.mEraseDisc = [&](){ runTool(netmd + "erase force", cfg.mVerbose); };
+    pipeTools.mDiscTitle = [&]()
+    {
+        runTool(netmd + "rename_disc \"" + (isLp ? std::string{} : pipe.title(0)) + "\"", cfg.mVerbose);
+    };
+    pipeTools.mTrackTitle = [&](int mdTrack, const std::string& title)
+    {
+        runTool(netmd + "rename " + std::to_string(mdTrack) + " \"" + title + "\"", cfg.mVerbose);
+    };
+
+    pipe.start(pipeCfg, pipeTools);
+
+    // CDDB lookup runs in background, titles are bound to the
+    // tracks right before they are transferred
+    std::thread CddbLookup([&cfg, &pipe]()
+    {
+        std::vector<std::string> titles = {"Synthetic CD"};
+
+        for (int t = 0; t < cfg.mTracks; t++)
+        {
+            titles.push_back("Track " + std::to_string(t + 1));
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(cfg.mCddbMs));
+        pipe.setTitles(titles);
+    });
+
+    uint64_t startupMs = msSince(g_tpStart);
+
+    for (int t = 0; (t < cfg.mTracks) && !g_bAbort; t++)
+    {
+        bool ripped;
+        {
+            CStageTimer tm(g_u64RipBusyMs);
+            ripped = ripTrack(cfg, t, files[t]);
+        }
+
+        if (!ripped)
+        {
+            // the tracks on MD would be out of order -> stop here
+            std::cerr << "Ripping of track " << t + 1 << " failed, stopping!" << std::endl;
+            g_bAbort = true;
+            break;
+        }
+
+        STrackDescr job = {"", files[t], t, cfg.trackLen(t) * CD_SECTORS_PER_SEC * CD_SECTOR_SIZE};
+        pipe.queue(job);
+    }
+
+    // wait for encoder threads, md writing and CDDB lookup
+    pipe.finish();
+    CddbLookup.join();
+
+    if (isLp && !g_bAbort && (written > 0))
+    {
+        runTool(netmd + "add_group \"" + pipe.title(0) + "\" 1 " + std::to_string(written), cfg.mVerbose);
+    }
+
+    std::cout << written << " of " << cfg.mTracks << " tracks transferred." << std::endl;
+    printStats(cfg, pipe, startupMs);
+
+    return (written == cfg.mTracks) ? 0 : 3;
+}
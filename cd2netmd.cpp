@@ -20,7 +20,6 @@
 #include <cstdint>
 #include <cstdio>
 #include <fileapi.h>
-#include <iconv.h>
 #include <ostream>
 #include <string>
 #include <iostream>
@@ -29,22 +28,34 @@
 #include <synchapi.h>
 #include <thread>
 #include <vector>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
 #include <condition_variable>
 #include <atomic>
 #include <windows.h>
 #include <tchar.h>
 #include <io.h>
-#include "WinHttpWrapper.h"
 #include "CAudioCD.h"
 #include "Flags.hh"
 #include "CPipeStream.hpp"
+#include "CStageTimer.hpp"
+#include "CTrackPipeline.h"
 #include "json.hpp"
 #include "utils.h"
+#include "cddb.h"
+#include "CCddbCache.h"
+#include "CCddbMirrors.h"
+#include "titleplan.h"
+#include "progress.h"
+#include "CAccurateRip.h"
+#include "drivebench.h"
 
 /// tool version
 static constexpr const char* C2N_VERSION = "v0.4.0";
 
-/// tool chain path
+/// default tool chain path
 static constexpr const char* TOOLCHAIN_PATH = "toolchain/";
 
 /// Sony WAVE format
@@ -66,47 +77,54 @@ enum class NetMDCmds : uint8_t {
     WRITE_TRACK_LP4,    ///< write track in lp4
     JSON_INFO,          ///< request json disc info
     JSON_SUMMARY,       ///< request json disc info
-    GROUP_TRACK         ///< group tracks
+    GROUP_TRACK,        ///< group tracks
+    TRACK_TITLE         ///< (re-)title a track
 };
 
-/// store track file name and title
-struct STrackDescr 
-{
-    std::string mName;  ///< track title
-    std::string mFile;  ///< file name
-};
-
-/// define track vector type
-typedef std::vector<STrackDescr> TrackVector_t;
-
+/// MD TOC title space (set before the NetMD write thread starts)
+size_t cddb_FreeCells  = MD_TITLE_CELLS; ///< cells for disc record and new track titles
+size_t cddb_DiscFixed  = 0;              ///< kept characters of the disc title record
+bool   cddb_TitleGroup = false;          ///< title 0 becomes the name of a new group
 
-/// NetMD transfer thread
-std::mutex trf_mtxTracks;       ///< synchronize access to track description vector
-TrackVector_t trf_TracksDescr;  ///< track description vector
- 
-std::mutex trf_m;               ///< mutex for NetMD write thread synchronization
-std::condition_variable trf_cv; ///< condition variable for NetMD write thread synchronization
-bool trf_ready = false;         ///< synchronization helper
-bool trf_complete = false;      ///< synchronization helper
+/// console prompts
+std::mutex g_mtxPrompt;               ///< serializes interactive prompts
+std::atomic_bool g_bPrompt = {false}; ///< prompt active -> pause status bar
+std::atomic_bool g_bAbort  = {false}; ///< user aborted while pipeline runs
 
-/// external encoder thread
-std::mutex xenc_mtxTracks;       ///< synchronize access to track description vector
-TrackVector_t xenc_TracksDescr;  ///< track description vector
- 
-std::mutex xenc_m;               ///< mutex for NetMD write thread synchronization
-std::condition_variable xenc_cv; ///< condition variable for NetMD write thread synchronization
-bool xenc_ready = false;         ///< synchronization helper
-bool xenc_complete = false;      ///< synchronization helper
+/// encoder threads, NetMD write thread and title binding
+CTrackPipeline g_Pipe(g_bAbort);
 
 /// cmd line parameters
 bool        g_bVerbose;     ///< do verbose output if set
 bool        g_bHelp;        ///< print help if set
 bool        g_bAppend;      ///< append tracks, don't delete MD before writing
 bool        g_bNoCDDBLookup;///< don't use CDDB lookup
+bool        g_bNoCdText;    ///< don't use CD-Text
+std::string g_sMdCharset;   ///< MD title charset (ascii, kana, auto)
 bool        g_bDontGroup;   ///< don't group new tracks in lp mode
 char        g_cDrive;       ///< drive letter of CD drive
 std::string g_sEncoding;    ///< NetMD encoding
 std::string g_sXEncoding;   ///< NetMD external encoding
+std::string g_sToolchain;   ///< path to external tools (atracdenc, netmdcli)
+int         g_iEncThreads;  ///< number of parallel external encoder threads
+std::string g_sCddbCache;   ///< CDDB cache directory
+std::string g_sFreedbDump;  ///< freedb dump directory
+std::string g_sCddbServer;  ///< CDDB server URLs (comma separated)
+int         g_iCddbHedge;   ///< delay in ms before the next CDDB mirror is asked
+int         g_iCddbTimeout; ///< deadline in ms for one CDDB request
+bool        g_bStats;       ///< print pipeline statistics at exit
+bool        g_bSecure;      ///< rip every track twice and compare
+int         g_iMaxSpeed;    ///< max. CD read speed (x), 0 -> drive max
+bool        g_bBenchDrive;  ///< run drive benchmark only
+bool        g_bTrimSilence; ///< cut silence at start / end of tracks
+int         g_iSilThreshold;///< max. sample value counted as silence
+int         g_iSilMinMs;    ///< min. length of silence to cut
+std::string g_sArDb;        ///< AccurateRip database directory
+std::string g_sReadOffset;  ///< drive read offset in samples (empty -> unknown)
+std::string g_sNormalize;   ///< loudness normalisation (no, track, album)
+double      g_dTargetLufs;  ///< target loudness in LUFS
+double      g_dTruePeak;    ///< max. true peak after gain in dBTP
+bool        g_bNoDeEmph;    ///< keep pre-emphasis of flagged tracks
 
 /// stdout handle for piping of external tools' output
 HANDLE g_hNetMDCli_stdout_wr = INVALID_HANDLE_VALUE;
@@ -119,8 +137,155 @@ HANDLE g_hCDRip_stdout_rd    = INVALID_HANDLE_VALUE;
 /// status line helper
 int g_iNoTracks = 0;
 int g_iRipTrack = 0;
-int g_iEncTrack = 0;
-int g_iTrfTrack = 0;
+
+/// pipeline statistics (busy time per stage in ms)
+std::atomic<uint64_t> g_u64RipBusyMs = {0};
+StatClock_t::time_point g_tpStart;          ///< program start
+
+//------------------------------------------------------------------------------
+//! @brief      This class serializes interactive console prompts between
+//!             threads and pauses the status bar while a prompt is shown.
+//------------------------------------------------------------------------------
+class CPromptLock
+{
+    std::lock_guard<std::mutex> mLock;
+
+public:
+    CPromptLock() : mLock(g_mtxPrompt)
+    {
+        g_bPrompt = true;
+        std::cout << std::endl;
+    }
+
+    ~CPromptLock()
+    {
+        g_bPrompt = false;
+    }
+};
+
+//------------------------------------------------------------------------------
+//! @brief      compute the title space left on MD
+//!
+//! @param[in]  isLp        lp mode flag
+//! @param[in]  mdOffset    number of tracks on MD before our first one
+//! @param[in]  trackCount  number of tracks to write
+//! @param[in]  jTitles     full disc info (append mode only)
+//------------------------------------------------------------------------------
+void setTitleSpace(bool isLp, int mdOffset, uint32_t trackCount, const nlohmann::json& jTitles)
+{
+    size_t usedCells = 0;
+    size_t discChars = 0;
+    bool   hasGroups = false;
+
+    // titles we keep in append mode
+    if (g_bAppend && jTitles.is_object())
+    {
+        try
+        {
+            auto trackCells = [&usedCells](const nlohmann::json& tracks, int& first, int& last)
+            {
+                for (const auto& t : tracks)
+                {
+                    int no = t.value("no", 0) + 1;
+                    usedCells += titleCells(t.value("name", std::string{}).size());
+                    first = (first == 0) ? no : std::min(first, no);
+                    last  = std::max(last, no);
+                }
+            };
+
+            int first = 0, last = 0;
+            discChars = jTitles.value("title", std::string{}).size();
+
+            if (jTitles.contains("groups") && jTitles["groups"].is_array())
+            {
+                for (const auto& g : jTitles["groups"])
+                {
+                    first = last = 0;
+                    hasGroups = true;
+
+                    if (g.contains("tracks") && g["tracks"].is_array())
+                    {
+                        trackCells(g["tracks"], first, last);
+                    }
+
+                    // <first>-<last>;<name>//
+                    discChars += std::to_string(first).size() + ((last > first) ? (std::to_string(last).size() + 1) : 0)
+                               + 1 + g.value("name", std::string{}).size() + 2;
+                }
+            }
+
+            if (jTitles.contains("tracks") && jTitles["tracks"].is_array())
+            {
+                trackCells(jTitles["tracks"], first, last);
+            }
+        }
+        catch(...)
+        {
+            std::cerr << "Can't read titles on MD, title space unknown!" << std::endl;
+        }
+    }
+
+    cddb_TitleGroup = isLp && !g_bDontGroup;
+    cddb_FreeCells  = (usedCells < MD_TITLE_CELLS) ? (MD_TITLE_CELLS - usedCells) : 0;
+    cddb_DiscFixed  = g_bAppend ? discChars : 0;
+
+    if (cddb_TitleGroup)
+    {
+        // new group: "0;<disc title>//" + "<first>-<last>;<name>//"
+        cddb_DiscFixed += (hasGroups ? 0 : 4) + std::to_string(mdOffset + 1).size()
+                        + ((trackCount > 1) ? (std::to_string(mdOffset + trackCount).size() + 1) : 0) + 1 + 2;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      fit titles into the free title cells; title planning hook of
+//!             the pipeline, called once before the titles are used
+//!
+//! @param      titles  disc title (index 0) and track titles
+//------------------------------------------------------------------------------
+void fitTitles(std::vector<std::string>& titles)
+{
+    std::vector<STitleItem> items;
+
+    if (titles.empty())
+    {
+        return;
+    }
+
+    // group mode: title 0 names the new group;
+    // append mode: disc title on MD stays as it is
+    if (cddb_TitleGroup)
+    {
+        items.push_back({makeGroupTitle(titles.at(0)), cddb_DiscFixed});
+    }
+    else
+    {
+        items.push_back({g_bAppend ? std::string{} : titles.at(0), cddb_DiscFixed});
+    }
+
+    for (size_t i = 1; i < titles.size(); i++)
+    {
+        items.push_back({titles.at(i), 0});
+    }
+
+    size_t used = planTitles(items, cddb_FreeCells);
+    bool   cut  = false;
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (((i > 0) || cddb_TitleGroup || !g_bAppend) && (items.at(i).mText != titles.at(i)))
+        {
+            titles.at(i) = items.at(i).mText;
+            cut = true;
+        }
+    }
+
+    if (cut)
+    {
+        std::cout << "Titles shortened to fit into the MD TOC (" << used << " of "
+                  << cddb_FreeCells << " free title cells)." << std::endl;
+    }
+}
 
 //------------------------------------------------------------------------------
 //! @brief      Starts an external tool.
@@ -200,196 +365,57 @@ int startExternalTool(const std::string cmdLine, HANDLE hdStdOut = INVALID_HANDL
 }
 
 //------------------------------------------------------------------------------
-//! @brief      convert std::string to std::wstring
-//!
-//! @param[in]  s     string to convert
-//!
-//! @return     converted string
-//------------------------------------------------------------------------------
-std::wstring StringToWString(const std::string &s)
-{
-    std::wstring ret(s.begin(), s.end());
-
-    return ret;
-}
-
-//------------------------------------------------------------------------------
-//! @brief      parse CDDB query result line
+//! @brief      parse complete CDDB query result, let user choose in case
+//!             there are multiple matches
 //!
-//! @param[in]  line   The line
-//! @param      descr  The description
+//! @param[in]  input  CDDB query response
 //!
 //! @return     genre+cddbid as string
 //------------------------------------------------------------------------------
-std::string parseResultLine(const std::string& line, std::string& descr)
+std::string parseCddbResultsEx(const std::string& input)
 {
-    std::ostringstream oss;
-    size_t last = 0; 
-    size_t next = 0; 
-    int    no   = 0;
+    std::string   ret;
+    CddbMatches_t choices;
+    int           code = parseCddbResults(input, choices);
 
-    while ((next = line.find_first_of(" \t", last)) != std::string::npos)
+    if (choices.empty())
     {
-        if (no == 0)
-        {
-            oss << line.substr(last, next - last) << "+";
-        }
-        else if (no == 1)
-        {
-            oss << line.substr(last, next - last);
-        }
-
-        last = next + 1;
-
-        if (no == 1)
-        {
-            descr = line.substr(last);
-
-            // remove \r
-            if ((next = descr.rfind("\r")) != descr.npos)
-            {
-                descr.erase(next, 1);
-            }
-            break;
-        }
-        no++;
+        return ret;
     }
-    return oss.str();
-}
 
-//------------------------------------------------------------------------------
-//! @brief      parse complete CDDB query result
-//!
-//! @param[in]  input  CDDB query response
-//!
-//! @return     genre+cddbid as string
-//------------------------------------------------------------------------------
-std::string parseCddbResultsEx(const std::string& input)
-{
-    char* endPos;
-    int   code = std::strtol(input.c_str(), &endPos, 0);
-    std::string ret, descr;
+    ret = choices.back().mQuery;
 
-    if (endPos != input.c_str())
+    if ((code == 210) || (code == 211))
     {
-        struct SDisc 
-        {
-            std::string mQuery;
-            std::string mDescr;
-        };
-        std::vector<SDisc> choices;
-        std::istringstream iss(input);
-        std::string line;
-        size_t      no = 0;
+        CPromptLock prompt;
+        size_t no = 1;
 
-        while(std::getline(iss, line))
+        // main thread gave up while we waited for the console
+        if (g_bAbort)
         {
-            switch(code)
-            {
-            // single exact match
-            case 200:
-                ret = parseResultLine(line.substr(line.find_first_of(" \t") + 1), descr);
-                break;
-            // multiple exact matches
-            case 210:
-            // [fallthrough] multiple inexact matches
-            case 211:
-                if (line[0] == '.')
-                {
-                    break;
-                }
-
-                if (no++ > 0)
-                {
-                    ret = parseResultLine(line, descr);
-                    choices.push_back({ret, descr});
-                }
-                break;
-            // anything we wont handle
-            default:
-                break;
-            }
+            return ret;
         }
 
-        if (choices.size())
+        std::cout << std::endl 
+                  << "=======================" << std::endl;
+        std::cout << "Multiple entries found:" << std::endl;
+        std::cout << "=======================" << std::endl;
+        for(const auto& d : choices)
         {
-            no = 1;
-            std::cout << std::endl 
-                      << "=======================" << std::endl;
-            std::cout << "Multiple entries found:" << std::endl;
-            std::cout << "=======================" << std::endl;
-            for(const auto& d : choices)
-            {
-                std::cout << std::setw(2) << std::right << no << std::left << ") (" << d.mQuery << ") " << d.mDescr << std::endl;
-                no++;
-            }
-            std::cout << "Please choose the entry number to use: ";
-            std::cin >> no;
-
-            if ((no > 0) && (no <= choices.size()))
-            {
-                ret = choices.at(no - 1).mQuery;
-            }
-            std::cout << std::endl;
+            std::cout << std::setw(2) << std::right << no << std::left << ") (" << d.mQuery << ") " << d.mDescr << std::endl;
+            no++;
         }
-    }
-
-    return ret;
-}
+        std::cout << "Please choose the entry number to use: ";
+        std::cin >> no;
 
-//------------------------------------------------------------------------------
-//! @brief      parse CDDB data response
-//!
-//! @param[in]  input  CDDB data response
-//! @param[out] info   disc title vector
-//!
-//! @return     0 -> ok; -1 -> error
-//------------------------------------------------------------------------------
-int parseCddbInfo(const std::string& input, std::vector<std::string>& info)
-{
-    iconv_t icv = iconv_open("US-ASCII//TRANSLIT//IGNORE", "UTF-8");
-    std::string line, tok;
-    size_t pos;
-    std::istringstream iss(input);
-    while(std::getline(iss, line))
-    {
-        if ((line.find("DTITLE") == 0) || (line.find("TTITLE") == 0))
+        if ((no > 0) && (no <= choices.size()))
         {
-            tok.clear();
-
-            if ((pos = line.find("=")) != line.npos)
-            {
-                tok = line.substr(pos + 1);
-            }
-            
-            if ((pos = tok.find("/")) != tok.npos)
-            {
-                tok.replace(pos, 1, "-");
-            }
-            
-            // remove \r
-            if ((pos = tok.rfind("\r")) != tok.npos)
-            {
-                tok.erase(pos, 1);
-            }
-            
-            if (tok.size() > 0)
-            {
-                if (icv != (iconv_t)-1)
-                {
-                    tok = cddb_str_iconv(icv, deUmlaut(tok).c_str());
-                }
-                info.push_back(tok);
-            }
+            ret = choices.at(no - 1).mQuery;
         }
+        std::cout << std::endl;
     }
 
-    if (icv != (iconv_t)-1)
-    {
-        iconv_close(icv);
-    }
-    
-    return info.empty() ? -1 : 0;
+    return ret;
 }
 
 //------------------------------------------------------------------------------
@@ -465,7 +491,7 @@ int externAtrac3Encode(const std::string& file)
     int err = 0;
     std::string atracFile = file + ".aea";
     std::ostringstream cmdLine;
-    cmdLine << TOOLCHAIN_PATH << "atracdenc.exe ";
+    cmdLine << g_sToolchain << "atracdenc.exe ";
 
     NetMDCmds mode = NetMDCmds::UNKNOWN;
 
@@ -557,7 +583,7 @@ int toNetMD(NetMDCmds cmd, const std::string& file = "", const std::string& titl
 {
     int err = 0;
     std::ostringstream cmdLine;
-    cmdLine << TOOLCHAIN_PATH << "netmdcli.exe -v ";
+    cmdLine << g_sToolchain << "netmdcli.exe -v ";
     
     switch(cmd)
     {
@@ -585,6 +611,9 @@ int toNetMD(NetMDCmds cmd, const std::string& file = "", const std::string& titl
     case NetMDCmds::GROUP_TRACK:
         cmdLine << "add_group \"" << title << "\" " << track_first << " " << track_last;
         break;
+    case NetMDCmds::TRACK_TITLE:
+        cmdLine << "rename " << track_first << " \"" << title << "\"";
+        break;
     default:
         err = -1;
         break;
@@ -602,155 +631,20 @@ int toNetMD(NetMDCmds cmd, const std::string& file = "", const std::string& titl
 }
 
 //------------------------------------------------------------------------------
-//! @brief      thread function for netmd transfer
-//!
-//! @return     0
-//------------------------------------------------------------------------------
-int tfunc_mdwrite()
-{
-    STrackDescr currJob;
-    bool        go     = true;
-    NetMDCmds   wrtCmd = NetMDCmds::WRITE_TRACK;
-
-    if (g_sXEncoding == "no")
-    {
-        if (g_sEncoding == "lp2")
-        {
-            wrtCmd = NetMDCmds::WRITE_TRACK_LP2;
-        }
-        else if (g_sEncoding == "lp4")
-        {
-            wrtCmd = NetMDCmds::WRITE_TRACK_LP4;
-        }
-    }
-    
-    do
-    {
-        trf_mtxTracks.lock();
-        if (trf_TracksDescr.size() > 0)
-        {
-            currJob = trf_TracksDescr[0];
-            trf_TracksDescr.erase(trf_TracksDescr.begin());
-        }
-        else
-        {
-            currJob = {"", ""};
-            if (trf_complete)
-            {
-                go = false;
-            }
-        }
-        trf_mtxTracks.unlock();
-        
-        if (!currJob.mFile.empty())
-        {
-            g_iTrfTrack ++;
-            toNetMD(wrtCmd, currJob.mFile, currJob.mName);
-            if (!g_bVerbose) _unlink(currJob.mFile.c_str());
-        }
-        else if (go)
-        {
-            std::unique_lock<std::mutex> lk(trf_m);
-            trf_cv.wait(lk, []{return trf_ready;});
-            trf_ready = false;
-        }
-    }
-    while(go);
-    
-    return 0;
-}
-
-//------------------------------------------------------------------------------
-//! @brief      thread function for external encoder
-//!
-//! @return     0
-//------------------------------------------------------------------------------
-int tfunc_xencode()
-{
-    STrackDescr currJob;
-    bool        go = true;
-
-    do
-    {
-        xenc_mtxTracks.lock();
-        if (xenc_TracksDescr.size() > 0)
-        {
-            currJob = xenc_TracksDescr[0];
-            xenc_TracksDescr.erase(xenc_TracksDescr.begin());
-        }
-        else
-        {
-            currJob = {"", ""};
-            if (xenc_complete)
-            {
-                go = false;
-            }
-        }
-        xenc_mtxTracks.unlock();
-        
-        if (!currJob.mFile.empty())
-        {
-            if (g_sXEncoding != "no")
-            {
-                g_iEncTrack ++;
-                externAtrac3Encode(currJob.mFile);
-            }
-            
-            trf_mtxTracks.lock();
-            trf_TracksDescr.push_back(currJob);
-            trf_mtxTracks.unlock();
-
-            // notify md write thread
-            {
-                std::lock_guard<std::mutex> lk(trf_m);
-                trf_ready = true;
-            }
-            trf_cv.notify_one();
-        }
-        else if (go)
-        {
-            std::unique_lock<std::mutex> lk(xenc_m);
-            xenc_cv.wait(lk, []{return xenc_ready;});
-            xenc_ready = false;
-        }
-    }
-    while(go);
-
-    trf_complete = true;
-    {
-        std::lock_guard<std::mutex> lk(trf_m);
-        trf_ready = true;
-    }
-    trf_cv.notify_one();
-    
-    return 0;
-}
-
-//------------------------------------------------------------------------------
-//! @brief      extract percent value from token
-//!
-//! @param[in]  tok   token to parse
+//! @brief      write disc title to MD
 //!
-//! @return     -1 -> no value found; > -1 -> percent value
+//! @param[in]  isLp  lp mode flag
 //------------------------------------------------------------------------------
-int extractPercent(const std::string& tok)
+void writeDiscTitle(bool isLp)
 {
-    std::size_t posPercent, posNoNumber;
-    int percent = -1;
+    std::string discName;
 
-    if ((posPercent = tok.rfind('%')) != std::string::npos)
+    if ((isLp && g_bDontGroup) || !isLp)
     {
-        if ((posNoNumber = tok.find_last_not_of("0123456789", posPercent - 1)) != std::string::npos)
-        {
-            percent = std::stoi(tok.substr(posNoNumber + 1));
-        }
-        else
-        {
-            percent = std::stoi(tok.substr(0));
-        }
+        discName = g_Pipe.title(0);
     }
 
-    return percent;
+    toNetMD(NetMDCmds::DISC_TITLE, "", discName);
 }
 
 //------------------------------------------------------------------------------
@@ -775,7 +669,7 @@ void makeStatusBar(int rip, int enc, int trf)
     oss.clear();
     oss.str("");
 
-    oss << std::setw(3) << g_iEncTrack << " / " << std::setw(3) 
+    oss << std::setw(3) << g_Pipe.encTrack() << " / " << std::setw(3) 
         << std::left << g_iNoTracks << std::right << std::setw(4) 
         << enc << "%";
     senc = oss.str();
@@ -783,7 +677,7 @@ void makeStatusBar(int rip, int enc, int trf)
     oss.clear();
     oss.str("");
 
-    oss << std::setw(3) << g_iTrfTrack << " / " << std::setw(3) 
+    oss << std::setw(3) << g_Pipe.trfTrack() << " / " << std::setw(3) 
         << std::left << g_iNoTracks << std::right << std::setw(4) 
         << trf << "%";
     strf = oss.str();
@@ -806,64 +700,35 @@ void makeStatusBar(int rip, int enc, int trf)
 //------------------------------------------------------------------------------
 int tfunc_readPipes(std::atomic_bool& run)
 {
-    char buffNetMD[4096];
-    char buffAtracEnc[4096];
-    char buffCDRip[4096];
-    DWORD readNetMD    = 0;
-    DWORD readAtracEnc = 0;
-    DWORD readCDRip    = 0;
-    std::string tok;
-    int percent;
+    CPipeReader netMD(g_hNetMDCli_stdout_rd);
+    CPipeReader atracEnc(g_hAtracEnc_stdout_rd);
+    CPipeReader cdRip(g_hCDRip_stdout_rd);
     
     int rip  = 0, enc  = 0, trf  = 0;
     int rip_ = 0, enc_ = 0, trf_ = 0;
     
     while(run)
     {
-        // nemdcli stdout
-        if (ReadFile(g_hNetMDCli_stdout_rd, buffNetMD, 4095, &readNetMD, 0))
-        {
-            if (readNetMD > 0)
-            {
-                buffNetMD[readNetMD] = '\0';
-                tok                  = buffNetMD;
-
-                if ((percent = extractPercent(tok)) != -1)
-                {
-                    trf = percent;
-                }
-            }
-        }
-
-        // atracdenc stdout
-        if (ReadFile(g_hAtracEnc_stdout_rd, buffAtracEnc, 4095, &readAtracEnc, 0))
-        {
-            if (readAtracEnc > 0)
+        // nemdcli stdout (plain text)
+        netMD.poll([&trf](std::string_view line) {
+            parsePercent(line, trf);
+        });
+
+        // atracdenc stdout (plain text)
+        atracEnc.poll([&enc](std::string_view line) {
+            parsePercent(line, enc);
+        });
+
+        // rip progress records
+        cdRip.poll([&rip](std::string_view line) {
+            SProgress prog;
+            if (parseProgress(line, prog))
             {
-                buffAtracEnc[readAtracEnc] = '\0';
-                tok                        = buffAtracEnc;
-                if ((percent = extractPercent(tok)) != -1)
-                {
-                    enc = percent;
-                }
-            }
-        }
-
-        // piped rip progress (think of stdout)
-        if (ReadFile(g_hCDRip_stdout_rd, buffCDRip, 4095, &readCDRip, 0))
-        {
-            if (readCDRip > 0)
-            {
-                buffCDRip[readCDRip] = '\0';
-                tok                  = buffCDRip;
-                if ((percent = extractPercent(tok)) != -1)
-                {
-                    rip = percent;
-                }
+                rip = prog.percent();
             }
-        }
+        });
 
-        if ((rip != rip_) || (enc != enc_) || (trf != trf_))
+        if (((rip != rip_) || (enc != enc_) || (trf != trf_)) && !g_bPrompt)
         {
             makeStatusBar(rip, enc, trf);
             rip_ = rip;
@@ -1077,14 +942,224 @@ void printMDInfo(const nlohmann::json& j)
 }
 
 //------------------------------------------------------------------------------
-//! @brief      do some sanity check
-//!
-//! @param[in]  discTime  The disc time
-//! @param[in]  j         json object with disc- / device information
+//! @brief      print tracks with read problems (C2 errors, secure mode
+//!             mismatches)
 //!
-//! @return     0 -> ok; -1 -> error
+//! @param[in]  cd          audio CD (tracks already extracted)
+//! @param[in]  trackCount  number of tracks
 //------------------------------------------------------------------------------
-int sanityCheck(uint32_t discTime, const nlohmann::json& j)
+void printRipReport(CAudioCD& cd, uint32_t trackCount)
+{
+    bool header = false;
+
+    auto line = [&header](uint32_t track, const char* what, ULONG retried, ULONG bad)
+    {
+        if (!header)
+        {
+            std::cout << std::endl << "Read problems:" << std::endl;
+            header = true;
+        }
+
+        printf("Track %2u: %s: %lu re-read, %lu unresolved\n", track, what,
+               static_cast<unsigned long>(retried), static_cast<unsigned long>(bad));
+    };
+
+    for (uint32_t i = 0; i < trackCount; i++)
+    {
+        ULONG retried = 0, bad = 0;
+
+        if ((cd.GetRipState(i, &retried, &bad) != RIP_FAILED) && ((retried > 0) || (bad > 0)))
+        {
+            line(i + 1, "sectors after read errors", retried + bad, bad);
+        }
+
+        if (cd.GetC2Errors(i, retried, bad) && (retried > 0))
+        {
+            line(i + 1, "C2 flagged sectors", retried, bad);
+        }
+
+        if (cd.GetSecureErrors(i, retried, bad) && (retried > 0))
+        {
+            line(i + 1, "blocks differing in verify pass", retried, bad);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      normalisation gain for a measured loudness
+//!
+//! @param[in]  lufs  integrated loudness
+//!
+//! @return     gain in dB (0 for silence)
+//------------------------------------------------------------------------------
+double normGain(double lufs)
+{
+    if (lufs <= CLoudness::SILENCE_LUFS)
+    {
+        return 0.0;
+    }
+
+    // don't blow up (nearly) silent tracks
+    return std::min(g_dTargetLufs - lufs, 20.0);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      print loudness and true peak of the ripped tracks and the album
+//!
+//! @param[in]  cd          audio CD (tracks already extracted)
+//! @param[in]  trackCount  number of tracks
+//------------------------------------------------------------------------------
+void printLoudness(CAudioCD& cd, uint32_t trackCount)
+{
+    double lufs, peak;
+
+    if (!cd.AlbumLoudness(lufs, peak))
+    {
+        return;
+    }
+
+    std::cout << std::endl << "Loudness (target " << g_dTargetLufs << " LUFS):" << std::endl;
+
+    for (uint32_t i = 0; i < trackCount; i++)
+    {
+        if (cd.Loudness(i, lufs, peak))
+        {
+            printf("Track %2u: %6.1f LUFS, %5.1f dBTP, track gain %+5.1f dB\n", i + 1, lufs, peak, normGain(lufs));
+        }
+    }
+
+    cd.AlbumLoudness(lufs, peak);
+    printf("Album   : %6.1f LUFS, %5.1f dBTP, album gain %+5.1f dB\n", lufs, peak, normGain(lufs));
+}
+
+//------------------------------------------------------------------------------
+//! @brief      compare AccurateRip checksums of the ripped tracks with the
+//!             local AccurateRip database
+//!
+//! @param[in]  cd          audio CD (tracks already extracted)
+//! @param[in]  trackCount  number of tracks
+//------------------------------------------------------------------------------
+void verifyAccurateRip(CAudioCD& cd, uint32_t trackCount)
+{
+    std::string dir  = g_sArDb;
+    std::string file = cd.accurateRipFile();
+    std::string data;
+
+    if (!dir.empty() && (dir.back() != '/') && (dir.back() != '\\'))
+    {
+        dir += '/';
+    }
+
+    // database layout (a/b/c/dBAR-...) or all files in one folder
+    for (const auto& path : {dir + file, dir + file.substr(file.rfind('/') + 1)})
+    {
+        std::ifstream f(path, std::ios::binary);
+        if (f)
+        {
+            std::ostringstream oss;
+            oss << f.rdbuf();
+            data = oss.str();
+            break;
+        }
+    }
+
+    std::vector<std::vector<SArTrack>> entries;
+
+    std::cout << std::endl << "AccurateRip (" << file.substr(file.rfind('/') + 1) << "):" << std::endl;
+
+    if (data.empty() || !CAccurateRip::parseDb(data, trackCount, entries))
+    {
+        std::cout << "Disc not found in AccurateRip database." << std::endl;
+        entries.assign(trackCount, {});
+    }
+
+    for (uint32_t i = 0; i < trackCount; i++)
+    {
+        UINT v1 = 0, v2 = 0;
+        char crcs[32];
+
+        if (!cd.accurateRipCrc(i, v1, v2))
+        {
+            printf("Track %2u: not ripped\n", i + 1);
+            continue;
+        }
+
+        snprintf(crcs, sizeof(crcs), "[%08x / %08x]", v1, v2);
+        SArResult res = CAccurateRip::match(entries.at(i), v1, v2);
+
+        if (res.mConfidence > 0)
+        {
+            printf("Track %2u: %s accurately ripped (%s, confidence %d)\n", i + 1, crcs, res.mV2 ? "v2" : "v1", res.mConfidence);
+        }
+        else if (res.mFound && g_sReadOffset.empty())
+        {
+            printf("Track %2u: %s unverifiable (read offset unknown, see --read-offset)\n", i + 1, crcs);
+        }
+        else if (res.mFound)
+        {
+            printf("Track %2u: %s NOT accurate (no matching checksum)\n", i + 1, crcs);
+        }
+        else
+        {
+            printf("Track %2u: %s not in database\n", i + 1, crcs);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      Prints the pipeline statistics.
+//!
+//! @param[in]  startupMs  time needed until first track rip starts
+//------------------------------------------------------------------------------
+void printStats(uint64_t startupMs)
+{
+    uint64_t wallMs = msSince(g_tpStart);
+
+    // busy time of a stage with parallel workers is the sum over all
+    // workers -> relate it to the wall time of all workers
+    auto stageLine = [wallMs](const char* stage, uint64_t busyMs, int workers = 1)
+    {
+        std::cout << std::left << std::setw(22) << stage << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (busyMs / 1000.0) << "s";
+
+        if (wallMs > 0)
+        {
+            std::cout << " (" << std::setw(3) << ((busyMs * 100) / (wallMs * std::max(workers, 1))) << "% busy";
+            if (workers > 1)
+            {
+                std::cout << " on " << workers << " threads";
+            }
+            std::cout << ")";
+        }
+        std::cout << std::endl;
+    };
+
+    std::cout << std::endl
+              << "Statistics:" << std::endl
+              << "===========" << std::endl;
+
+    stageLine("Total wall time:"      , wallMs);
+    stageLine("Startup:"              , startupMs);
+    stageLine("Time to 1st transfer:" , g_Pipe.mFirstTrfMs);
+    stageLine("CD-Rip:"               , g_u64RipBusyMs);
+
+    if (g_sXEncoding != "no")
+    {
+        stageLine("X-Encode:"         , g_Pipe.mEncBusyMs, g_iEncThreads);
+    }
+
+    stageLine("MD Transfer:"          , g_Pipe.mTrfBusyMs);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      do some sanity check
+//!
+//! @param[in]  discTime  The disc time
+//! @param[in]  j         json object with disc- / device information
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+int sanityCheck(uint32_t discTime, const nlohmann::json& j)
 {
     int ret = 0;
     int hour, minute, second;
@@ -1109,6 +1184,7 @@ int sanityCheck(uint32_t discTime, const nlohmann::json& j)
 
             if ((j["t_total"].get<int>() != j["t_free"].get<int>()) && !g_bAppend)
             {
+                CPromptLock prompt;
                 uint32_t usedTime = j["t_used"].get<int>();
                 hour     = usedTime / 3600;
                 minute   = ((usedTime % 3600) / 60);
@@ -1206,89 +1282,120 @@ int sanityCheck(uint32_t discTime, const nlohmann::json& j)
 }
 
 //------------------------------------------------------------------------------
-//! @brief      Makes a group title.
-//!
-//! @param[in]  gt    disc title
+//! @brief      MD title charset as given on command line
 //!
-//! @return     group title
+//! @return     charset
 //------------------------------------------------------------------------------
-std::string makeGroupTitle(const std::string& gt)
+MdCharset mdCharset()
 {
-    std::size_t pos;
-    std::string tok = gt;
-
-    while ((pos = tok.find_first_of(" \t")) != std::string::npos)
+    if (g_sMdCharset == "ascii")
     {
-        if (pos == 0)
-        {
-            tok = tok.substr(1);
-        }
-        else
-        {
-            break;
-        }
-    }
-
-    // remove double spaces
-    while ((pos = tok.find("  ")) != std::string::npos)
-    {
-        tok = tok.replace(pos, 2, " ");
-    }
-
-    // remove some well known token starts
-    if ((pos = tok.find_first_of("([{/<>")) != std::string::npos)
-    {
-        if (pos > 5)
-        {
-            tok = tok.substr(0, pos);
-        }
+        return MdCharset::ASCII;
     }
-
-    if ((pos = tok.find_last_not_of(" \t")) != std::string::npos)
+    else if (g_sMdCharset == "kana")
     {
-        tok = tok.substr(0, pos + 1);
+        return MdCharset::KANA;
     }
-
-    return tok;
+    return MdCharset::AUTO;
 }
 
 //------------------------------------------------------------------------------
 //! @brief      do CDDB request
 //!
-//! @param[in]  cd      Audio CD class
-//! @param[out] tracks  ref. to tracks vector
+//! @param[in]  queryPart   CDDB query part of disc (see CAudioCD::cddbQueryPart())
+//! @param[in]  cddbId      CDDB disc id
+//! @param[in]  trackCount  number of tracks on CD
+//! @param[out] tracks      ref. to tracks vector
 //!
 //! @return    0 -> ok; else -> error 
 //------------------------------------------------------------------------------
-int cddbRequest(CAudioCD& cd, std::vector<std::string>& tracks)
+int cddbRequest(const std::string& queryPart, uint32_t cddbId, uint32_t trackCount, std::vector<std::string>& tracks)
 {
     std::ostringstream oss;
-    oss << "/~cddb/cddb.cgi?cmd=cddb+query+" << cd.cddbQueryPart() << "&hello=me@you.org+localhost+MyRipper+0.0.1&proto=6";
-    printf("\nCDDB ID: 0x%08x\n\n", cd.cddbId());
-    VERBOSE(printf("CDDB Request: http://gnudb.gnudb.org%s\n",oss.str().c_str()));
-    
-    WinHttpWrapper::HttpRequest req(L"gnudb.gnudb.org", 443, true);
-    WinHttpWrapper::HttpResponse resp;
-    
-    if (req.Get(StringToWString(oss.str()), L"Content-Type: text/plain; charset=utf-8", resp))
+    std::string xmcd, match;
+    CCddbCache  cache(g_sCddbCache, g_sFreedbDump);
+    printf("\nCDDB ID: 0x%08x\n\n", cddbId);
+
+    // local cache first
+    auto start = StatClock_t::now();
+    if (cache.lookup(queryPart, cddbId, xmcd, match))
     {
-        oss.clear();
-        oss.str("");
-        oss << "/~cddb/cddb.cgi?cmd=cddb+read+" << parseCddbResultsEx(resp.text) << "&hello=me@you.org+localhost+MyRipper+0.0.1&proto=6";
-        VERBOSE(printf("CDDB Data: http://gnudb.gnudb.org%s\n",oss.str().c_str()));
-    
-        resp.Reset();
-    
-        if (req.Get(StringToWString(oss.str()), L"Content-Type: text/plain; charset=utf-8", resp))
+        VERBOSE(printf("CDDB cache hit (%s): %lld us\n", match.c_str(), static_cast<long long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(StatClock_t::now() - start).count())));
+        parseCddbInfo(xmcd, tracks, mdCharset());
+    }
+
+    if (tracks.empty())
+    {
+        CCddbMirrors mirrors(g_sCddbServer, g_iCddbHedge, g_iCddbTimeout);
+        std::string  winner;
+        SHttpResult  resp;
+
+        for (const auto& r : mirrors.rejected())
         {
-            parseCddbInfo(resp.text, tracks);
+            std::cerr << "Unsupported CDDB server URL: " << r << std::endl;
+        }
+
+        if (mirrors.size() > 0)
+        {
+            oss << "cddb+query+" << queryPart << "&hello=me@you.org+localhost+MyRipper+0.0.1&proto=6";
+            VERBOSE(printf("CDDB Request: ?cmd=%s\n", oss.str().c_str()));
+
+            if (mirrors.request(oss.str(), resp, winner))
+            {
+                oss.clear();
+                oss.str("");
+                VERBOSE(printf("CDDB Query: %s, %u ms (%s connection)\n", winner.c_str(), resp.mLatency, resp.mReused ? "reused" : "new"));
+                match = parseCddbResultsEx(resp.mBody);
+                oss << "cddb+read+" << match << "&hello=me@you.org+localhost+MyRipper+0.0.1&proto=6";
+                VERBOSE(printf("CDDB Data: ?cmd=%s\n", oss.str().c_str()));
+
+                // winner of the query is asked first, others are hedged
+                if (mirrors.request(oss.str(), resp, winner))
+                {
+                    VERBOSE(printf("CDDB Read: %s, %u ms (%s connection)\n", winner.c_str(), resp.mLatency, resp.mReused ? "reused" : "new"));
+                    if (parseCddbInfo(resp.mBody, tracks, mdCharset()) == 0)
+                    {
+                        cache.store(queryPart, cddbId, match, resp.mBody);
+                    }
+                }
+            }
+
+            if (tracks.empty() && !resp.mError.empty())
+            {
+                std::cerr << "CDDB request failed: " << resp.mError << std::endl;
+            }
         }
     }
 
     if (tracks.empty())
     {
+        CPromptLock prompt;
         std::string choice;
         bool choosen = false;
+
+        if (g_bAbort)
+        {
+            return -1;
+        }
+
+        auto unnamed = [&]()
+        {
+            for (uint32_t i = 0; i <= trackCount; i++)
+            {
+                tracks.push_back(std::string {});
+            }
+        };
+
+        // MD is already erased -> nothing to decline anymore
+        if (g_Pipe.transferStarted())
+        {
+            std::cout << "No CDDB entry found. The transfer has already started, "
+                      << "so your tracks on MD will be unnamed." << std::endl;
+            unnamed();
+            return 0;
+        }
+
         std::cout << "No CDDB entry found so your tracks on MD will be unnamed. "
                   << "Do you want to continue (y/n)?" << std::endl;
 
@@ -1299,19 +1406,21 @@ int cddbRequest(CAudioCD& cd, std::vector<std::string>& tracks)
             {
             case 'y':
             case 'Y':
-                {
-                    choosen = true;
-                    int t = static_cast<int>(cd.GetTrackCount());
-
-                    for (int i = 0; i <= t; i++)
-                    {
-                        tracks.push_back(std::string {});
-                    }
-                }
+                choosen = true;
+                unnamed();
                 break;
             case 'n':
             case 'N':
                 choosen = true;
+                if (g_Pipe.abortBeforeTransfer())
+                {
+                    std::cerr << "Aborted by user!" << std::endl;
+                }
+                else
+                {
+                    std::cout << "The transfer has already started, so your tracks on MD will be unnamed." << std::endl;
+                    unnamed();
+                }
                 break;
             default:
                 std::cout << "Try again: Do you want to continue (y/n)?" 
@@ -1326,6 +1435,46 @@ int cddbRequest(CAudioCD& cd, std::vector<std::string>& tracks)
     return tracks.empty() ? -1 : 0;
 }
 
+//------------------------------------------------------------------------------
+//! @brief      thread function for CDDB lookup; runs while the CD is ripped
+//!
+//! @param[in]  queryPart   CDDB query part of disc
+//! @param[in]  cddbId      CDDB disc id
+//! @param[in]  trackCount  number of tracks in TOC (data tracks included)
+//! @param[in]  tocNumbers  TOC track number of each audio track
+//!
+//! @return     0 -> ok; else -> error
+//------------------------------------------------------------------------------
+int tfunc_cddb(const std::string queryPart, uint32_t cddbId, uint32_t trackCount, const std::vector<UINT> tocNumbers)
+{
+    std::vector<std::string> titles;
+    int ret = cddbRequest(queryPart, cddbId, trackCount, titles);
+
+    if (ret != 0)
+    {
+        if (!g_bAbort)
+        {
+            std::cerr << "Aborted by user!" << std::endl;
+            g_bAbort = true;
+        }
+    }
+    else
+    {
+        // CDDB titles data tracks as well -> pick the audio tracks
+        std::vector<std::string> audio = {titles.at(0)};
+
+        for (UINT no : tocNumbers)
+        {
+            audio.push_back((no < titles.size()) ? titles.at(no) : std::string{});
+        }
+
+        titles = audio;
+    }
+
+    g_Pipe.setTitles(titles);
+    return ret;
+}
+
 //------------------------------------------------------------------------------
 //! @brief      program entry point
 //!
@@ -1336,6 +1485,8 @@ int cddbRequest(CAudioCD& cd, std::vector<std::string>& tracks)
 //------------------------------------------------------------------------------
 int main(int argc, char** argv)
 {
+    g_tpStart = StatClock_t::now();
+    uint64_t startupMs = 0;
     std::ostringstream oss;
     CONSOLE_SCREEN_BUFFER_INFO csbi;
     size_t columns = 80;
@@ -1352,10 +1503,54 @@ int main(int argc, char** argv)
     parser.Bool(g_bAppend      , 'a', "append"       , "Don't erase MD before writing, but append tracks instead. "
                                                        "MDs discs title will not be changed.");
     parser.Bool(g_bNoCDDBLookup, 'n', "no-cddb"      , "Don't use CDDB. Your tracks on MD will be untitled.");
+    parser.Bool(g_bNoCdText    , '\0', "no-cdtext"   , "Ignore CD-Text on disc and use CDDB instead.");
+    parser.Var (g_sMdCharset   , '\0', "md-charset"  , std::string{"auto"}, "Charset of MD titles: 'ascii', 'kana' (ASCII and "
+                                                                          "half-width katakana; kana and kanji with reading are "
+                                                                          "converted) or 'auto' (kana for japanese discs).");
     parser.Bool(g_bDontGroup   , 'g', "no-group"     , "Don't create group for new tracks on MD.");
     parser.Var (g_cDrive       , 'd', "drive-letter" , '-'              , "Drive letter of CD drive to use (w/o colon). "
                                                                           "If not given first CD drive found will be used.");
-
+    parser.Var (g_sToolchain   , 't', "toolchain"    , std::string{TOOLCHAIN_PATH}, "Path to the external tools atracdenc.exe "
+                                                                          "and netmdcli.exe (with trailing slash).");
+    parser.Bool(g_bStats       , '\0', "stats"       , "Print total wall time and busy time of each pipeline stage at exit.");
+    parser.Bool(g_bSecure      , '\0', "secure"      , "Secure rip: read every track a second time, compare block hashes "
+                                                                          "and re-read blocks which differ.");
+    parser.Var (g_iMaxSpeed    , '\0', "max-speed"   , 0               , "Max. CD read speed (e.g. 24 for 24x). 0 -> drive max. "
+                                                                          "Speed is lowered on read errors and raised again after clean zones.");
+    parser.Bool(g_bBenchDrive  , '\0', "bench-drive" , "Measure read speed (zones, chunk sizes), seek latency and spin-up "
+                                                                          "time of the CD drive and exit. Nothing is written to MD.");
+    parser.Bool(g_bTrimSilence , '\0', "trim-silence", "Cut silence at start and end of tracks while ripping.");
+    parser.Var (g_iSilThreshold, '\0', "silence-threshold", 0          , "Max. absolute sample value (16 bit) counted as silence. "
+                                                                          "0 -> digital silence only.");
+    parser.Var (g_iSilMinMs    , '\0', "silence-min" , 1000            , "Min. length of silence in ms to be cut.");
+    parser.Bool(g_bNoDeEmph    , '\0', "no-deemphasis", "Don't remove pre-emphasis from tracks flagged with it in the TOC.");
+    parser.Var (g_sNormalize   , '\0', "normalize"   , std::string{"no"}, "Loudness normalisation (EBU R128) before encoding / "
+                                                                          "transfer: 'no', 'track' or 'album'. Gain is applied in an "
+                                                                          "extra pass over each ripped track. Album mode starts "
+                                                                          "encoding / transfer when the whole CD is ripped.");
+    parser.Var (g_dTargetLufs  , '\0', "target-lufs" , -18.0           , "Target loudness in LUFS for --normalize.");
+    parser.Var (g_dTruePeak    , '\0', "true-peak"   , -1.0            , "Max. true peak in dBTP after normalisation. A limiter "
+                                                                          "catches peaks above.");
+    parser.Var (g_iEncThreads  , '\0', "enc-threads" , 0               , "Number of parallel external encoder jobs. "
+                                                                          "0 -> one job per CPU core.");
+    parser.Var (g_sCddbCache   , '\0', "cddb-cache"  , std::string{"cddb_cache"}, "Folder of the local CDDB cache. "
+                                                                          "Discs found there don't need a CDDB server. "
+                                                                          "Empty string disables the cache.");
+    parser.Var (g_sFreedbDump  , '\0', "freedb-dump" , std::string{""}, "Folder of an unpacked freedb dump "
+                                                                          "(<genre>/<discid> files) to search on cache miss.");
+    parser.Var (g_sCddbServer  , '\0', "cddb-server" , std::string{"https://gnudb.gnudb.org/~cddb/cddb.cgi"},
+                                                                          "URLs of CDDB servers (CDDB protocol over http or https), "
+                                                                          "separated by comma. Further servers are asked if the "
+                                                                          "first one doesn't answer in time.");
+    parser.Var (g_iCddbHedge   , '\0', "cddb-hedge"  , 500             , "Delay in ms before the next CDDB server is asked "
+                                                                          "while the previous one didn't answer.");
+    parser.Var (g_iCddbTimeout , '\0', "cddb-timeout", 5000            , "Deadline in ms for one CDDB request over all servers.");
+
+    parser.Var (g_sArDb        , '\0', "accuraterip-db", std::string{""}, "Folder of local AccurateRip database files "
+                                                                          "(dBAR-*.bin). If given, ripped tracks are verified.");
+    parser.Var (g_sReadOffset  , '\0', "read-offset" , std::string{""}, "Read offset correction of the CD drive in samples "
+                                                                          "(see AccurateRip drive list, e.g. 6). Needed for "
+                                                                          "AccurateRip verification.");
     parser.Var (g_sEncoding    , 'e', "encode"       , std::string{"sp"}, "On-the-fly encoding mode on NetMD device while transfer. "
                                                                           "Default is 'sp'. Note: MDLP modi (lp2, lp4) are supported "
                                                                           "only on SHARP IM-DR4x0, Sony MDS-JB980, and Sony MDS-JE780.");
@@ -1416,6 +1611,34 @@ int main(int argc, char** argv)
     std::transform(g_sXEncoding.begin(), g_sXEncoding.end(), g_sXEncoding.begin(),
             [](unsigned char c){ return std::tolower(c); });
 
+    std::transform(g_sMdCharset.begin(), g_sMdCharset.end(), g_sMdCharset.begin(),
+            [](unsigned char c){ return std::tolower(c); });
+
+    std::transform(g_sNormalize.begin(), g_sNormalize.end(), g_sNormalize.begin(),
+            [](unsigned char c){ return std::tolower(c); });
+
+    long readOffset = 0;
+
+    if (!g_sReadOffset.empty())
+    {
+        char* end = nullptr;
+        readOffset = strtol(g_sReadOffset.c_str(), &end, 10);
+
+        if ((*end != '\0') || (readOffset < -5000) || (readOffset > 5000))
+        {
+            std::cerr << "Invalid read offset '" << g_sReadOffset << "'!" << std::endl;
+            parser.PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((g_sNormalize != "no") && (g_sNormalize != "track") && (g_sNormalize != "album"))
+    {
+        std::cerr << "Unknown normalisation mode '" << g_sNormalize << "'!" << std::endl;
+        parser.PrintHelp(argv[0]);
+        return 1;
+    }
+
     if ((g_sXEncoding == "lp2")
         || (g_sXEncoding == "lp4")
         || (g_sEncoding == "lp2")
@@ -1424,6 +1647,18 @@ int main(int argc, char** argv)
         isLp = true;
     }
 
+    if (g_bBenchDrive)
+    {
+        CAudioCD AudioCD;
+        AudioCD.SetMaxSpeed((g_iMaxSpeed > 0) ? g_iMaxSpeed : 0);
+        if ( ! AudioCD.Open( g_cDrive ) )
+        {
+            printf( "Cannot open cd-drive!\n" );
+            return -1;
+        }
+        return benchDrive(AudioCD);
+    }
+
     if (openPipes() != 0)
     {
         closePipes();
@@ -1431,6 +1666,12 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    if (!g_sCddbCache.empty())
+    {
+        // fails if it already exists - we don't care
+        CreateDirectoryA(g_sCddbCache.c_str(), NULL);
+    }
+
     // ostream device for Audio CD cout piping ...
     CPipeStream ps(g_hCDRip_stdout_wr);
 
@@ -1440,23 +1681,52 @@ int main(int argc, char** argv)
     // Enable buffering to prevent VS from chopping up UTF-8 byte sequences
     setvbuf(stdout, nullptr, _IOFBF, 1000);
 
-    nlohmann::json j;
-    getMDInfo(j);
+    // probe NetMD device while the CD drive spins up
+    nlohmann::json j, jTitles;
+    std::thread MDProbe([&j, &jTitles]()
+    {
+        try
+        {
+            getMDInfo(j);
+
+            // titles on MD count against the TOC title space
+            if (g_bAppend)
+            {
+                getMDInfo(jTitles, false);
+            }
+        }
+        catch(...)
+        {
+            j.clear();
+        }
+    });
     
     TCHAR tmpPath[MAX_PATH];
     GetTempPathA(MAX_PATH, tmpPath);
     
-    std::vector<std::string> tracks;
-    
     CAudioCD AudioCD('\0', ps);
+    AudioCD.SetSecure(g_bSecure);
+    AudioCD.SetMaxSpeed((g_iMaxSpeed > 0) ? g_iMaxSpeed : 0);
+    AudioCD.SetSilence(g_iSilThreshold, (g_iSilMinMs > 0) ? g_iSilMinMs : 0, g_bTrimSilence);
+    AudioCD.SetLoudness((g_sNormalize != "no") || g_bVerbose);
+    AudioCD.SetDeEmphasis(!g_bNoDeEmph);
+    AudioCD.SetReadOffset(readOffset);
     if ( ! AudioCD.Open( g_cDrive ) )
     {
+        MDProbe.join();
         printf( "Cannot open cd-drive!\n" );
         return 0;
     }
 
     uint32_t TrackCount = AudioCD.GetTrackCount();
     std::cout << "Track-Count: " << TrackCount << std::endl;
+
+    if (AudioCD.GetTocTrackCount() > TrackCount)
+    {
+        std::cout << "Data tracks skipped: " << AudioCD.GetTocTrackCount() - TrackCount << std::endl;
+    }
+    VERBOSE(std::cout << "CD drive: " << AudioCD.DriveModel() << ", max. speed: " << AudioCD.DriveMaxSpeed()
+                      << "x, C2 error pointers: " << (AudioCD.HasC2() ? "yes" : "no") << std::endl);
     g_iNoTracks = TrackCount;
 
     uint32_t u32DiscTime = 0;
@@ -1465,33 +1735,61 @@ int main(int argc, char** argv)
     {
         uint32_t Time = AudioCD.GetTrackTime( i );
         u32DiscTime += Time;
-        printf( "Track %u: %u:%.2u;  %u bytes\n", i+1, Time/60, Time%60, static_cast<uint32_t>(AudioCD.GetTrackSize(i)) );
+        printf( "Track %u: %u:%.2u;  %u bytes%s\n", i+1, Time/60, Time%60, static_cast<uint32_t>(AudioCD.GetTrackSize(i)),
+                AudioCD.HasPreEmphasis(i) ? "  (pre-emphasis)" : "" );
     }
 
+    // CDDB lookup runs in background, titles are bound to the
+    // tracks right before they are transferred
+    std::thread CddbLookup;
+
+    if (g_bNoCDDBLookup)
+    {
+        // no CDDB lookup -> simply create empty track- and disc names
+        // entry 0 is disc title
+        g_Pipe.setTitles(std::vector<std::string>(TrackCount + 1));
+    }
+    else if (!g_bNoCdText && !AudioCD.cdTextTitles().empty())
+    {
+        // titles from disc -> no CDDB round trip needed
+        std::vector<std::string> titles = AudioCD.cdTextTitles();
+        toMdTitles(titles, mdCharset());
+        std::cout << "CD-Text: " << titles.at(0) << std::endl;
+        g_Pipe.setTitles(titles);
+    }
+    else
+    {
+        CddbLookup = std::thread(tfunc_cddb, AudioCD.cddbQueryPart(), AudioCD.cddbId(), AudioCD.GetTocTrackCount(),
+                                 AudioCD.GetTocNumbers());
+    }
+
+    MDProbe.join();
+
     // do some more sanity checks
     if (sanityCheck(u32DiscTime, j) != 0)
     {
+        // lookup thread skips its prompts once abort is set; it uses
+        //   globals, so it must be done before they are destroyed
+        g_bAbort = true;
+        if (CddbLookup.joinable()) CddbLookup.join();
         closePipes();
         return -2;
     }
-    
-    if (g_bNoCDDBLookup)
+
+    // append mode might have been chosen in the sanity check dialog
+    if (g_bAppend && jTitles.is_null())
     {
-        // no CDDB lookup -> simply create empty track- and disc names
-        // entry 0 is disc title
-        for ( uint32_t i = 0; i <= TrackCount; i++ )
+        try
         {
-            tracks.push_back(std::string {});
+            getMDInfo(jTitles, false);
         }
-    }
-    else
-    {
-        if (cddbRequest(AudioCD, tracks) != 0)
+        catch(...)
         {
-            closePipes();
-            return -2;
+            jTitles.clear();
         }
     }
+
+    setTitleSpace(isLp, g_bAppend ? j.value("trk_count", 0) : 0, TrackCount, jTitles);
     
     // file name buffer
     char fname[MAX_PATH];
@@ -1502,69 +1800,160 @@ int main(int argc, char** argv)
     // stdout parse thread
     std::thread PipeWatch(tfunc_readPipes, std::ref(bPWRun));
     
-    // external encoder thread
-    std::thread XEnc(tfunc_xencode);
-    
-    // netmd transfer thread
-    std::thread NetMd(tfunc_mdwrite);
-
-    if (!g_bAppend)
+    // external encoder threads (no need for more than one if we don't encode)
+    if ((g_iEncThreads <= 0) || (g_sXEncoding == "no"))
     {
-        std::string discName;
+        g_iEncThreads = (g_sXEncoding == "no") ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // NetMD write command for tracks not encoded externally
+    NetMDCmds wrtCmd = NetMDCmds::WRITE_TRACK;
 
-        if ((isLp && g_bDontGroup) || !isLp)
+    if (g_sXEncoding == "no")
+    {
+        if (g_sEncoding == "lp2")
         {
-            discName = tracks.at(0);
+            wrtCmd = NetMDCmds::WRITE_TRACK_LP2;
         }
-        toNetMD(NetMDCmds::ERASE_DISC);
+        else if (g_sEncoding == "lp4")
+        {
+            wrtCmd = NetMDCmds::WRITE_TRACK_LP4;
+        }
+    }
 
-        toNetMD(NetMDCmds::DISC_TITLE, "", discName);
-        WriteFile(g_hNetMDCli_stdout_wr, " 0% \n", 5, nullptr, nullptr);
+    CTrackPipeline::SConfig pipeCfg;
+    pipeCfg.mEncThreads = g_iEncThreads;
+    pipeCfg.mAppend     = g_bAppend;
+    pipeCfg.mMdOffset   = g_bAppend ? j.value("trk_count", 0) : 0;
+    pipeCfg.mTruePeak   = g_dTruePeak;
+    pipeCfg.mKeepFiles  = g_bVerbose;
+    pipeCfg.mVerbose    = g_bVerbose;
+    pipeCfg.mStart      = g_tpStart;
+
+    CTrackPipeline::STools pipeTools;
+    if (g_sXEncoding != "no")
+    {
+        pipeTools.mEncode = [](const std::string& file){ return externAtrac3Encode(file) == 0; };
     }
+    pipeTools.mWriteTrack = [wrtCmd](const std::string& file, const std::string& title)
+    {
+        return toNetMD(wrtCmd, file, title) == 0;
+    };
+    pipeTools.mEraseDisc = []()
+    {
+        toNetMD(NetMDCmds::ERASE_DISC);
+        WriteFile(g_hNetMDCli_stdout_wr, " 0% \n", 5, nullptr, nullptr);
+    };
+    pipeTools.mDiscTitle  = [isLp](){ writeDiscTitle(isLp); };
+    pipeTools.mTrackTitle = [](int mdTrack, const std::string& title)
+    {
+        toNetMD(NetMDCmds::TRACK_TITLE, "", title, mdTrack);
+    };
+    pipeTools.mPlanTitles = fitTitles;
+
+    // external encoder threads and netmd transfer thread
+    g_Pipe.start(pipeCfg, pipeTools);
     
-    for (UINT i = 0; i < TrackCount; i++)
+    startupMs = msSince(g_tpStart);
+
+    // silence cut from all tracks (frames of 4 bytes)
+    uint64_t trimmedFrames = 0;
+
+    // album gain needs all tracks -> jobs wait here until the CD is ripped
+    TrackVector_t albumJobs;
+
+    for (UINT i = 0; (i < TrackCount) && !g_bAbort; i++)
     {
         g_iRipTrack = i + 1;
         GetTempFileNameA(tmpPath, "c2n", 0, fname);
 
         VERBOSE(std::cout << "Extracting Audio track " << i+1 << " to " << fname << std::endl);
 
-        AudioCD.ExtractTrack(i, fname);
-        
-        xenc_mtxTracks.lock();
-        xenc_TracksDescr.push_back({tracks.at(i+1), fname});
-        xenc_mtxTracks.unlock();
+        BOOL ripped;
+
+        {
+            CStageTimer tm(g_u64RipBusyMs);
+            ripped = AudioCD.ExtractTrack(i, fname);
+
+            // verify pass runs while older tracks are encoded / transferred
+            if (ripped && g_bSecure)
+            {
+                ripped = AudioCD.VerifyTrack(i, fname);
+            }
+
+            if (ripped && g_bTrimSilence)
+            {
+                trimmedFrames += AudioCD.TrimSilence(i, fname);
+            }
+        }
+
+        RIPSTATE ripState = AudioCD.GetRipState(i);
+
+        if (!ripped || (ripState == RIP_FAILED))
+        {
+            // the tracks on MD would be out of order -> stop here
+            std::cerr << std::endl << "Ripping of track " << i + 1 << " failed, stopping!" << std::endl;
+            if (!g_bVerbose) _unlink(fname);
+            g_bAbort = true;
+            break;
+        }
         
-        // notify external encoder thread
+        STrackDescr job = {"", fname, static_cast<int>(i), static_cast<uint32_t>(AudioCD.GetTrackSize(i)), ripState == RIP_PARTIAL};
+        double      lufs;
+
+        if ((g_sNormalize != "no") && AudioCD.Loudness(i, lufs, job.mPeak))
+        {
+            job.mGain = normGain(lufs);
+        }
+
+        if (g_sNormalize == "album")
+        {
+            albumJobs.push_back(job);
+        }
+        else
         {
-            std::lock_guard<std::mutex> lk(xenc_m);
-            xenc_ready = true;
+            g_Pipe.queue(job);
+        }
+    }
+
+    if (!albumJobs.empty())
+    {
+        double lufs, peak;
+        AudioCD.AlbumLoudness(lufs, peak);
+
+        for (auto& job : albumJobs)
+        {
+            job.mGain = normGain(lufs);
+
+            if (g_bAbort)
+            {
+                if (!g_bVerbose) _unlink(job.mFile.c_str());
+            }
+            else
+            {
+                g_Pipe.queue(job);
+            }
         }
-        xenc_cv.notify_one();
     }
     
     AudioCD.UnlockCD();
     AudioCD.EjectCD();
     
-    xenc_complete = true;
+    // wait for encoder threads and md writing
+    g_Pipe.finish();
+
+    // wait for CDDB lookup
+    if (CddbLookup.joinable())
     {
-        std::lock_guard<std::mutex> lk(xenc_m);
-        xenc_ready = true;
+        CddbLookup.join();
     }
-    xenc_cv.notify_one();
 
-    // wait for encoder thread
-    XEnc.join();
-    
-    // wait for md writing ends
-    NetMd.join();
-
-    if (isLp && !g_bDontGroup && !tracks.at(0).empty())
+    if (isLp && !g_bDontGroup && !g_bAbort && !g_Pipe.title(0).empty())
     {
         // put new encoded tracks into group
-        int firstTrack = g_bAppend ? (j["trk_count"].get<int>() + 1)  : 1;
-        int lastTrack  = g_bAppend ? (j["trk_count"].get<int>() + TrackCount) : TrackCount;
-        toNetMD(NetMDCmds::GROUP_TRACK, "", makeGroupTitle(tracks.at(0)), firstTrack, lastTrack);
+        int firstTrack = g_bAppend ? (j.value("trk_count", 0) + 1)  : 1;
+        int lastTrack  = g_bAppend ? (j.value("trk_count", 0) + TrackCount) : TrackCount;
+        toNetMD(NetMDCmds::GROUP_TRACK, "", makeGroupTitle(g_Pipe.title(0)), firstTrack, lastTrack);
     }
 
     // stop thread loop
@@ -1577,7 +1966,30 @@ int main(int argc, char** argv)
     getMDInfo(j, false);
     printMDInfo(j);
 
+    printRipReport(AudioCD, TrackCount);
+
+    if ((g_sNormalize != "no") || g_bVerbose)
+    {
+        printLoudness(AudioCD, TrackCount);
+    }
+
+    if (g_bTrimSilence)
+    {
+        printf("\nSilence trimmed: %.1f s (%llu bytes)\n", trimmedFrames / 44100.0,
+               static_cast<unsigned long long>(trimmedFrames * 4));
+    }
+
+    if (!g_sArDb.empty())
+    {
+        verifyAccurateRip(AudioCD, TrackCount);
+    }
+
+    if (g_bStats)
+    {
+        printStats(startupMs);
+    }
+
     closePipes();
 
-    return 0;
+    return g_bAbort ? -2 : 0;
 }
@@ -0,0 +1,387 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "cddb.h"
+#include <cstdlib>
+#include <sstream>
+
+//------------------------------------------------------------------------------
+//! @brief      parse CDDB query result line
+//!
+//! @param[in]  line   The line
+//! @param      descr  The description
+//!
+//! @return     genre+cddbid as string
+//------------------------------------------------------------------------------
+std::string parseResultLine(const std::string& line, std::string& descr)
+{
+    std::ostringstream oss;
+    size_t last = 0; 
+    size_t next = 0; 
+    int    no   = 0;
+
+    while ((next = line.find_first_of(" \t", last)) != std::string::npos)
+    {
+        if (no == 0)
+        {
+            oss << line.substr(last, next - last) << "+";
+        }
+        else if (no == 1)
+        {
+            oss << line.substr(last, next - last);
+        }
+
+        last = next + 1;
+
+        if (no == 1)
+        {
+            descr = line.substr(last);
+
+            // remove \r
+            if ((next = descr.rfind("\r")) != descr.npos)
+            {
+                descr.erase(next, 1);
+            }
+            break;
+        }
+        no++;
+    }
+    return oss.str();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      parse complete CDDB query result
+//!
+//! @param[in]  input    CDDB query response
+//! @param[out] matches  all matches found
+//!
+//! @return     CDDB response code; -1 if response can't be parsed
+//------------------------------------------------------------------------------
+int parseCddbResults(const std::string& input, CddbMatches_t& matches)
+{
+    char* endPos;
+    int   code = std::strtol(input.c_str(), &endPos, 0);
+    std::string query, descr;
+
+    if (endPos == input.c_str())
+    {
+        return -1;
+    }
+
+    std::istringstream iss(input);
+    std::string line;
+    size_t      no = 0;
+
+    while(std::getline(iss, line))
+    {
+        switch(code)
+        {
+        // single exact match
+        case 200:
+            if (no++ == 0)
+            {
+                query = parseResultLine(line.substr(line.find_first_of(" \t") + 1), descr);
+                matches.push_back({query, descr});
+            }
+            break;
+        // multiple exact matches
+        case 210:
+        // [fallthrough] multiple inexact matches
+        case 211:
+            if (line[0] == '.')
+            {
+                break;
+            }
+
+            if (no++ > 0)
+            {
+                query = parseResultLine(line, descr);
+                matches.push_back({query, descr});
+            }
+            break;
+        // anything we wont handle
+        default:
+            break;
+        }
+    }
+
+    return code;
+}
+
+namespace
+{
+    /// max. tracks on an audio CD
+    constexpr size_t MAX_XMCD_TRACKS = 99;
+
+    //--------------------------------------------------------------------------
+    //! @brief      parse track index of keys like TTITLE12
+    //!
+    //! @param[in]  digits  text behind the key name
+    //! @param[out] idx     track index
+    //!
+    //! @return     true if valid
+    //--------------------------------------------------------------------------
+    bool xmcdIndex(std::string_view digits, size_t& idx)
+    {
+        idx = 0;
+
+        if (digits.empty() || (digits.size() > 2))
+        {
+            return false;
+        }
+
+        for (const auto& c : digits)
+        {
+            if ((c < '0') || (c > '9'))
+            {
+                return false;
+            }
+            idx = idx * 10 + (c - '0');
+        }
+
+        return idx < MAX_XMCD_TRACKS;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      get the slot for a track, grows the vector as needed
+    //!
+    //! @param      vec   track value vector
+    //! @param[in]  idx   track index
+    //!
+    //! @return     reference to slot
+    //--------------------------------------------------------------------------
+    std::string& xmcdSlot(std::vector<std::string>& vec, size_t idx)
+    {
+        if (vec.size() <= idx)
+        {
+            vec.resize(idx + 1);
+        }
+        return vec[idx];
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      append value and resolve the xmcd escapes for newline,
+    //!             tab and backslash (newline and tab become blanks)
+    //!
+    //! @param      out   target string
+    //! @param[in]  val   raw value
+    //--------------------------------------------------------------------------
+    void xmcdAppend(std::string& out, std::string_view val)
+    {
+        out.reserve(out.size() + val.size());
+
+        for (size_t i = 0; i < val.size(); i++)
+        {
+            if ((val[i] == '\\') && ((i + 1) < val.size()))
+            {
+                switch (val[++i])
+                {
+                case 'n':
+                case 't':
+                    out += ' ';
+                    break;
+                default:
+                    out += val[i];
+                    break;
+                }
+            }
+            else
+            {
+                out += val[i];
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      parse xmcd record in one pass; keys may be out of order
+//!             and split over several lines
+//!
+//! @param[in]  input  xmcd record (CDDB read response or file)
+//! @param[out] data   parsed values
+//!
+//! @return     0 -> ok; -1 -> no titles found
+//------------------------------------------------------------------------------
+int parseXmcd(std::string_view input, SXmcdData& data)
+{
+    size_t pos = 0;
+    size_t idx;
+
+    data = SXmcdData{};
+
+    while (pos < input.size())
+    {
+        size_t eol = input.find('\n', pos);
+
+        if (eol == std::string_view::npos)
+        {
+            eol = input.size();
+        }
+
+        std::string_view line = input.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (!line.empty() && (line.back() == '\r'))
+        {
+            line.remove_suffix(1);
+        }
+
+        // comments, response code and terminating dot have no '='
+        size_t eq = line.find('=');
+
+        if (line.empty() || (line[0] == '#') || (eq == std::string_view::npos) || (eq == 0))
+        {
+            continue;
+        }
+
+        std::string_view key = line.substr(0, eq);
+        std::string_view val = line.substr(eq + 1);
+        std::string*  target = nullptr;
+
+        switch (key[0])
+        {
+        case 'D':
+            if (key == "DTITLE")
+            {
+                target = &data.mDiscTitle;
+            }
+            else if (key == "DYEAR")
+            {
+                target = &data.mYear;
+            }
+            else if (key == "DGENRE")
+            {
+                target = &data.mGenre;
+            }
+            break;
+        case 'E':
+            if (key == "EXTD")
+            {
+                target = &data.mDiscExt;
+            }
+            else if ((key.compare(0, 4, "EXTT") == 0) && xmcdIndex(key.substr(4), idx))
+            {
+                target = &xmcdSlot(data.mTrackExt, idx);
+            }
+            break;
+        case 'T':
+            if ((key.compare(0, 6, "TTITLE") == 0) && xmcdIndex(key.substr(6), idx))
+            {
+                target = &xmcdSlot(data.mTrackTitles, idx);
+            }
+            break;
+        default:
+            break;
+        }
+
+        // repeated keys continue the value
+        if (target != nullptr)
+        {
+            xmcdAppend(*target, val);
+        }
+    }
+
+    return (data.mDiscTitle.empty() && data.mTrackTitles.empty()) ? -1 : 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      parse CDDB data response
+//!
+//! @param[in]  input  CDDB data response
+//! @param[out] info   disc title vector
+//! @param[in]  cs     MD title charset
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+int parseCddbInfo(const std::string& input, std::vector<std::string>& info, MdCharset cs)
+{
+    SXmcdData data;
+
+    if (parseXmcd(input, data) != 0)
+    {
+        return -1;
+    }
+
+    // index 0 -> disc title, index n -> track n
+    info.push_back(std::move(data.mDiscTitle));
+
+    for (auto& t : data.mTrackTitles)
+    {
+        info.push_back(std::move(t));
+    }
+
+    for (auto& t : info)
+    {
+        size_t pos;
+
+        if ((pos = t.find("/")) != t.npos)
+        {
+            t.replace(pos, 1, "-");
+        }
+    }
+
+    // charset is chosen once for the whole disc
+    toMdTitles(info, cs);
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      Makes a group title.
+//!
+//! @param[in]  gt    disc title
+//!
+//! @return     group title
+//------------------------------------------------------------------------------
+std::string makeGroupTitle(const std::string& gt)
+{
+    std::size_t pos;
+    std::string tok = gt;
+
+    while ((pos = tok.find_first_of(" \t")) != std::string::npos)
+    {
+        if (pos == 0)
+        {
+            tok = tok.substr(1);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    // remove double spaces
+    while ((pos = tok.find("  ")) != std::string::npos)
+    {
+        tok = tok.replace(pos, 2, " ");
+    }
+
+    // remove some well known token starts
+    if ((pos = tok.find_first_of("([{/<>")) != std::string::npos)
+    {
+        if (pos > 5)
+        {
+            tok = tok.substr(0, pos);
+        }
+    }
+
+    if ((pos = tok.find_last_not_of(" \t")) != std::string::npos)
+    {
+        tok = tok.substr(0, pos + 1);
+    }
+
+    return tok;
+}
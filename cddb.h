@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include "utils.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+//
+// CDDB / xmcd parsing helpers. Nothing in here touches the console,
+// the network or any Windows API, so these functions can be built
+// and timed on any platform.
+//
+
+/// one match of a CDDB query
+struct SCddbMatch
+{
+    std::string mQuery;  ///< genre+cddbid as used in cddb read
+    std::string mDescr;  ///< disc description
+};
+
+/// define match vector type
+typedef std::vector<SCddbMatch> CddbMatches_t;
+
+/// content of a xmcd record (values unescaped, not transliterated)
+struct SXmcdData
+{
+    std::string              mDiscTitle;    ///< DTITLE (artist / title)
+    std::string              mYear;         ///< DYEAR
+    std::string              mGenre;        ///< DGENRE
+    std::string              mDiscExt;      ///< EXTD
+    std::vector<std::string> mTrackTitles;  ///< TTITLEn, index n
+    std::vector<std::string> mTrackExt;     ///< EXTTn, index n
+};
+
+//------------------------------------------------------------------------------
+//! @brief      parse CDDB query result line
+//!
+//! @param[in]  line   The line
+//! @param      descr  The description
+//!
+//! @return     genre+cddbid as string
+//------------------------------------------------------------------------------
+std::string parseResultLine(const std::string& line, std::string& descr);
+
+//------------------------------------------------------------------------------
+//! @brief      parse complete CDDB query result
+//!
+//! @param[in]  input    CDDB query response
+//! @param[out] matches  all matches found
+//!
+//! @return     CDDB response code; -1 if response can't be parsed
+//------------------------------------------------------------------------------
+int parseCddbResults(const std::string& input, CddbMatches_t& matches);
+
+//------------------------------------------------------------------------------
+//! @brief      parse xmcd record in one pass; keys may be out of order
+//!             and split over several lines
+//!
+//! @param[in]  input  xmcd record (CDDB read response or file)
+//! @param[out] data   parsed values
+//!
+//! @return     0 -> ok; -1 -> no titles found
+//------------------------------------------------------------------------------
+int parseXmcd(std::string_view input, SXmcdData& data);
+
+//------------------------------------------------------------------------------
+//! @brief      parse CDDB data response
+//!
+//! @param[in]  input  CDDB data response
+//! @param[out] info   disc title vector
+//! @param[in]  cs     MD title charset
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+int parseCddbInfo(const std::string& input, std::vector<std::string>& info, MdCharset cs = MdCharset::ASCII);
+
+//------------------------------------------------------------------------------
+//! @brief      Makes a group title.
+//!
+//! @param[in]  gt    disc title
+//!
+//! @return     group title
+//------------------------------------------------------------------------------
+std::string makeGroupTitle(const std::string& gt);
@@ -0,0 +1,234 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#include "cdtext.h"
+
+namespace
+{
+    /// pack types we use
+    enum : uint8_t
+    {
+        PACK_TITLE     = 0x80,
+        PACK_PERFORMER = 0x81,
+        PACK_SIZE_INFO = 0x8F,
+    };
+
+    /// character codes (size info pack)
+    enum : uint8_t
+    {
+        CHARSET_8859_1 = 0x00,
+        CHARSET_ASCII  = 0x01,
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      collect the strings of one pack type
+    //!
+    //! @param[in]  packs       valid packs of block 0
+    //! @param[in]  type        pack type
+    //! @param[in]  trackCount  number of tracks
+    //!
+    //! @return     strings by track number (0 -> disc)
+    //--------------------------------------------------------------------------
+    std::vector<std::string> collect(const std::vector<const uint8_t*>& packs,
+                                     uint8_t type, uint32_t trackCount)
+    {
+        std::vector<std::string> out(trackCount + 1);
+        std::string buf;
+        uint32_t    track = 0;
+        bool        skip  = false;
+        int         seq   = -1;
+
+        for (const auto& p : packs)
+        {
+            if (p[0] != type)
+            {
+                continue;
+            }
+
+            // lost packs (CRC error) in between -> resync at this pack
+            if ((seq == -1) || (p[2] != static_cast<uint8_t>(seq + 1)))
+            {
+                buf.clear();
+                track = p[1] & 0x7F;
+
+                // string started in a lost pack -> drop its tail
+                skip = (seq != -1) && ((p[3] & 0x0F) != 0);
+            }
+            seq = p[2];
+
+            for (int i = 4; i < 16; i++)
+            {
+                if (p[i] == 0)
+                {
+                    if (!skip && (track <= trackCount))
+                    {
+                        // single TAB -> same as previous track
+                        out[track] = ((buf == "\t") && (track > 0)) ? out[track - 1] : buf;
+                    }
+                    buf.clear();
+                    skip = false;
+                    track++;
+                }
+                else if (!skip)
+                {
+                    buf += static_cast<char>(p[i]);
+                }
+            }
+        }
+
+        return out;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      convert ISO-8859-1 to UTF-8
+    //!
+    //! @param[in]  in    latin 1 string
+    //!
+    //! @return     UTF-8 string
+    //--------------------------------------------------------------------------
+    std::string latin1ToUtf8(const std::string& in)
+    {
+        std::string out;
+        for (const auto& c : in)
+        {
+            uint8_t u = static_cast<uint8_t>(c);
+            if (u < 0x80)
+            {
+                out += c;
+            }
+            else
+            {
+                out += static_cast<char>(0xC0 | (u >> 6));
+                out += static_cast<char>(0x80 | (u & 0x3F));
+            }
+        }
+        return out;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      check CRC of a CD-Text pack (CRC-16 CCITT, inverted)
+//!
+//! @param[in]  pack  The pack (18 bytes)
+//!
+//! @return     true if CRC matches
+//------------------------------------------------------------------------------
+bool cdTextCrcOk(const uint8_t* pack)
+{
+    uint16_t crc = 0;
+
+    for (int i = 0; i < 16; i++)
+    {
+        crc ^= static_cast<uint16_t>(pack[i]) << 8;
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+
+    crc = ~crc;
+    return (pack[16] == (crc >> 8)) && (pack[17] == (crc & 0xFF));
+}
+
+//------------------------------------------------------------------------------
+//! @brief      decode disc and track titles from CD-Text packs
+//!             (first block only, single byte character sets)
+//!
+//! @param[in]  packs       CD-Text packs
+//! @param[in]  size        size of packs in bytes
+//! @param[in]  trackCount  number of tracks on CD
+//! @param[out] titles      UTF-8 titles; index 0 -> disc title (same layout as CDDB)
+//!
+//! @return     0 -> titles found; -1 -> no usable CD-Text
+//------------------------------------------------------------------------------
+int parseCdText(const uint8_t* packs, size_t size, uint32_t trackCount, std::vector<std::string>& titles)
+{
+    std::vector<const uint8_t*> valid;
+    size_t  count   = size / CDTEXT_PACK_SIZE;
+    bool    noCrc   = true;
+    uint8_t charset = CHARSET_8859_1;
+
+    titles.clear();
+
+    // some drives deliver the packs with zeroed CRC fields
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* p = packs + i * CDTEXT_PACK_SIZE;
+        if (p[16] || p[17])
+        {
+            noCrc = false;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* p = packs + i * CDTEXT_PACK_SIZE;
+
+        // block 0 only; double byte (MS-JIS) blocks aren't supported
+        if (((p[3] & 0x70) != 0) || (!noCrc && !cdTextCrcOk(p)))
+        {
+            continue;
+        }
+
+        if (p[3] & 0x80)
+        {
+            return -1;
+        }
+
+        if ((p[0] == PACK_SIZE_INFO) && (p[1] == 0))
+        {
+            charset = p[4];
+        }
+
+        valid.push_back(p);
+    }
+
+    if ((charset != CHARSET_8859_1) && (charset != CHARSET_ASCII))
+    {
+        return -1;
+    }
+
+    std::vector<std::string> title     = collect(valid, PACK_TITLE, trackCount);
+    std::vector<std::string> performer = collect(valid, PACK_PERFORMER, trackCount);
+    bool found = false;
+
+    for (const auto& t : title)
+    {
+        found = found || !t.empty();
+    }
+
+    if (!found)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i <= trackCount; i++)
+    {
+        std::string tok = title[i];
+
+        // like CDDB: "artist - title" for disc and for tracks
+        // which don't share the disc artist
+        if (!performer[i].empty() && !tok.empty() && ((i == 0) || (performer[i] != performer[0])))
+        {
+            tok = performer[i] + " - " + tok;
+        }
+
+        titles.push_back(latin1ToUtf8(tok));
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// CD-Text decoding (READ TOC format 5). Platform neutral, the packs
+// are read by CAudioCD.
+//
+
+/// size of one CD-Text pack
+static constexpr size_t CDTEXT_PACK_SIZE = 18;
+
+//------------------------------------------------------------------------------
+//! @brief      check CRC of a CD-Text pack (CRC-16 CCITT, inverted)
+//!
+//! @param[in]  pack  The pack (18 bytes)
+//!
+//! @return     true if CRC matches
+//------------------------------------------------------------------------------
+bool cdTextCrcOk(const uint8_t* pack);
+
+//------------------------------------------------------------------------------
+//! @brief      decode disc and track titles from CD-Text packs
+//!             (first block only, single byte character sets)
+//!
+//! @param[in]  packs       CD-Text packs
+//! @param[in]  size        size of packs in bytes
+//! @param[in]  trackCount  number of tracks on CD
+//! @param[out] titles      UTF-8 titles; index 0 -> disc title (same layout as CDDB)
+//!
+//! @return     0 -> titles found; -1 -> no usable CD-Text
+//------------------------------------------------------------------------------
+int parseCdText(const uint8_t* packs, size_t size, uint32_t trackCount, std::vector<std::string>& titles);
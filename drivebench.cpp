@@ -0,0 +1,211 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#include "drivebench.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    /// chunk sizes (sectors per read) to measure
+    constexpr ULONG BENCH_CHUNKS[] = {1, 4, 8, 16, 24};
+
+    /// sectors per measurement (20 s of audio)
+    constexpr ULONG BENCH_SECTORS = 1500;
+
+    /// time limit per measurement
+    constexpr double BENCH_MAX_MS = 15000.0;
+
+    /// number of random seeks
+    constexpr int BENCH_SEEKS = 20;
+
+    /// bytes per second at 1x
+    constexpr double BYTES_1X = 176400.0;
+
+    using Clock = std::chrono::steady_clock;
+
+    //--------------------------------------------------------------------------
+    //! @brief      ms since given time point
+    //--------------------------------------------------------------------------
+    double msSince(const Clock::time_point& tp)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - tp).count();
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      sequential read throughput
+    //!
+    //! @param[in]  cd     audio CD
+    //! @param[in]  lba    first sector
+    //! @param[in]  end    first sector behind readable area
+    //! @param[in]  chunk  sectors per read
+    //! @param[in]  buf    read buffer (chunk sectors)
+    //!
+    //! @return     bytes per second; < 0 -> read error
+    //--------------------------------------------------------------------------
+    double throughput(CAudioCD& cd, ULONG lba, ULONG end, ULONG chunk, char* buf)
+    {
+        ULONG  done  = 0;
+        double ms    = 0.0;
+
+        // seek + spin to speed, not measured
+        if (!cd.ReadRaw(lba, 1, buf))
+        {
+            return -1.0;
+        }
+        lba++;
+
+        auto start = Clock::now();
+
+        while ((done < BENCH_SECTORS) && ((lba + chunk) <= end) && ((ms = msSince(start)) < BENCH_MAX_MS))
+        {
+            if (!cd.ReadRaw(lba, chunk, buf))
+            {
+                return -1.0;
+            }
+            lba  += chunk;
+            done += chunk;
+        }
+
+        ms = msSince(start);
+        return (ms > 0.0) ? (done * static_cast<double>(RAW_SECTOR_SIZE) * 1000.0 / ms) : 0.0;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      run drive benchmark on the inserted disc and print results
+//!
+//! @param[in]  cd    opened audio CD
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+int benchDrive(CAudioCD& cd)
+{
+    ULONG first = 0, end = 0, addr, len;
+
+    for (ULONG t = 0; cd.GetTrackExtent(t, addr, len); t++)
+    {
+        if (t == 0)
+        {
+            first = addr;
+        }
+        end = addr + len;
+    }
+
+    ULONG maxChunk = BENCH_CHUNKS[sizeof(BENCH_CHUNKS) / sizeof(BENCH_CHUNKS[0]) - 1];
+    ULONG zoneSize = BENCH_SECTORS * (sizeof(BENCH_CHUNKS) / sizeof(BENCH_CHUNKS[0])) + maxChunk + 1;
+
+    if ((end <= first) || ((end - first) < zoneSize))
+    {
+        std::fprintf(stderr, "Disc too short for drive benchmark!\n");
+        return -1;
+    }
+
+    std::vector<char> buf(maxChunk * RAW_SECTOR_SIZE);
+
+    std::printf("\nDrive benchmark\n===============\n");
+    std::printf("Drive: %s, max. speed: %ux, C2 error pointers: %s\n",
+                cd.DriveModel().c_str(), cd.DriveMaxSpeed(), cd.HasC2() ? "yes" : "no");
+
+    // spin-up
+    double spinUp = -1.0;
+    if (cd.SpinDown())
+    {
+        Sleep(3000);
+        auto start = Clock::now();
+        if (cd.ReadRaw(first, 1, buf.data()))
+        {
+            spinUp = msSince(start);
+        }
+    }
+
+    if (spinUp >= 0.0)
+    {
+        std::printf("Spin-up:            %8.0f ms\n", spinUp);
+    }
+    else
+    {
+        std::printf("Spin-up:            n/a (drive doesn't stop on request)\n");
+    }
+
+    // seek latency: random single sector reads, then full stroke
+    double seekSum = 0.0, seekMax = 0.0, strokeSum = 0.0;
+    uint32_t rnd = 0x2545F491;
+
+    for (int i = 0; i < BENCH_SEEKS; i++)
+    {
+        rnd = rnd * 1664525u + 1013904223u;
+        ULONG lba = first + (rnd % (end - first));
+
+        auto start = Clock::now();
+        if (!cd.ReadRaw(lba, 1, buf.data()))
+        {
+            std::fprintf(stderr, "Read error at sector %lu!\n", static_cast<unsigned long>(lba));
+            return -1;
+        }
+        double ms = msSince(start);
+        seekSum += ms;
+        seekMax  = (ms > seekMax) ? ms : seekMax;
+
+        start = Clock::now();
+        cd.ReadRaw((i & 1) ? first : (end - 1), 1, buf.data());
+        strokeSum += msSince(start);
+    }
+
+    std::printf("Seek (random):      %8.1f ms avg, %.1f ms max\n", seekSum / BENCH_SEEKS, seekMax);
+    std::printf("Seek (full stroke): %8.1f ms avg\n", strokeSum / BENCH_SEEKS);
+
+    // sustained throughput per zone and chunk size
+    struct { const char* name; ULONG lba; } zones[] = {
+        {"inner" , first},
+        {"middle", first + (end - first) / 2 - zoneSize / 2},
+        {"outer" , end - zoneSize},
+    };
+
+    std::printf("\nSustained read [MB/s (speed)], sectors per read:\n%-8s", "zone");
+    for (auto c : BENCH_CHUNKS)
+    {
+        std::printf("  %10lu     ", static_cast<unsigned long>(c));
+    }
+    std::printf("\n");
+
+    for (const auto& z : zones)
+    {
+        ULONG lba = z.lba;
+        std::printf("%-8s", z.name);
+
+        for (auto c : BENCH_CHUNKS)
+        {
+            double bps = throughput(cd, lba, end, c, buf.data());
+            if (bps < 0.0)
+            {
+                std::printf("  %15s", "read error");
+            }
+            else
+            {
+                std::printf("  %6.2f (%5.1fx)", bps / 1e6, bps / BYTES_1X);
+            }
+            std::fflush(stdout);
+
+            // fresh data for the next chunk size (no cache hits)
+            lba += BENCH_SECTORS + 1;
+        }
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include "CAudioCD.h"
+
+//
+// Drive benchmark (--bench-drive): sustained throughput in the inner,
+// middle and outer zone of the disc for several chunk sizes, seek latency
+// and spin-up time. Uses the same read path as ripping, writes nothing.
+//
+
+//------------------------------------------------------------------------------
+//! @brief      run drive benchmark on the inserted disc and print results
+//!
+//! @param[in]  cd    opened audio CD
+//!
+//! @return     0 -> ok; -1 -> error
+//------------------------------------------------------------------------------
+int benchDrive(CAudioCD& cd);
@@ -0,0 +1,208 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#include "progress.h"
+#include <chrono>
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    //! @brief      find value of a key in a flat JSON object
+    //!
+    //! @param[in]  line  JSON line
+    //! @param[in]  key   key (w/o quotes)
+    //!
+    //! @return     position of value; npos if not found
+    //--------------------------------------------------------------------------
+    size_t valuePos(std::string_view line, std::string_view key)
+    {
+        size_t pos = 0;
+
+        while ((pos = line.find(key, pos)) != std::string_view::npos)
+        {
+            size_t end = pos + key.size();
+
+            if ((pos > 0) && (line[pos - 1] == '"') && (end + 1 < line.size())
+                && (line[end] == '"') && (line[end + 1] == ':'))
+            {
+                return end + 2;
+            }
+            pos = end;
+        }
+
+        return std::string_view::npos;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      read unsigned number
+    //--------------------------------------------------------------------------
+    bool numberValue(std::string_view line, std::string_view key, uint64_t& val)
+    {
+        size_t pos = valuePos(line, key);
+        size_t cnt = 0;
+        val = 0;
+
+        if (pos == std::string_view::npos)
+        {
+            return false;
+        }
+
+        for (; (pos < line.size()) && (line[pos] >= '0') && (line[pos] <= '9'); pos++, cnt++)
+        {
+            val = val * 10 + (line[pos] - '0');
+        }
+
+        return cnt > 0;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      read string (no escapes needed for our records)
+    //--------------------------------------------------------------------------
+    bool stringValue(std::string_view line, std::string_view key, std::string& val)
+    {
+        size_t pos = valuePos(line, key);
+        size_t end;
+
+        if ((pos == std::string_view::npos) || (pos >= line.size()) || (line[pos] != '"')
+            || ((end = line.find('"', pos + 1)) == std::string_view::npos))
+        {
+            return false;
+        }
+
+        val = line.substr(pos + 1, end - pos - 1);
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      progress in percent (0 ... 100)
+//------------------------------------------------------------------------------
+int SProgress::percent() const
+{
+    if (mTotal == 0)
+    {
+        return 0;
+    }
+    return static_cast<int>(((mDone > mTotal) ? mTotal : mDone) * 100 / mTotal);
+}
+
+//------------------------------------------------------------------------------
+//! @brief      time stamp for progress records (steady clock, ms)
+//!
+//! @return     time stamp
+//------------------------------------------------------------------------------
+uint64_t progressTs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+//! @brief      format progress record as JSON line (incl. newline)
+//!
+//! @param[in]  p     progress record
+//!
+//! @return     record line
+//------------------------------------------------------------------------------
+std::string progressRecord(const SProgress& p)
+{
+    return "{\"stage\":\"" + p.mStage + "\",\"track\":" + std::to_string(p.mTrack)
+         + ",\"done\":" + std::to_string(p.mDone) + ",\"total\":" + std::to_string(p.mTotal)
+         + ",\"ts\":" + std::to_string(p.mTs) + "}\n";
+}
+
+//------------------------------------------------------------------------------
+//! @brief      parse a progress record line
+//!
+//! @param[in]  line  one line w/o newline
+//! @param[out] p     progress record
+//!
+//! @return     true if line is a valid record
+//------------------------------------------------------------------------------
+bool parseProgress(std::string_view line, SProgress& p)
+{
+    uint64_t track = 0;
+
+    if (line.empty() || (line.front() != '{') || (line.back() != '}'))
+    {
+        return false;
+    }
+
+    if (!stringValue(line, "stage", p.mStage)
+        || !numberValue(line, "track", track)
+        || !numberValue(line, "done", p.mDone)
+        || !numberValue(line, "total", p.mTotal))
+    {
+        return false;
+    }
+
+    p.mTrack = static_cast<int>(track);
+
+    // time stamp is optional
+    if (!numberValue(line, "ts", p.mTs))
+    {
+        p.mTs = 0;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      get the last percent value ("... 42% ...") from a line of
+//!             tool output; never throws
+//!
+//! @param[in]  line     one line of output
+//! @param[out] percent  percent value (0 ... 100)
+//!
+//! @return     true if a percent value was found
+//------------------------------------------------------------------------------
+bool parsePercent(std::string_view line, int& percent)
+{
+    size_t pos = line.size();
+
+    while ((pos = line.rfind('%', pos - 1)) != std::string_view::npos)
+    {
+        size_t start = pos;
+
+        while ((start > 0) && (line[start - 1] >= '0') && (line[start - 1] <= '9'))
+        {
+            start--;
+        }
+
+        // up to 3 digits, value 0 ... 100
+        if ((start < pos) && ((pos - start) <= 3))
+        {
+            int val = 0;
+            for (size_t i = start; i < pos; i++)
+            {
+                val = val * 10 + (line[i] - '0');
+            }
+
+            if (val <= 100)
+            {
+                percent = val;
+                return true;
+            }
+        }
+
+        if (pos == 0)
+        {
+            break;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//
+// Progress protocol: one JSON object per line, e.g.
+// {"stage":"rip","track":3,"done":1234567,"total":45678900,"ts":81234}
+// Output of external tools which we can't change is parsed with
+// parsePercent().
+//
+
+/// one progress record
+struct SProgress
+{
+    std::string mStage;      ///< pipeline stage ("rip", "enc", "trf")
+    int         mTrack = 0;  ///< track number (1 based)
+    uint64_t    mDone  = 0;  ///< bytes done
+    uint64_t    mTotal = 0;  ///< bytes total
+    uint64_t    mTs    = 0;  ///< time stamp in ms (see progressTs())
+
+    //! progress in percent (0 ... 100)
+    int percent() const;
+};
+
+//------------------------------------------------------------------------------
+//! @brief      time stamp for progress records (steady clock, ms)
+//!
+//! @return     time stamp
+//------------------------------------------------------------------------------
+uint64_t progressTs();
+
+//------------------------------------------------------------------------------
+//! @brief      format progress record as JSON line (incl. newline)
+//!
+//! @param[in]  p     progress record
+//!
+//! @return     record line
+//------------------------------------------------------------------------------
+std::string progressRecord(const SProgress& p);
+
+//------------------------------------------------------------------------------
+//! @brief      parse a progress record line
+//!
+//! @param[in]  line  one line w/o newline
+//! @param[out] p     progress record
+//!
+//! @return     true if line is a valid record
+//------------------------------------------------------------------------------
+bool parseProgress(std::string_view line, SProgress& p);
+
+//------------------------------------------------------------------------------
+//! @brief      get the last percent value ("... 42% ...") from a line of
+//!             tool output; never throws
+//!
+//! @param[in]  line     one line of output
+//! @param[out] percent  percent value (0 ... 100)
+//!
+//! @return     true if a percent value was found
+//------------------------------------------------------------------------------
+bool parsePercent(std::string_view line, int& percent);
@@ -0,0 +1,250 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#include "titleplan.h"
+#include <algorithm>
+
+namespace
+{
+    /// word -> abbreviation
+    struct SAbbrev
+    {
+        const char* mWord;
+        const char* mShort;
+    };
+
+    /// well known words in titles (matched as whole words)
+    constexpr SAbbrev ABBREVIATIONS[] = {
+        { "featuring"   , "ft."    },
+        { "Featuring"   , "ft."    },
+        { "feat."       , "ft."    },
+        { "Feat."       , "ft."    },
+        { "and"         , "&"      },
+        { "Version"     , "Ver."   },
+        { "version"     , "ver."   },
+        { "Remastered"  , "Rmst."  },
+        { "remastered"  , "rmst."  },
+        { "Remaster"    , "Rmst."  },
+        { "Original"    , "Orig."  },
+        { "Orchestra"   , "Orch."  },
+        { "Symphony"    , "Sym."   },
+        { "Number"      , "No."    },
+        { "Part"        , "Pt."    },
+        { "Edition"     , "Ed."    },
+        { "Instrumental", "Instr." },
+        { "Extended"    , "Ext."   },
+        { "Volume"      , "Vol."   },
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      cells of one record
+    //--------------------------------------------------------------------------
+    size_t itemCells(const STitleItem& it)
+    {
+        return titleCells(it.mFixed + it.mText.size());
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      cells of all records
+    //--------------------------------------------------------------------------
+    size_t totalCells(const std::vector<STitleItem>& items)
+    {
+        size_t sum = 0;
+        for (const auto& it : items)
+        {
+            sum += itemCells(it);
+        }
+        return sum;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      remove double and trailing blanks
+    //--------------------------------------------------------------------------
+    void squeeze(std::string& s)
+    {
+        std::string out;
+        out.reserve(s.size());
+
+        for (const auto& c : s)
+        {
+            if ((c != ' ') || (!out.empty() && (out.back() != ' ')))
+            {
+                out += c;
+            }
+        }
+
+        while (!out.empty() && (out.back() == ' '))
+        {
+            out.pop_back();
+        }
+        s = out;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      abbreviate well known words
+    //--------------------------------------------------------------------------
+    void abbreviate(std::string& s)
+    {
+        std::string out;
+        size_t      pos = 0;
+
+        squeeze(s);
+
+        while (pos < s.size())
+        {
+            size_t end = s.find(' ', pos);
+            if (end == std::string::npos)
+            {
+                end = s.size();
+            }
+
+            // keep brackets around a word, e.g. "(Remastered)"
+            size_t first = s.find_first_not_of("([", pos);
+            size_t last  = s.find_last_not_of(")],", end - 1);
+
+            if ((first < end) && (last != std::string::npos) && (last >= first))
+            {
+                std::string word = s.substr(first, last + 1 - first);
+
+                for (const auto& a : ABBREVIATIONS)
+                {
+                    if (word == a.mWord)
+                    {
+                        word = a.mShort;
+                        break;
+                    }
+                }
+
+                out += s.substr(pos, first - pos) + word + s.substr(last + 1, end - last - 1);
+            }
+            else
+            {
+                out += s.substr(pos, end - pos);
+            }
+            if (end < s.size())
+            {
+                out += ' ';
+            }
+            pos = end + 1;
+        }
+        s = out;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      cells used if no record may use more than cap cells
+    //!             (fixed parts are never cut)
+    //--------------------------------------------------------------------------
+    size_t cappedCells(const std::vector<STitleItem>& items, size_t cap)
+    {
+        size_t sum = 0;
+        for (const auto& it : items)
+        {
+            sum += std::min(itemCells(it), std::max(cap, titleCells(it.mFixed)));
+        }
+        return sum;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! @brief      cells needed for a title record
+//!
+//! @param[in]  chars  length of the record
+//!
+//! @return     number of cells
+//------------------------------------------------------------------------------
+size_t titleCells(size_t chars)
+{
+    return (chars + MD_CELL_CHARS - 1) / MD_CELL_CHARS;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      shorten titles, so that all records fit into the given cells:
+//!             first well known words are abbreviated, then the longest
+//!             titles are trimmed evenly (the longest one is as short as
+//!             possible)
+//!
+//! @param      items  title records; texts are shortened in place
+//! @param[in]  cells  available cells
+//!
+//! @return     cells used after planning
+//------------------------------------------------------------------------------
+size_t planTitles(std::vector<STitleItem>& items, size_t cells)
+{
+    if (totalCells(items) <= cells)
+    {
+        return totalCells(items);
+    }
+
+    for (auto& it : items)
+    {
+        abbreviate(it.mText);
+    }
+
+    if (totalCells(items) <= cells)
+    {
+        return totalCells(items);
+    }
+
+    // largest cap per record which still fits (water filling)
+    size_t maxCells = 0;
+    for (const auto& it : items)
+    {
+        maxCells = std::max(maxCells, itemCells(it));
+    }
+
+    size_t lo = 0, hi = maxCells;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi + 1) / 2;
+        if (cappedCells(items, mid) <= cells)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    // cells left below the next cap go to the records in disc order
+    size_t spare = (cappedCells(items, lo) <= cells) ? (cells - cappedCells(items, lo)) : 0;
+
+    for (auto& it : items)
+    {
+        size_t cap = std::max(lo, titleCells(it.mFixed));
+
+        if (itemCells(it) <= cap)
+        {
+            continue;
+        }
+
+        if (spare > 0)
+        {
+            cap++;
+            spare--;
+        }
+
+        size_t chars = cap * MD_CELL_CHARS;
+        it.mText.resize((chars > it.mFixed) ? std::min(it.mText.size(), chars - it.mFixed) : 0);
+
+        while (!it.mText.empty() && (it.mText.back() == ' '))
+        {
+            it.mText.pop_back();
+        }
+    }
+
+    return totalCells(items);
+}
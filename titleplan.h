@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2021 Jo2003 (olenka.joerg@gmail.com)
+ * This file is part of cd2netmd
+ *
+ * cd2netmd is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cd2netmd is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ */
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//
+// MD TOC title space planning. The UTOC holds 255 title cells of 7
+// characters, shared by the disc title (incl. group definitions) and
+// all track titles. Every title takes ceil(length / 7) cells.
+//
+
+/// title cells in the UTOC
+static constexpr size_t MD_TITLE_CELLS = 255;
+
+/// characters per title cell
+static constexpr size_t MD_CELL_CHARS  = 7;
+
+/// one TOC title record
+struct STitleItem
+{
+    std::string mText;       ///< title part we may shorten
+    size_t      mFixed = 0;  ///< characters in the same record we must keep (group syntax, existing titles)
+};
+
+//------------------------------------------------------------------------------
+//! @brief      cells needed for a title record
+//!
+//! @param[in]  chars  length of the record
+//!
+//! @return     number of cells
+//------------------------------------------------------------------------------
+size_t titleCells(size_t chars);
+
+//------------------------------------------------------------------------------
+//! @brief      shorten titles, so that all records fit into the given cells:
+//!             first well known words are abbreviated, then the longest
+//!             titles are trimmed evenly (the longest one is as short as
+//!             possible)
+//!
+//! @param      items  title records; texts are shortened in place
+//! @param[in]  cells  available cells
+//!
+//! @return     cells used after planning
+//------------------------------------------------------------------------------
+size_t planTitles(std::vector<STitleItem>& items, size_t cells);
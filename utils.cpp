@@ -15,106 +15,625 @@
  * You should have received a copy of the GNU General Public License
  */
 #include "utils.h"
-#include <cstddef>
-#include <cstdio>
-#include <string>
-#include <vector>
+#include <algorithm>
+#include <cstdint>
 
-//------------------------------------------------------------------------------
-//! @brief      convert string
-//!
-//! @param[in]  cd    conversion enum
-//! @param[in]  in    string to convert
-//! @param      out   converted string
-//!
-//! @return     converted string on success; unconverted in error case
-//------------------------------------------------------------------------------
-std::string cddb_str_iconv(iconv_t cd, const char *in)
+namespace
 {
-    std::string ret = in;
-    size_t inlen, outlen;
-    int buflen, rc;
-    int len;                    /* number of chars in buffer */
-    char *buf;
-    char *inbuf = strdup(in);
-    char *inPtr = inbuf;
-
-    if (inbuf != nullptr)
+    /// transliteration of U+00A0 ... U+024F (Latin-1 supplement, Latin extended A / B)
+    constexpr uint32_t LATIN_FIRST = 0x00A0;
+    constexpr uint32_t LATIN_LAST  = 0x024F;
+
+    constexpr const char* LATIN_TRANSLIT[LATIN_LAST - LATIN_FIRST + 1] = {
+    " "   , "!"   , "c"   , "GBP" , ""    , "JPY" , "|"   , "S",  // U+00A0
+    "\""  , "(C)" , "a"   , "<<"  , "-"   , ""    , "(R)" , "-",  // U+00A8
+    "o"   , "+-"  , "2"   , "3"   , "'"   , "u"   , "P"   , ".",  // U+00B0
+    ","   , "1"   , "o"   , ">>"  , "1/4" , "1/2" , "3/4" , "?",  // U+00B8
+    "A"   , "A"   , "A"   , "A"   , "Ae"  , "A"   , "AE"  , "C",  // U+00C0
+    "E"   , "E"   , "E"   , "E"   , "I"   , "I"   , "I"   , "I",  // U+00C8
+    "D"   , "N"   , "O"   , "O"   , "O"   , "O"   , "Oe"  , "x",  // U+00D0
+    "O"   , "U"   , "U"   , "U"   , "Ue"  , "Y"   , "Th"  , "ss",  // U+00D8
+    "a"   , "a"   , "a"   , "a"   , "ae"  , "a"   , "ae"  , "c",  // U+00E0
+    "e"   , "e"   , "e"   , "e"   , "i"   , "i"   , "i"   , "i",  // U+00E8
+    "d"   , "n"   , "o"   , "o"   , "o"   , "o"   , "oe"  , ":",  // U+00F0
+    "o"   , "u"   , "u"   , "u"   , "ue"  , "y"   , "th"  , "y",  // U+00F8
+    "A"   , "a"   , "A"   , "a"   , "A"   , "a"   , "C"   , "c",  // U+0100
+    "C"   , "c"   , "C"   , "c"   , "C"   , "c"   , "D"   , "d",  // U+0108
+    "D"   , "d"   , "E"   , "e"   , "E"   , "e"   , "E"   , "e",  // U+0110
+    "E"   , "e"   , "E"   , "e"   , "G"   , "g"   , "G"   , "g",  // U+0118
+    "G"   , "g"   , "G"   , "g"   , "H"   , "h"   , "H"   , "h",  // U+0120
+    "I"   , "i"   , "I"   , "i"   , "I"   , "i"   , "I"   , "i",  // U+0128
+    "I"   , "i"   , "IJ"  , "ij"  , "J"   , "j"   , "K"   , "k",  // U+0130
+    "q"   , "L"   , "l"   , "L"   , "l"   , "L"   , "l"   , "L",  // U+0138
+    "l"   , "L"   , "l"   , "N"   , "n"   , "N"   , "n"   , "N",  // U+0140
+    "n"   , "'n"  , "N"   , "n"   , "O"   , "o"   , "O"   , "o",  // U+0148
+    "O"   , "o"   , "OE"  , "oe"  , "R"   , "r"   , "R"   , "r",  // U+0150
+    "R"   , "r"   , "S"   , "s"   , "S"   , "s"   , "S"   , "s",  // U+0158
+    "S"   , "s"   , "T"   , "t"   , "T"   , "t"   , "T"   , "t",  // U+0160
+    "U"   , "u"   , "U"   , "u"   , "U"   , "u"   , "U"   , "u",  // U+0168
+    "U"   , "u"   , "U"   , "u"   , "W"   , "w"   , "Y"   , "y",  // U+0170
+    "Y"   , "Z"   , "z"   , "Z"   , "z"   , "Z"   , "z"   , "s",  // U+0178
+    "b"   , "B"   , ""    , ""    , ""    , ""    , "O"   , "",  // U+0180
+    ""    , "D"   , "D"   , ""    , ""    , ""    , ""    , "",  // U+0188
+    "E"   , "F"   , "f"   , "G"   , ""    , ""    , ""    , "I",  // U+0190
+    ""    , ""    , "l"   , ""    , ""    , "N"   , "n"   , "O",  // U+0198
+    "O"   , "o"   , ""    , ""    , "P"   , "p"   , ""    , "",  // U+01A0
+    ""    , ""    , ""    , "t"   , "T"   , "t"   , "T"   , "U",  // U+01A8
+    "u"   , ""    , "V"   , "Y"   , "y"   , "Z"   , "z"   , "",  // U+01B0
+    ""    , ""    , ""    , ""    , ""    , ""    , ""    , "",  // U+01B8
+    ""    , ""    , ""    , ""    , "DZ"  , "Dz"  , "dz"  , "LJ",  // U+01C0
+    "Lj"  , "lj"  , "NJ"  , "Nj"  , "nj"  , "A"   , "a"   , "I",  // U+01C8
+    "i"   , "O"   , "o"   , "U"   , "u"   , "U"   , "u"   , "U",  // U+01D0
+    "u"   , "U"   , "u"   , "U"   , "u"   , ""    , "A"   , "a",  // U+01D8
+    "A"   , "a"   , "AE"  , "ae"  , "G"   , "g"   , "G"   , "g",  // U+01E0
+    "K"   , "k"   , "O"   , "o"   , "O"   , "o"   , ""    , "",  // U+01E8
+    "j"   , "DZ"  , "Dz"  , "dz"  , "G"   , "g"   , ""    , "",  // U+01F0
+    "N"   , "n"   , "A"   , "a"   , "AE"  , "ae"  , "O"   , "o",  // U+01F8
+    "A"   , "a"   , "A"   , "a"   , "E"   , "e"   , "E"   , "e",  // U+0200
+    "I"   , "i"   , "I"   , "i"   , "O"   , "o"   , "O"   , "o",  // U+0208
+    "R"   , "r"   , "R"   , "r"   , "U"   , "u"   , "U"   , "u",  // U+0210
+    "S"   , "s"   , "T"   , "t"   , ""    , ""    , "H"   , "h",  // U+0218
+    ""    , ""    , ""    , ""    , ""    , ""    , "A"   , "a",  // U+0220
+    "E"   , "e"   , "O"   , "o"   , "O"   , "o"   , "O"   , "o",  // U+0228
+    "O"   , "o"   , "Y"   , "y"   , ""    , ""    , ""    , "",  // U+0230
+    ""    , ""    , "A"   , "C"   , "c"   , "L"   , "T"   , "",  // U+0238
+    ""    , ""    , ""    , "B"   , ""    , ""    , "E"   , "e",  // U+0240
+    "J"   , "j"   , ""    , ""    , "R"   , "r"   , "Y"   , "y",  // U+0248
+    };
+
+    /// single code point -> replacement
+    struct STranslit
     {
-        inlen = strlen(inbuf);
-        buflen = 0;
-        buf = NULL;
-        do {
-            outlen = inlen * 2;
-            buflen += outlen;
-            /* iconv() below changes the buf pointer:
-             * - decrement to point at beginning of buffer before realloc
-             * - re-increment to point at first free position after realloc
-             */
-            len = buflen - outlen;
-            buf = (char*)realloc(buf - len, buflen) + len;
-            if (buf == NULL) {
-                /* XXX: report out of memory error */
-                free(inbuf);
-                return ret;
+        uint32_t    mCp;
+        const char* mTo;
+    };
+
+    /// sparse transliterations (Greek, Cyrillic, punctuation), sorted by code point
+    constexpr STranslit SPARSE_TRANSLIT[] = {
+    { 0x0386, "A" },
+    { 0x0388, "E" },
+    { 0x0389, "I" },
+    { 0x038A, "I" },
+    { 0x038C, "O" },
+    { 0x038E, "Y" },
+    { 0x038F, "O" },
+    { 0x0391, "A" },
+    { 0x0392, "V" },
+    { 0x0393, "G" },
+    { 0x0394, "D" },
+    { 0x0395, "E" },
+    { 0x0396, "Z" },
+    { 0x0397, "I" },
+    { 0x0398, "Th" },
+    { 0x0399, "I" },
+    { 0x039A, "K" },
+    { 0x039B, "L" },
+    { 0x039C, "M" },
+    { 0x039D, "N" },
+    { 0x039E, "X" },
+    { 0x039F, "O" },
+    { 0x03A0, "P" },
+    { 0x03A1, "R" },
+    { 0x03A3, "S" },
+    { 0x03A4, "T" },
+    { 0x03A5, "Y" },
+    { 0x03A6, "F" },
+    { 0x03A7, "Ch" },
+    { 0x03A8, "Ps" },
+    { 0x03A9, "O" },
+    { 0x03AA, "I" },
+    { 0x03AB, "Y" },
+    { 0x03AC, "a" },
+    { 0x03AD, "e" },
+    { 0x03AE, "i" },
+    { 0x03AF, "i" },
+    { 0x03B1, "a" },
+    { 0x03B2, "v" },
+    { 0x03B3, "g" },
+    { 0x03B4, "d" },
+    { 0x03B5, "e" },
+    { 0x03B6, "z" },
+    { 0x03B7, "i" },
+    { 0x03B8, "th" },
+    { 0x03B9, "i" },
+    { 0x03BA, "k" },
+    { 0x03BB, "l" },
+    { 0x03BC, "m" },
+    { 0x03BD, "n" },
+    { 0x03BE, "x" },
+    { 0x03BF, "o" },
+    { 0x03C0, "p" },
+    { 0x03C1, "r" },
+    { 0x03C2, "s" },
+    { 0x03C3, "s" },
+    { 0x03C4, "t" },
+    { 0x03C5, "y" },
+    { 0x03C6, "f" },
+    { 0x03C7, "ch" },
+    { 0x03C8, "ps" },
+    { 0x03C9, "o" },
+    { 0x03CA, "i" },
+    { 0x03CB, "y" },
+    { 0x03CC, "o" },
+    { 0x03CD, "y" },
+    { 0x03CE, "o" },
+    { 0x0401, "Yo" },
+    { 0x0404, "Ye" },
+    { 0x0406, "I" },
+    { 0x0407, "Yi" },
+    { 0x040E, "U" },
+    { 0x0410, "A" },
+    { 0x0411, "B" },
+    { 0x0412, "V" },
+    { 0x0413, "G" },
+    { 0x0414, "D" },
+    { 0x0415, "E" },
+    { 0x0416, "Zh" },
+    { 0x0417, "Z" },
+    { 0x0418, "I" },
+    { 0x0419, "Y" },
+    { 0x041A, "K" },
+    { 0x041B, "L" },
+    { 0x041C, "M" },
+    { 0x041D, "N" },
+    { 0x041E, "O" },
+    { 0x041F, "P" },
+    { 0x0420, "R" },
+    { 0x0421, "S" },
+    { 0x0422, "T" },
+    { 0x0423, "U" },
+    { 0x0424, "F" },
+    { 0x0425, "Kh" },
+    { 0x0426, "Ts" },
+    { 0x0427, "Ch" },
+    { 0x0428, "Sh" },
+    { 0x0429, "Shch" },
+    { 0x042A, "" },
+    { 0x042B, "Y" },
+    { 0x042C, "" },
+    { 0x042D, "E" },
+    { 0x042E, "Yu" },
+    { 0x042F, "Ya" },
+    { 0x0430, "a" },
+    { 0x0431, "b" },
+    { 0x0432, "v" },
+    { 0x0433, "g" },
+    { 0x0434, "d" },
+    { 0x0435, "e" },
+    { 0x0436, "zh" },
+    { 0x0437, "z" },
+    { 0x0438, "i" },
+    { 0x0439, "y" },
+    { 0x043A, "k" },
+    { 0x043B, "l" },
+    { 0x043C, "m" },
+    { 0x043D, "n" },
+    { 0x043E, "o" },
+    { 0x043F, "p" },
+    { 0x0440, "r" },
+    { 0x0441, "s" },
+    { 0x0442, "t" },
+    { 0x0443, "u" },
+    { 0x0444, "f" },
+    { 0x0445, "kh" },
+    { 0x0446, "ts" },
+    { 0x0447, "ch" },
+    { 0x0448, "sh" },
+    { 0x0449, "shch" },
+    { 0x044A, "" },
+    { 0x044B, "y" },
+    { 0x044C, "" },
+    { 0x044D, "e" },
+    { 0x044E, "yu" },
+    { 0x044F, "ya" },
+    { 0x0451, "yo" },
+    { 0x0454, "ye" },
+    { 0x0456, "i" },
+    { 0x0457, "yi" },
+    { 0x045E, "u" },
+    { 0x0490, "G" },
+    { 0x0491, "g" },
+    { 0x2000, " " },
+    { 0x2001, " " },
+    { 0x2002, " " },
+    { 0x2003, " " },
+    { 0x2004, " " },
+    { 0x2005, " " },
+    { 0x2006, " " },
+    { 0x2007, " " },
+    { 0x2008, " " },
+    { 0x2009, " " },
+    { 0x200A, " " },
+    { 0x200B, "" },
+    { 0x200C, "" },
+    { 0x200D, "" },
+    { 0x2010, "-" },
+    { 0x2011, "-" },
+    { 0x2012, "-" },
+    { 0x2013, "-" },
+    { 0x2014, "-" },
+    { 0x2015, "-" },
+    { 0x2018, "'" },
+    { 0x2019, "'" },
+    { 0x201A, "," },
+    { 0x201B, "'" },
+    { 0x201C, "\"" },
+    { 0x201D, "\"" },
+    { 0x201E, "\"" },
+    { 0x201F, "\"" },
+    { 0x2020, "+" },
+    { 0x2022, "*" },
+    { 0x2026, "..." },
+    { 0x202F, " " },
+    { 0x2030, "%o" },
+    { 0x2032, "'" },
+    { 0x2033, "\"" },
+    { 0x2039, "<" },
+    { 0x203A, ">" },
+    { 0x2044, "/" },
+    { 0x205F, " " },
+    { 0x20AC, "EUR" },
+    { 0x2116, "No" },
+    { 0x2122, "TM" },
+    { 0x2190, "<-" },
+    { 0x2192, "->" },
+    { 0x2212, "-" },
+    { 0x221E, "inf" },
+    { 0x2605, "*" },
+    { 0x2606, "*" },
+    { 0x266A, "" },
+    { 0x266B, "" },
+    { 0x3000, " " },
+    { 0x3001, "," },
+    { 0x3002, "." },
+    { 0x300C, "\"" },
+    { 0x300D, "\"" },
+    { 0xFEFF, "" },
+    };
+
+    //--------------------------------------------------------------------------
+    //! @brief      check table order at compile time (needed for binary search)
+    //--------------------------------------------------------------------------
+    template <size_t N>
+    constexpr bool sortedTable(const STranslit (&tbl)[N])
+    {
+        for (size_t i = 1; i < N; i++)
+        {
+            if (tbl[i - 1].mCp >= tbl[i].mCp)
+            {
+                return false;
             }
-            rc = iconv(cd, &inPtr, &inlen, &buf, &outlen);
-            if ((rc == -1) && (errno != E2BIG)) {
-                free(buf);
-                free(inbuf);
-                fprintf(stderr, "Error in character encoding!\n");
-                fflush(stderr);
-                return ret;       /* conversion failed */
+        }
+        return true;
+    }
+
+    static_assert(sortedTable(SPARSE_TRANSLIT), "SPARSE_TRANSLIT must be sorted");
+
+    /// katakana U+30A1 ... U+30FE -> half-width katakana (JIS X0201);
+    /// voiced kana get a separate (han)dakuten, rare kana map to the next one
+    constexpr uint32_t KATA_FIRST = 0x30A1;
+    constexpr uint32_t KATA_LAST  = 0x30FE;
+
+    constexpr const char* KATA_HALFWIDTH[KATA_LAST - KATA_FIRST + 1] = {
+    "\xA7"    , "\xB1"    , "\xA8"    , "\xB2"    , "\xA9"    , "\xB3"    , "\xAA"    , "\xB4",  // U+30A1
+    "\xAB"    , "\xB5"    , "\xB6"    , "\xB6\xDE", "\xB7"    , "\xB7\xDE", "\xB8"    , "\xB8\xDE",  // U+30A9
+    "\xB9"    , "\xB9\xDE", "\xBA"    , "\xBA\xDE", "\xBB"    , "\xBB\xDE", "\xBC"    , "\xBC\xDE",  // U+30B1
+    "\xBD"    , "\xBD\xDE", "\xBE"    , "\xBE\xDE", "\xBF"    , "\xBF\xDE", "\xC0"    , "\xC0\xDE",  // U+30B9
+    "\xC1"    , "\xC1\xDE", "\xAF"    , "\xC2"    , "\xC2\xDE", "\xC3"    , "\xC3\xDE", "\xC4",  // U+30C1
+    "\xC4\xDE", "\xC5"    , "\xC6"    , "\xC7"    , "\xC8"    , "\xC9"    , "\xCA"    , "\xCA\xDE",  // U+30C9
+    "\xCA\xDF", "\xCB"    , "\xCB\xDE", "\xCB\xDF", "\xCC"    , "\xCC\xDE", "\xCC\xDF", "\xCD",  // U+30D1
+    "\xCD\xDE", "\xCD\xDF", "\xCE"    , "\xCE\xDE", "\xCE\xDF", "\xCF"    , "\xD0"    , "\xD1",  // U+30D9
+    "\xD2"    , "\xD3"    , "\xAC"    , "\xD4"    , "\xAD"    , "\xD5"    , "\xAE"    , "\xD6",  // U+30E1
+    "\xD7"    , "\xD8"    , "\xD9"    , "\xDA"    , "\xDB"    , "\xDC"    , "\xDC"    , "\xB2",  // U+30E9
+    "\xB4"    , "\xA6"    , "\xDD"    , "\xB3\xDE", "\xB6"    , "\xB9"    , "\xDC\xDE", "\xB2\xDE",  // U+30F1
+    "\xB4\xDE", "\xA6\xDE", "\xA5"    , "\xB0"    , ""        , "",  // U+30F9
+    };
+
+    /// offset hiragana -> katakana
+    constexpr uint32_t HIRA_TO_KATA = 0x60;
+
+    //--------------------------------------------------------------------------
+    //! @brief      check for kana (hiragana, katakana, prolonged sound mark)
+    //--------------------------------------------------------------------------
+    constexpr bool isKana(uint32_t cp)
+    {
+        return ((cp >= 0x3041) && (cp <= 0x3096))
+            || ((cp >= 0x30A1) && (cp <= 0x30FC))
+            || ((cp >= 0xFF66) && (cp <= 0xFF9F));
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      check for kanji (CJK ideographs, iteration mark)
+    //--------------------------------------------------------------------------
+    constexpr bool isKanji(uint32_t cp)
+    {
+        return ((cp >= 0x4E00) && (cp <= 0x9FFF))
+            || ((cp >= 0x3400) && (cp <= 0x4DBF))
+            || ((cp >= 0xF900) && (cp <= 0xFAFF))
+            || (cp == 0x3005);
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      append japanese character as half-width katakana
+    //!
+    //! @param[in]  cp    code point
+    //! @param      out   output string
+    //!
+    //! @return     true if handled
+    //--------------------------------------------------------------------------
+    bool kanaToMd(uint32_t cp, std::string& out)
+    {
+        if ((cp >= 0x3041) && (cp <= 0x3096))
+        {
+            cp += HIRA_TO_KATA;
+        }
+
+        if ((cp >= KATA_FIRST) && (cp <= KATA_LAST))
+        {
+            out += KATA_HALFWIDTH[cp - KATA_FIRST];
+            return true;
+        }
+
+        if ((cp >= 0xFF61) && (cp <= 0xFF9F))
+        {
+            out += static_cast<char>(cp - 0xFF61 + 0xA1);
+            return true;
+        }
+
+        switch (cp)
+        {
+        case 0x3000: out += ' ';    return true;  // ideographic space
+        case 0x3001: out += '\xA4'; return true;  // ideographic comma
+        case 0x3002: out += '\xA1'; return true;  // ideographic full stop
+        case 0x300C: out += '\xA2'; return true;  // corner brackets
+        case 0x300D: out += '\xA3'; return true;
+        case 0x309B: out += '\xDE'; return true;  // (han)dakuten
+        case 0x309C: out += '\xDF'; return true;
+        default:                    return false;
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      decode one code point; invalid sequences give the
+    //!             first byte as ISO-8859-1 character
+    //!
+    //! @param[in]  in    input string
+    //! @param      pos   position; set behind the decoded sequence
+    //!
+    //! @return     code point
+    //--------------------------------------------------------------------------
+    uint32_t nextCodePoint(std::string_view in, size_t& pos)
+    {
+        uint8_t  c   = static_cast<uint8_t>(in[pos++]);
+        uint32_t cp  = c;
+        size_t   len = 0;
+
+        if (c < 0x80)
+        {
+            return cp;
+        }
+        else if ((c & 0xE0) == 0xC0)
+        {
+            cp  = c & 0x1F;
+            len = 1;
+        }
+        else if ((c & 0xF0) == 0xE0)
+        {
+            cp  = c & 0x0F;
+            len = 2;
+        }
+        else if ((c & 0xF8) == 0xF0)
+        {
+            cp  = c & 0x07;
+            len = 3;
+        }
+        else
+        {
+            return c;
+        }
+
+        if ((pos + len) > in.size())
+        {
+            return c;
+        }
+
+        for (size_t i = 0; i < len; i++)
+        {
+            uint8_t cc = static_cast<uint8_t>(in[pos + i]);
+            if ((cc & 0xC0) != 0x80)
+            {
+                return c;
             }
-        } while (inlen != 0);
-        len = buflen - outlen;
-        buf -= len;                 /* reposition at begin of buffer */
-        
-        /* make a copy just big enough for the result */
-        char *o = new char[len + 1]; 
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+
+        pos += len;
+        return cp;
+    }
+
+    //--------------------------------------------------------------------------
+    //! @brief      kanji can't be shown on MD; a reading in brackets right
+    //!             behind them, e.g. "漢字(かんじ)", is used instead
+    //!
+    //! @param[in]  in    input string
+    //! @param[in]  pos   position behind the first kanji
+    //! @param      out   output string (nullptr -> reading is skipped as well)
+    //!
+    //! @return     position to continue with
+    //--------------------------------------------------------------------------
+    size_t kanjiReading(std::string_view in, size_t pos, std::string* out)
+    {
+        size_t   next = pos;
+        uint32_t cp   = 0;
 
-        if (o != nullptr)
+        // skip the kanji run
+        while ((pos = next) < in.size())
         {
-            memcpy(o, buf, len);
-            o[len] = '\0';
-            ret = o;
-            delete [] o;
+            if (!isKanji(cp = nextCodePoint(in, next)))
+            {
+                break;
+            }
+        }
+
+        if ((pos >= in.size()) || ((cp != '(') && (cp != 0xFF08)))
+        {
+            return pos;
+        }
+
+        // reading must be kana only
+        size_t start = next, end = next;
+        bool   ok    = false;
 
-            free(inbuf);
+        while (end < in.size())
+        {
+            size_t here = end;
+            cp = nextCodePoint(in, end);
 
-            return ret;
+            if ((cp == ')') || (cp == 0xFF09))
+            {
+                ok = here > start;
+                break;
+            }
+            else if (!isKana(cp) && (cp != ' ') && (cp != 0x3000))
+            {
+                break;
+            }
+        }
+
+        if (!ok)
+        {
+            return pos;
         }
 
-        free(inbuf);
+        while (out && (start < end))
+        {
+            cp = nextCodePoint(in, start);
+            if ((cp != ')') && (cp != 0xFF09))
+            {
+                kanaToMd(cp, *out);
+            }
+        }
+
+        return end;
     }
-    
-    return ret;
 }
 
 //------------------------------------------------------------------------------
-//! @brief      replace umlaut with ae, ue, oe, ss
+//! @brief      transliterate an UTF-8 string to the MD title charset in one
+//!             pass (table driven; bytes which aren't valid UTF-8 are taken
+//!             as ISO-8859-1)
 //!
-//! @param[in]  in    string to parse
+//! @param[in]  in    UTF-8 string
+//! @param[in]  cs    target charset
 //!
-//! @return     parsed string
+//! @return     MD title string
 //------------------------------------------------------------------------------
-std::string deUmlaut(const std::string& in)
+std::string toMdTitle(std::string_view in, MdCharset cs)
 {
-    std::string ret = in;
-    std::vector<std::string> search, replace;
+    std::string out;
+    size_t      pos = 0;
+
+    // replacements are rarely longer than the UTF-8 sequence
+    out.reserve(in.size());
+
+    while (pos < in.size())
+    {
+        uint32_t cp = nextCodePoint(in, pos);
+
+        if (cp < 0x80)
+        {
+            if ((cp >= 0x20) && (cp < 0x7F))
+            {
+                out += static_cast<char>(cp);
+            }
+            else if (cp == '\t')
+            {
+                out += ' ';
+            }
+        }
+        else if ((cp >= LATIN_FIRST) && (cp <= LATIN_LAST))
+        {
+            out += LATIN_TRANSLIT[cp - LATIN_FIRST];
+        }
+        else if ((cp >= 0xFF01) && (cp <= 0xFF5E))
+        {
+            // full-width ASCII
+            out += static_cast<char>(cp - 0xFEE0);
+        }
+        else if (isKanji(cp))
+        {
+            // ASCII has no kana -> the reading goes with the kanji
+            pos = kanjiReading(in, pos, (cs == MdCharset::KANA) ? &out : nullptr);
+        }
+        else if ((cs == MdCharset::KANA) && kanaToMd(cp, out))
+        {
+            // kana -> half-width katakana
+        }
+        else
+        {
+            auto it = std::lower_bound(std::begin(SPARSE_TRANSLIT), std::end(SPARSE_TRANSLIT), cp,
+                [](const STranslit& t, uint32_t c){ return t.mCp < c; });
 
-    search  = {"Ä" , "ä" , "Ö" , "ö" , "Ü" , "ü" , "ß"  };
-    replace = {"Ae", "ae", "Oe", "oe", "Ue", "ue", "ss" };
+            if ((it != std::end(SPARSE_TRANSLIT)) && (it->mCp == cp))
+            {
+                out += it->mTo;
+            }
+        }
+    }
 
-    size_t pos;
+    return out;
+}
 
-    for (size_t i = 0; i < search.size(); i++)
+//------------------------------------------------------------------------------
+//! @brief      check if titles contain japanese text (kana / kanji)
+//!
+//! @param[in]  titles  UTF-8 titles of a disc
+//!
+//! @return     KANA for japanese titles; ASCII otherwise
+//------------------------------------------------------------------------------
+MdCharset pickMdCharset(const std::vector<std::string>& titles)
+{
+    for (const auto& t : titles)
     {
-        while ((pos = ret.find(search[i], pos + 2)) != std::string::npos)
+        size_t pos = 0;
+
+        while (pos < t.size())
         {
-            ret.replace(pos, 2, replace[i]);
+            // ASCII fast path
+            if (static_cast<uint8_t>(t[pos]) < 0x80)
+            {
+                pos++;
+                continue;
+            }
+
+            uint32_t cp = nextCodePoint(t, pos);
+
+            if (isKana(cp) || isKanji(cp))
+            {
+                return MdCharset::KANA;
+            }
         }
     }
 
-    return ret;
+    return MdCharset::ASCII;
+}
+
+//------------------------------------------------------------------------------
+//! @brief      transliterate all titles of a disc; AUTO picks one charset
+//!             for the whole disc
+//!
+//! @param      titles  UTF-8 titles in, MD titles out
+//! @param[in]  cs      target charset
+//------------------------------------------------------------------------------
+void toMdTitles(std::vector<std::string>& titles, MdCharset cs)
+{
+    if (cs == MdCharset::AUTO)
+    {
+        cs = pickMdCharset(titles);
+    }
+
+    for (auto& t : titles)
+    {
+        t = toMdTitle(t, cs);
+    }
 }
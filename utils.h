@@ -15,28 +15,44 @@
  * You should have received a copy of the GNU General Public License
  */
 #pragma once
-#include <iconv.h>
-#include <cstdlib>
 #include <string>
-#include <cstring>
-#include <unistd.h>
+#include <string_view>
+#include <vector>
+
+/// character set used for MD titles
+enum class MdCharset
+{
+    ASCII,  ///< printable ASCII only
+    KANA,   ///< ASCII + half-width katakana (JIS X0201, 0xA1 - 0xDF)
+    AUTO,   ///< KANA for japanese discs, else ASCII (see toMdTitles())
+};
 
 //------------------------------------------------------------------------------
-//! @brief      convert string
+//! @brief      transliterate an UTF-8 string to the MD title charset in one
+//!             pass (table driven; bytes which aren't valid UTF-8 are taken
+//!             as ISO-8859-1); AUTO is handled like ASCII here
 //!
-//! @param[in]  cd    conversion enum
-//! @param[in]  in    string to convert
-//! @param      out   converted string
+//! @param[in]  in    UTF-8 string
+//! @param[in]  cs    target charset
 //!
-//! @return     converted string on success; unconverted in error case
+//! @return     MD title string
 //------------------------------------------------------------------------------
-std::string cddb_str_iconv(iconv_t cd, const char *in);
+std::string toMdTitle(std::string_view in, MdCharset cs = MdCharset::ASCII);
 
 //------------------------------------------------------------------------------
-//! @brief      replace umlaut with ae, ue, oe, ss
+//! @brief      check if titles contain japanese text (kana / kanji)
+//!
+//! @param[in]  titles  UTF-8 titles of a disc
 //!
-//! @param[in]  in    string to parse
+//! @return     KANA for japanese titles; ASCII otherwise
+//------------------------------------------------------------------------------
+MdCharset pickMdCharset(const std::vector<std::string>& titles);
+
+//------------------------------------------------------------------------------
+//! @brief      transliterate all titles of a disc; AUTO picks one charset
+//!             for the whole disc
 //!
-//! @return     parsed string
+//! @param      titles  UTF-8 titles in, MD titles out
+//! @param[in]  cs      target charset
 //------------------------------------------------------------------------------
-std::string deUmlaut(const std::string& in);
+void toMdTitles(std::vector<std::string>& titles, MdCharset cs);